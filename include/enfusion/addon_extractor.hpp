@@ -7,16 +7,26 @@
  * - RDB (resource database) for file paths and sizes
  * - Manifest JSON for fragment offsets
  * - PAK file for actual data
+ *
+ * Loading is phased: open() only parses the RDB so the file list is
+ * available immediately; the PAK, manifest and fragment location index
+ * are built on the first read_file() or in the background.
  */
 
 #include "enfusion/types.hpp"
+#include "enfusion/result.hpp"
+#include "enfusion/memory.hpp"
+#include "enfusion/task_scheduler.hpp"
 #include <string>
 #include <vector>
 #include <filesystem>
 #include <functional>
 #include <map>
+#include <unordered_map>
 #include <optional>
 #include <tuple>
+#include <mutex>
+#include <atomic>
 
 namespace enfusion {
 
@@ -48,27 +58,64 @@ public:
     ~AddonExtractor();
 
     /**
-     * Load an addon directory.
+     * Load an addon directory, including the fragment index.
      * @param addon_dir Path to addon folder containing data.pak
-     * @return true if loaded successfully
+     * @return Success, or the reason the addon could not be opened
      */
-    bool load(const std::filesystem::path& addon_dir);
+    Result<void> load(const std::filesystem::path& addon_dir);
 
     /**
-     * Check if addon is loaded
+     * Open an addon for listing only: locates the files and parses the RDB.
+     * The fragment index is built lazily by read_file() or index_async().
+     */
+    Result<void> open(const std::filesystem::path& addon_dir);
+
+    /**
+     * Build the fragment index now (blocking). Safe to call repeatedly
+     * and from several threads; only the first call does the work.
+     */
+    Result<void> ensure_indexed();
+
+    /**
+     * Start building the fragment index as a prefetch task.
+     */
+    void index_async();
+
+    /**
+     * Check if addon is loaded (file list available)
      */
     bool is_loaded() const { return loaded_; }
 
+    /**
+     * Check if indexing has finished (successfully or not)
+     */
+    bool is_indexed() const { return indexed_; }
+
     /**
      * Get list of files in the addon
      */
     std::vector<RdbFile> list_files() const;
+    const std::vector<RdbFile>& files() const { return files_; }
+
+    /**
+     * Look up a file by path (case- and separator-insensitive).
+     * Only needs open(); the PAK is not touched.
+     */
+    const RdbFile* find_file(const std::string& path) const;
+    bool contains(const std::string& path) const { return find_file(path) != nullptr; }
 
     /**
      * Read a file from the addon (decompressed)
      */
-    std::vector<uint8_t> read_file(const RdbFile& file);
-    std::vector<uint8_t> read_file(const std::string& path);
+    Result<std::vector<uint8_t>> read_file(const RdbFile& file);
+    Result<std::vector<uint8_t>> read_file(const std::string& path);
+
+    /**
+     * Identity of a file's contents without reading it: the sha512 the
+     * manifest lists for the fragment read_file() would return, or empty if
+     * the file isn't found or the manifest has no hash. Builds the index.
+     */
+    std::string content_key(const std::string& path);
 
     /**
      * Extract a single file to disk
@@ -76,7 +123,8 @@ public:
     bool extract_file(const RdbFile& file, const std::filesystem::path& output_path);
 
     /**
-     * Extract all files
+     * Extract all files. Files are written by the shared workers as a bulk
+     * job; the callback is serialized and returning false stops the export.
      */
     bool extract_all(const std::filesystem::path& output_dir,
                      std::function<bool(const std::string&, size_t, size_t)> callback = nullptr);
@@ -86,12 +134,27 @@ public:
      */
     const std::filesystem::path& addon_dir() const { return addon_dir_; }
 
+    /**
+     * Bytes of PAK data held in memory (0 until indexed)
+     */
+    size_t resident_bytes() const { return pak_account_.bytes(); }
+
 private:
+    Result<void> locate_files(const std::filesystem::path& addon_dir);
+    Result<void> build_index();
     bool parse_rdb();
     bool load_manifest();
     void build_decompressed_index();
     void index_special_fragments();
-    std::optional<std::tuple<uint64_t, uint32_t, bool>> find_file_location(uint32_t file_size, const std::string& path);
+    struct FileLocation {
+        int fragment = 0;
+        uint64_t offset = 0;
+        uint32_t size = 0;
+        bool compressed = false;
+    };
+
+    std::optional<FileLocation> find_file_location(uint32_t file_size, const std::string& path);
+    void update_accounts();
 
     std::filesystem::path addon_dir_;
     std::filesystem::path pak_path_;
@@ -100,6 +163,7 @@ private:
 
     std::vector<uint8_t> pak_data_;
     std::vector<RdbFile> files_;
+    std::unordered_map<std::string, size_t> path_index_;  // normalized path -> files_ index
     std::vector<ManifestFragment> fragments_;
 
     std::map<uint32_t, std::vector<int>> size_to_fragments_;
@@ -110,6 +174,17 @@ private:
     std::vector<int> prefab_fragments_;
 
     bool loaded_ = false;
+
+    // Deferred indexing state
+    std::once_flag index_once_;
+    std::optional<Error> index_error_;
+    std::atomic<bool> indexed_{false};
+    std::atomic<bool> cancel_index_{false};
+    Task<void> index_future_;
+
+    // The whole PAK lives in pak_data_ once indexed, so addons are the bulk of RSS
+    memory::Account pak_account_{memory::Subsystem::PakData, "addon"};
+    memory::Account list_account_{memory::Subsystem::FileLists, "addon"};
 };
 
 } // namespace enfusion
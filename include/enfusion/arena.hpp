@@ -0,0 +1,108 @@
+/**
+ * Enfusion Unpacker - Scratch arena for decode pipelines
+ *
+ * Each thread owns a monotonic arena that decoders (XOB, EDDS, LZ4/zlib)
+ * allocate their temporaries from. Memory is released in one go when the
+ * outermost ArenaScope on that thread ends, so decoding asset after asset
+ * reuses the same block instead of hitting the heap for every buffer.
+ */
+
+#pragma once
+
+#include <memory_resource>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace enfusion {
+
+/**
+ * Per-thread monotonic arena.
+ *
+ * The backing block grows to the high-water mark of the largest asset seen
+ * so far, so steady-state decoding does no heap allocation at all.
+ */
+class ScratchArena {
+public:
+    /** Arena belonging to the calling thread. */
+    static ScratchArena& current();
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+    ~ScratchArena();
+
+    std::pmr::memory_resource* resource() { return &*monotonic_; }
+
+    /**
+     * Release everything allocated since the last reset.
+     * Anything still pointing into the arena is invalidated.
+     */
+    void reset();
+
+    size_t capacity() const { return capacity_; }
+    size_t overflow_bytes() const { return upstream_.allocated(); }
+
+private:
+    friend class ArenaScope;
+
+    /** Upstream that counts how much spilled past the backing block. */
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        size_t allocated() const { return allocated_; }
+        void clear() { allocated_ = 0; }
+
+    private:
+        void* do_allocate(size_t bytes, size_t align) override;
+        void do_deallocate(void* p, size_t bytes, size_t align) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        size_t allocated_ = 0;
+    };
+
+    ScratchArena();
+    void rebuild();
+
+    static constexpr size_t INITIAL_CAPACITY = 4 * 1024 * 1024;
+    static constexpr size_t MAX_CAPACITY = 256 * 1024 * 1024;
+
+    std::unique_ptr<std::byte[]> buffer_;
+    size_t capacity_ = 0;
+    CountingResource upstream_;
+    std::optional<std::pmr::monotonic_buffer_resource> monotonic_;
+    int scope_depth_ = 0;
+};
+
+/**
+ * Marks the lifetime of one asset's decode on this thread.
+ * Scopes nest; the arena is reset when the outermost one ends.
+ */
+class ArenaScope {
+public:
+    ArenaScope() : arena_(ScratchArena::current()) { ++arena_.scope_depth_; }
+    ~ArenaScope() {
+        if (--arena_.scope_depth_ == 0) arena_.reset();
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    std::pmr::memory_resource* resource() { return arena_.resource(); }
+
+private:
+    ScratchArena& arena_;
+};
+
+/**
+ * Resource for decode temporaries on the calling thread.
+ */
+inline std::pmr::memory_resource* scratch_resource() {
+    return ScratchArena::current().resource();
+}
+
+using ScratchBuffer = std::pmr::vector<uint8_t>;
+
+} // namespace enfusion
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include "result.hpp"
 #include <vector>
+#include <memory_resource>
 #include <cstdint>
 #include <cstddef>
 
@@ -26,31 +28,43 @@ CompressionType detect_compression(const uint8_t* data, size_t size);
 
 /**
  * Auto decompress based on type.
+ * None of the (de)compression functions throw; failures come back as
+ * Error::Code::CompressionError so probing corrupt data stays cheap.
  */
-std::vector<uint8_t> decompress_auto(const uint8_t* data, size_t size, size_t expected_size, CompressionType type);
+Result<std::vector<uint8_t>> decompress_auto(const uint8_t* data, size_t size, size_t expected_size, CompressionType type);
 
 /**
  * Decompress zlib data.
  */
-std::vector<uint8_t> decompress_zlib(const uint8_t* data, size_t size, size_t expected_size);
-std::vector<uint8_t> decompress_zlib(const std::vector<uint8_t>& data, size_t expected_size);
+Result<std::vector<uint8_t>> decompress_zlib(const uint8_t* data, size_t size, size_t expected_size);
+Result<std::vector<uint8_t>> decompress_zlib(const std::vector<uint8_t>& data, size_t expected_size);
+Result<std::pmr::vector<uint8_t>> decompress_zlib(const uint8_t* data, size_t size, size_t expected_size,
+                                                  std::pmr::memory_resource* resource);
+
+/**
+ * Inflate zlib data without keeping the output, returning its decompressed size.
+ * Fails if the stream is corrupt or would exceed max_size.
+ */
+Result<size_t> measure_zlib(const uint8_t* data, size_t size, size_t max_size);
 
 /**
  * Decompress LZ4 data.
  */
-std::vector<uint8_t> decompress_lz4(const uint8_t* data, size_t size, size_t expected_size);
-std::vector<uint8_t> decompress_lz4(const std::vector<uint8_t>& data, size_t expected_size);
+Result<std::vector<uint8_t>> decompress_lz4(const uint8_t* data, size_t size, size_t expected_size);
+Result<std::vector<uint8_t>> decompress_lz4(const std::vector<uint8_t>& data, size_t expected_size);
+Result<std::pmr::vector<uint8_t>> decompress_lz4(const uint8_t* data, size_t size, size_t expected_size,
+                                                 std::pmr::memory_resource* resource);
 
 /**
  * Compress data with zlib.
  */
-std::vector<uint8_t> compress_zlib(const uint8_t* data, size_t size, int level = 6);
-std::vector<uint8_t> compress_zlib(const std::vector<uint8_t>& data, int level = 6);
+Result<std::vector<uint8_t>> compress_zlib(const uint8_t* data, size_t size, int level = 6);
+Result<std::vector<uint8_t>> compress_zlib(const std::vector<uint8_t>& data, int level = 6);
 
 /**
  * Compress data with LZ4.
  */
-std::vector<uint8_t> compress_lz4(const uint8_t* data, size_t size);
-std::vector<uint8_t> compress_lz4(const std::vector<uint8_t>& data);
+Result<std::vector<uint8_t>> compress_lz4(const uint8_t* data, size_t size);
+Result<std::vector<uint8_t>> compress_lz4(const std::vector<uint8_t>& data);
 
 } // namespace enfusion
@@ -0,0 +1,109 @@
+/**
+ * Enfusion Unpacker - Content Search
+ *
+ * Full-text search over script and config assets inside addons. Files are
+ * decompressed in memory by a pool of workers and matched without ever
+ * touching disk; hits are streamed back while the search is still running.
+ */
+
+#pragma once
+
+#include "enfusion/result.hpp"
+#include "enfusion/task_scheduler.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace enfusion {
+
+class AddonExtractor;
+struct RdbFile;
+
+struct ContentSearchOptions {
+    std::string pattern;
+    bool regex = false;
+    bool case_sensitive = false;
+    std::vector<std::string> extensions = {".c", ".et", ".conf", ".layout", ".meta"};
+    size_t max_hits = 50000;
+    unsigned int threads = 0;  // 0 = one per scheduler worker
+};
+
+struct ContentSearchHit {
+    std::filesystem::path addon_dir;
+    std::string path;      // Virtual path inside the addon
+    uint32_t line = 0;     // 1-based
+    uint32_t column = 0;   // Byte offset of the match within the line
+    std::string text;      // The matching line, clipped for display
+};
+
+/**
+ * One search over a set of addons.
+ *
+ * Addons are opened one ahead of the one being scanned, so reading the
+ * next PAK overlaps with searching the current one. Each line is reported
+ * at most once, at its first match.
+ */
+class ContentSearch {
+public:
+    ContentSearch() = default;
+    ~ContentSearch();
+
+    ContentSearch(const ContentSearch&) = delete;
+    ContentSearch& operator=(const ContentSearch&) = delete;
+
+    /** Addon folders (those with a resourceDatabase.rdb) below a root. */
+    static std::vector<std::filesystem::path> find_addons(const std::filesystem::path& root);
+
+    /**
+     * Start searching in the background. Any previous search is cancelled.
+     * Fails up front for an empty pattern or an invalid regex.
+     */
+    Result<void> start(std::vector<std::filesystem::path> addon_dirs, ContentSearchOptions options);
+    void cancel();
+
+    bool is_running() const;
+
+    /** Hits found since the last call. */
+    std::vector<ContentSearchHit> take_hits();
+
+    size_t addons_done() const { return addons_done_.load(); }
+    size_t addons_total() const { return addon_dirs_.size(); }
+    size_t files_searched() const { return files_searched_.load(); }
+    size_t hit_count() const { return hit_count_.load(); }
+    bool truncated() const { return truncated_.load(); }
+
+private:
+    static constexpr size_t MAX_LINE_CONTEXT = 200;
+
+    // The next addon is only loaded ahead while both PAKs together fit in this
+    static constexpr uint64_t PREFETCH_PAK_LIMIT = 1ull << 30;
+
+    void run();
+    void search_addon(AddonExtractor& extractor);
+    void search_file(const std::filesystem::path& addon_dir, const RdbFile& file,
+                     const std::vector<uint8_t>& data, std::string& scratch);
+    void add_hit(ContentSearchHit hit);
+    bool wants_file(const std::string& path) const;
+
+    std::vector<std::filesystem::path> addon_dirs_;
+    ContentSearchOptions options_;
+    std::string needle_;  // Lowercased unless the search is case sensitive
+    std::regex regex_;
+
+    Task<void> worker_;
+    std::atomic<bool> cancel_{false};
+    std::atomic<size_t> addons_done_{0};
+    std::atomic<size_t> files_searched_{0};
+    std::atomic<size_t> hit_count_{0};
+    std::atomic<bool> truncated_{false};
+
+    std::mutex hits_mutex_;
+    std::vector<ContentSearchHit> pending_hits_;
+};
+
+} // namespace enfusion
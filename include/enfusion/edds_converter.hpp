@@ -6,6 +6,7 @@
 
 #include "types.hpp"
 #include <vector>
+#include <memory_resource>
 #include <span>
 #include <cstdint>
 #include <array>
@@ -24,6 +25,12 @@ public:
 
     bool is_edds() const;
     std::vector<uint8_t> convert();
+
+    /**
+     * Convert into memory owned by the given resource (usually the thread's
+     * scratch arena), avoiding a heap copy when the DDS is only decoded.
+     */
+    std::pmr::vector<uint8_t> convert(std::pmr::memory_resource* resource);
     bool convert_to_dds(const fs::path& input, std::vector<uint8_t>& output);
     bool convert_file(const fs::path& input, const fs::path& output);
 
@@ -34,6 +41,7 @@ public:
 
 private:
     void parse_header();
+    size_t decode_mips(std::pmr::vector<std::pmr::vector<uint8_t>>& mip_data);
     std::vector<std::pair<uint32_t, uint32_t>> parse_mip_table(size_t data_offset);
     size_t calc_mip_size(uint32_t mip_level) const;
     static std::string get_format_name(uint32_t format);
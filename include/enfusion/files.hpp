@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <span>
 #include <cstdint>
 
 namespace enfusion {
@@ -18,6 +20,52 @@ namespace fs = std::filesystem;
  */
 std::vector<uint8_t> read_file(const std::filesystem::path& path);
 
+/**
+ * Read entire file in chunks, checking `cancel` between them. Returns
+ * empty if cancelled part way, so a large read can be abandoned quickly.
+ */
+std::vector<uint8_t> read_file(const std::filesystem::path& path, const std::atomic<bool>& cancel);
+
+/**
+ * Read-only memory mapping of a whole file. Pages are read on first touch,
+ * so opening is cheap regardless of size. Move-only; unmaps on destruction.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Map `path`. Returns false (and stays closed) if the file is missing,
+     * empty or cannot be mapped.
+     */
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    /**
+     * Hint that the whole mapping is about to be read, so the OS can start
+     * paging it in ahead of the first access.
+     */
+    void will_need() const;
+
+    bool is_open() const { return data_ != nullptr; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::span<const uint8_t> bytes() const { return {data_, size_}; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#endif
+};
+
 /**
  * Write data to file.
  */
@@ -0,0 +1,32 @@
+/**
+ * Enfusion Unpacker - Image I/O
+ *
+ * PNG encoding and decoding of RGBA images (TextureData with 4 channels),
+ * for thumbnails and contact sheets.
+ */
+
+#pragma once
+
+#include "enfusion/types.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace enfusion {
+
+/**
+ * Encode an RGBA image as PNG. Empty on failure.
+ */
+std::vector<uint8_t> encode_png(const TextureData& image);
+
+/**
+ * Decode a PNG (any channel count) into an RGBA image.
+ */
+std::optional<TextureData> decode_png(std::span<const uint8_t> data);
+
+bool write_png(const std::filesystem::path& path, const TextureData& image);
+std::optional<TextureData> read_png(const std::filesystem::path& path);
+
+} // namespace enfusion
@@ -1,8 +1,9 @@
 /**
  * Enfusion Unpacker - Logging System
- * 
+ *
  * Provides structured logging with configurable levels.
- * Thread-safe, supports file and console output.
+ * Callers only format their message; timestamps, file and console output
+ * happen in batches on a background thread fed by a lock-free queue.
  */
 
 #pragma once
@@ -10,15 +11,21 @@
 #include <string>
 #include <string_view>
 #include <fstream>
-#include <iostream>
 #include <mutex>
 #include <atomic>
 #include <sstream>
 #include <chrono>
-#include <ctime>
-#include <iomanip>
 #include <filesystem>
 #include <functional>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <ctime>
+
+// Levels below this are compiled out of the LOG_* macros (0 = Debug ... 4 = None)
+#ifndef ENFUSION_LOG_MIN_LEVEL
+#define ENFUSION_LOG_MIN_LEVEL 0
+#endif
 
 namespace enfusion {
 
@@ -46,242 +53,220 @@ constexpr const char* log_level_string(LogLevel level) {
     }
 }
 
+/**
+ * One queued message, formatted into a line on the logging thread
+ */
+struct LogRecord {
+    LogLevel level = LogLevel::Info;
+    std::chrono::system_clock::time_point time;
+    std::string tag;      // Empty for raw lines forwarded from std::cerr
+    std::string message;
+};
+
+/**
+ * Bounded lock-free queue, many producers and one consumer.
+ * Every slot carries a sequence number: producers claim a slot with a single
+ * CAS on the tail and publish it by bumping the sequence, so a slow consumer
+ * never blocks them. A full queue rejects the push instead of waiting.
+ */
+class LogRing {
+public:
+    explicit LogRing(size_t capacity);  // Rounded up to a power of two
+
+    bool push(LogRecord&& record);
+    bool pop(LogRecord& out);           // Consumer thread only
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        LogRecord record;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_ = 0;
+};
+
 /**
  * Thread-safe logger with level filtering
  */
 class Logger {
 public:
+    using Callback = std::function<void(LogLevel, const std::string&)>;
+
     static Logger& instance() {
         static Logger instance;
         return instance;
     }
-    
+
     // Non-copyable
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
-    
+
     /**
      * Set minimum log level (messages below this level are ignored)
      */
     void set_level(LogLevel level) {
-        std::lock_guard<std::mutex> lock(mutex_);
         min_level_.store(level, std::memory_order_release);
     }
-    
+
     LogLevel get_level() const {
         return min_level_.load(std::memory_order_acquire);
     }
-    
+
     /**
      * Check if a log level is enabled (for macro optimization)
      * Thread-safe without locking for performance
      */
     bool is_enabled(LogLevel level) const {
-        return level >= min_level_.load(std::memory_order_acquire);
+        return level >= min_level_.load(std::memory_order_relaxed);
     }
-    
+
     /**
-     * Enable/disable console output
+     * Enable/disable console output (stdout)
      */
     void set_console_output(bool enabled) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        console_enabled_ = enabled;
+        console_enabled_.store(enabled, std::memory_order_relaxed);
     }
-    
+
     /**
      * Set log file path (opens file for appending)
      */
-    bool set_file(const std::filesystem::path& path) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (file_.is_open()) {
-            file_.close();
-        }
-        
-        if (path.has_parent_path()) {
-            std::filesystem::create_directories(path.parent_path());
-        }
-        
-        file_.open(path, std::ios::app);
-        return file_.is_open();
-    }
-    
+    bool set_file(const std::filesystem::path& path);
+
     /**
      * Close log file
      */
-    void close_file() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (file_.is_open()) {
-            file_.close();
-        }
-    }
-    
+    void close_file();
+
     /**
-     * Set callback for UI log display
+     * Set callback for UI log display.
+     * Runs on the logging thread and sees at most CALLBACK_BURST lines per
+     * CALLBACK_INTERVAL; anything beyond that is reported as a count.
      */
-    void set_callback(std::function<void(LogLevel, const std::string&)> callback) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        callback_ = std::move(callback);
-    }
-    
+    void set_callback(Callback callback);
+
+    /**
+     * Queue an already formatted message. When the queue is full, debug and
+     * info messages are dropped (and counted); warnings and errors wait.
+     */
+    void write(LogLevel level, std::string_view tag, std::string message);
+
+    /**
+     * Queue a complete line written to std::cerr
+     */
+    void write_line(std::string line);
+
     /**
      * Log a message at the specified level
      */
     template<typename... Args>
     void log(LogLevel level, std::string_view tag, std::string_view format, Args&&... args) {
-        if (level < min_level_) return;
-        
-        std::string message = format_message(level, tag, format, std::forward<Args>(args)...);
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (console_enabled_) {
-            // Use cerr for errors, cout for others
-            auto& stream = (level == LogLevel::Error) ? std::cerr : std::cout;
-            stream << message << std::endl;
-        }
-        
-        if (file_.is_open()) {
-            file_ << message << std::endl;
-            file_.flush();
-        }
-        
-        if (callback_) {
-            callback_(level, message);
+        if (!is_enabled(level)) return;
+
+        if constexpr (sizeof...(Args) == 0) {
+            write(level, tag, std::string(format));
+        } else {
+            // Simple concatenation for now
+            std::ostringstream ss;
+            ss << format;
+            ((ss << args), ...);
+            write(level, tag, std::move(ss).str());
         }
     }
-    
+
     // Convenience methods
     template<typename... Args>
     void debug(std::string_view tag, std::string_view format, Args&&... args) {
         log(LogLevel::Debug, tag, format, std::forward<Args>(args)...);
     }
-    
+
     template<typename... Args>
     void info(std::string_view tag, std::string_view format, Args&&... args) {
         log(LogLevel::Info, tag, format, std::forward<Args>(args)...);
     }
-    
+
     template<typename... Args>
     void warn(std::string_view tag, std::string_view format, Args&&... args) {
         log(LogLevel::Warning, tag, format, std::forward<Args>(args)...);
     }
-    
+
     template<typename... Args>
     void error(std::string_view tag, std::string_view format, Args&&... args) {
         log(LogLevel::Error, tag, format, std::forward<Args>(args)...);
     }
 
+    /**
+     * Block until everything queued so far has been written
+     */
+    void flush();
+
+    /**
+     * Write out the queue, close the file and stop the logging thread.
+     * Later messages are dropped.
+     */
+    void shutdown();
+
+    uint64_t dropped() const { return dropped_total_.load(std::memory_order_relaxed); }
+
 private:
-    Logger() {
-        // Auto-initialize: Debug level, file only, no console spam
-        min_level_ = LogLevel::Debug;
-        console_enabled_ = false;
-        
-        // Auto-open log file
-        file_.open("enfusion_unpacker.log", std::ios::out | std::ios::trunc);
-        if (file_.is_open()) {
-            // Write header
-            auto now = std::chrono::system_clock::now();
-            auto time = std::chrono::system_clock::to_time_t(now);
-            std::tm tm_buf;
-#ifdef _WIN32
-            localtime_s(&tm_buf, &time);
-#else
-            localtime_r(&time, &tm_buf);
-#endif
-            file_ << "=== Enfusion Unpacker Log - " 
-                  << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S") << " ===\n\n";
-            file_.flush();
-        }
-    }
-    ~Logger() {
-        if (file_.is_open()) {
-            file_ << "\n=== Log End ===\n";
-            file_.close();
-        }
-    }
-    
-    template<typename... Args>
-    std::string format_message(LogLevel level, std::string_view tag, 
-                               std::string_view format, Args&&... args) {
-        std::ostringstream ss;
-        
-        // Timestamp
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
-        
-        std::tm tm_buf;
-#ifdef _WIN32
-        localtime_s(&tm_buf, &time);
-#else
-        localtime_r(&time, &tm_buf);
-#endif
-        
-        ss << std::put_time(&tm_buf, "%H:%M:%S") << '.'
-           << std::setfill('0') << std::setw(3) << ms.count() << ' ';
-        
-        // Level
-        ss << '[' << log_level_string(level) << "] ";
-        
-        // Tag
-        if (!tag.empty()) {
-            ss << '[' << tag << "] ";
-        }
-        
-        // Format message with variadic args (simple concatenation for now)
-        ss << format;
-        ((ss << args), ...);
-        
-        return ss.str();
-    }
-    
-    std::mutex mutex_;
+    Logger();
+    ~Logger();
+
+    void run();
+    size_t drain();
+    void append_line(const LogRecord& record, std::string& out);
+    void deliver(const LogRecord& record, std::string_view line);
+    void roll_callback_window();
+
+    static constexpr size_t QUEUE_CAPACITY = 8192;
+    static constexpr size_t MAX_BATCH = 1024;
+    static constexpr auto IDLE_INTERVAL = std::chrono::milliseconds(10);
+    static constexpr auto CALLBACK_INTERVAL = std::chrono::milliseconds(100);
+    static constexpr size_t CALLBACK_BURST = 64;
+
+    LogRing queue_{QUEUE_CAPACITY};
     std::atomic<LogLevel> min_level_{LogLevel::Debug};  // Atomic for thread-safe reads
-    bool console_enabled_ = false;          // No console spam by default
-    std::ofstream file_;
-    std::function<void(LogLevel, const std::string&)> callback_;
-};
+    std::atomic<bool> console_enabled_{false};          // No console spam by default
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> queued_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};                  // Not yet reported in the log
+    std::atomic<uint64_t> dropped_total_{0};
 
-// Stream-based logging macros - usage: LOG_INFO("Tag", "message " << value << " more")
-#define LOG_DEBUG(tag, msg) \
-    do { \
-        if (enfusion::Logger::instance().is_enabled(enfusion::LogLevel::Debug)) { \
-            std::ostringstream _log_ss; \
-            _log_ss << msg; \
-            enfusion::Logger::instance().debug(tag, _log_ss.str()); \
-        } \
-    } while(0)
+    // Only contended by set_file/set_callback against the logging thread
+    std::mutex output_mutex_;
+    std::ofstream file_;
+    Callback callback_;
 
-#define LOG_INFO(tag, msg) \
-    do { \
-        if (enfusion::Logger::instance().is_enabled(enfusion::LogLevel::Info)) { \
-            std::ostringstream _log_ss; \
-            _log_ss << msg; \
-            enfusion::Logger::instance().info(tag, _log_ss.str()); \
-        } \
-    } while(0)
+    // Logging thread state
+    std::thread thread_;
+    std::string batch_;
+    std::chrono::steady_clock::time_point callback_window_;
+    size_t callback_count_ = 0;
+    size_t callback_suppressed_ = 0;
+    std::time_t stamp_second_ = -1;
+    char stamp_[16] = {};
+};
 
-#define LOG_WARNING(tag, msg) \
+#define ENFUSION_LOG_AT(level, tag, msg) \
     do { \
-        if (enfusion::Logger::instance().is_enabled(enfusion::LogLevel::Warning)) { \
-            std::ostringstream _log_ss; \
-            _log_ss << msg; \
-            enfusion::Logger::instance().warn(tag, _log_ss.str()); \
+        if constexpr (static_cast<int>(level) >= ENFUSION_LOG_MIN_LEVEL) { \
+            if (enfusion::Logger::instance().is_enabled(level)) { \
+                std::ostringstream _log_ss; \
+                _log_ss << msg; \
+                enfusion::Logger::instance().write(level, tag, std::move(_log_ss).str()); \
+            } \
         } \
     } while(0)
 
+// Stream-based logging macros - usage: LOG_INFO("Tag", "message " << value << " more")
+// Nothing after the tag is evaluated unless the level is enabled.
+#define LOG_DEBUG(tag, msg) ENFUSION_LOG_AT(enfusion::LogLevel::Debug, tag, msg)
+#define LOG_INFO(tag, msg) ENFUSION_LOG_AT(enfusion::LogLevel::Info, tag, msg)
+#define LOG_WARNING(tag, msg) ENFUSION_LOG_AT(enfusion::LogLevel::Warning, tag, msg)
 #define LOG_WARN(tag, msg) LOG_WARNING(tag, msg)
-
-#define LOG_ERROR(tag, msg) \
-    do { \
-        if (enfusion::Logger::instance().is_enabled(enfusion::LogLevel::Error)) { \
-            std::ostringstream _log_ss; \
-            _log_ss << msg; \
-            enfusion::Logger::instance().error(tag, _log_ss.str()); \
-        } \
-    } while(0)
+#define LOG_ERROR(tag, msg) ENFUSION_LOG_AT(enfusion::LogLevel::Error, tag, msg)
 
 } // namespace enfusion
@@ -0,0 +1,151 @@
+/**
+ * Enfusion Unpacker - Memory Accounting
+ *
+ * Explicit byte counts per subsystem and per object, with optional budgets.
+ * An owner keeps a memory::Account next to the data it accounts for and
+ * updates it when the data grows or shrinks:
+ *
+ *     memory::Account account_{memory::Subsystem::PakData, "core"};
+ *     account_.set(pak_data_.capacity());
+ *
+ * Owners that can give memory back register an enforcer. Registry::enforce()
+ * is called from the UI thread and runs the enforcers of every subsystem that
+ * is over its budget, so they may touch UI-thread state.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace enfusion {
+namespace memory {
+
+enum class Subsystem {
+    PakData,    // Whole PAK files read into memory by AddonExtractor
+    FileLists,  // RDB file lists, path indices, install listings
+    Textures,   // Decoded pixels waiting for or held after upload
+    Meshes,     // CPU-side mesh geometry
+    Index,      // SQLite page cache and statements
+    Count
+};
+
+constexpr size_t SUBSYSTEM_COUNT = static_cast<size_t>(Subsystem::Count);
+
+const char* subsystem_name(Subsystem subsystem);  // For display
+const char* subsystem_key(Subsystem subsystem);   // For settings files
+
+/**
+ * Bytes held by one object. Registered with the registry for its lifetime;
+ * set() is two relaxed atomic operations.
+ */
+class Account {
+public:
+    Account(Subsystem subsystem, std::string label);
+    ~Account();
+
+    Account(const Account&) = delete;
+    Account& operator=(const Account&) = delete;
+
+    void set(size_t bytes);
+    void add(size_t bytes);
+    void sub(size_t bytes);
+    size_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+    Subsystem subsystem() const { return subsystem_; }
+    std::string label() const;
+    void set_label(std::string label);
+
+private:
+    Subsystem subsystem_;
+    std::atomic<size_t> bytes_{0};
+    mutable std::mutex label_mutex_;
+    std::string label_;
+};
+
+struct ObjectUsage {
+    std::string label;
+    size_t bytes = 0;
+};
+
+struct SubsystemUsage {
+    Subsystem subsystem = Subsystem::PakData;
+    size_t bytes = 0;       // Accounts plus the probe, if any
+    size_t peak = 0;
+    size_t budget = 0;      // 0 = unlimited
+    std::vector<ObjectUsage> objects;  // Largest first
+};
+
+class Registry {
+public:
+    using Probe = std::function<size_t()>;
+    using Enforcer = std::function<void(size_t usage, size_t budget)>;
+
+    static Registry& instance();
+
+    size_t usage(Subsystem subsystem) const;
+    size_t total() const;
+
+    size_t budget(Subsystem subsystem) const;
+    void set_budget(Subsystem subsystem, size_t bytes);
+    bool over_budget(Subsystem subsystem) const;
+
+    /** Memory this process doesn't count itself (e.g. SQLite's own allocator). */
+    void set_probe(Subsystem subsystem, Probe probe);
+
+    /** Returns an id for remove_enforcer(). */
+    uint64_t add_enforcer(Subsystem subsystem, Enforcer enforcer);
+    void remove_enforcer(uint64_t id);
+
+    /** Run enforcers for subsystems over budget. UI thread only; throttled. */
+    void enforce();
+
+    std::vector<SubsystemUsage> snapshot(size_t max_objects = 16) const;
+
+private:
+    friend class Account;
+
+    Registry() = default;
+
+    void attach(Account* account);
+    void detach(Account* account);
+    void charge(Subsystem subsystem, size_t old_bytes, size_t new_bytes);
+    size_t probe_bytes(Subsystem subsystem) const;
+
+    struct EnforcerEntry {
+        uint64_t id;
+        Subsystem subsystem;
+        Enforcer enforcer;
+    };
+
+    std::array<std::atomic<size_t>, SUBSYSTEM_COUNT> usage_{};
+    std::array<std::atomic<size_t>, SUBSYSTEM_COUNT> peak_{};
+    std::array<std::atomic<size_t>, SUBSYSTEM_COUNT> budget_{};
+
+    mutable std::mutex mutex_;
+    std::vector<Account*> accounts_;
+    std::array<Probe, SUBSYSTEM_COUNT> probes_;
+    std::vector<EnforcerEntry> enforcers_;
+    uint64_t next_enforcer_id_ = 1;
+    int64_t last_enforce_ms_ = 0;
+};
+
+/** Heap bytes owned by a string beyond the object itself. */
+inline size_t heap_bytes(const std::string& s) {
+    return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+}
+
+template<typename T>
+size_t heap_bytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+} // namespace memory
+} // namespace enfusion
@@ -0,0 +1,88 @@
+/**
+ * Enfusion Unpacker - Mesh Cache
+ *
+ * Parsed meshes kept on disk between runs, keyed by content: the fragment
+ * sha512 from the addon manifest where there is one, a hash of the XOB bytes
+ * otherwise. An entry is stored the way the renderer consumes it - packed
+ * XobVertex array, one 32-bit index buffer covering every LOD, then the LOD
+ * table, material ranges and material names - so opening one is a file
+ * mapping, and the vertex and index spans point straight into it.
+ */
+
+#pragma once
+
+#include "enfusion/types.hpp"
+#include "enfusion/files.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+
+namespace enfusion {
+
+/**
+ * A cache entry opened for reading. `mesh` carries everything except the
+ * geometry (its LODs have offsets and counts but no index copies); the
+ * geometry stays in the mapping and is valid while this object lives.
+ */
+struct CachedMesh {
+    XobMesh mesh;
+    std::span<const XobVertex> vertices;
+    std::span<const uint32_t> indices;
+    MappedFile file;
+};
+
+class MeshCache {
+public:
+    // Least recently opened entries are removed once the cache grows past this
+    static constexpr uint64_t MAX_BYTES = 2ull << 30;
+
+    static MeshCache& instance();
+
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    /**
+     * Key for a mesh that has no manifest hash: 64-bit FNV-1a of the bytes
+     * plus their length.
+     */
+    static std::string key_for(std::span<const uint8_t> data);
+
+    const std::filesystem::path& directory() const { return directory_; }
+
+    bool contains(const std::string& key) const;
+
+    /**
+     * Map the entry for `key`. Returns nullptr on a miss; an entry that fails
+     * validation (older format, truncated, other key) is deleted and counts
+     * as a miss.
+     */
+    std::unique_ptr<CachedMesh> open(const std::string& key);
+
+    /**
+     * Write `mesh` (with its bounds filled in) under `key`. The entry is
+     * written to a temporary file and renamed into place, so readers never
+     * see a partial one. Safe to call from any thread.
+     */
+    bool store(const std::string& key, const XobMesh& mesh);
+
+    /** Delete every entry. */
+    void clear();
+
+private:
+    MeshCache();
+
+    std::filesystem::path path_for(const std::string& key) const;
+    void trim();
+
+    std::filesystem::path directory_;
+
+    // Size of the directory, scanned on first store and kept up to date after
+    std::mutex mutex_;
+    uint64_t total_bytes_ = 0;
+    bool scanned_ = false;
+};
+
+} // namespace enfusion
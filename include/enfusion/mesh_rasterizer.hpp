@@ -0,0 +1,36 @@
+/**
+ * Enfusion Unpacker - Mesh Rasterizer
+ *
+ * Small CPU rasterizer for mesh thumbnails: orthographic, depth-buffered and
+ * flat-shaded, with supersampled edges. It needs no GL context, so it runs
+ * on any worker thread and in headless tools; callers render many meshes at
+ * once by rasterizing one per task.
+ */
+
+#pragma once
+
+#include "enfusion/types.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
+
+namespace enfusion {
+
+struct RasterOptions {
+    uint32_t size = 128;                      // Output is size x size RGBA
+    uint32_t supersample = 2;                 // Samples per pixel along each axis
+    float yaw = 45.0f;                        // Degrees; the model viewer's default angles
+    float pitch = 30.0f;
+    glm::vec3 color{0.74f, 0.76f, 0.80f};     // Surface color before shading
+    glm::vec4 background{0.0f};               // Transparent by default
+};
+
+/**
+ * Render the triangles in `indices` so the mesh fills the image. Indices
+ * past the end of `vertices` are skipped. Returns an image of the
+ * background color if there is nothing to draw.
+ */
+TextureData rasterize_mesh(std::span<const XobVertex> vertices, std::span<const uint32_t> indices,
+                           const RasterOptions& options = {});
+
+} // namespace enfusion
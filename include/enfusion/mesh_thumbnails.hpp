@@ -0,0 +1,93 @@
+/**
+ * Enfusion Unpacker - Mesh Thumbnails
+ *
+ * Thumbnails of XOB meshes rendered by the CPU rasterizer and kept on disk
+ * as PNGs, keyed like the mesh cache (fragment sha512, or a hash of the XOB
+ * bytes). Only the coarsest LOD is parsed; a mesh cache entry with its
+ * whole LOD table is drawn from its mapping instead, and one holding just
+ * LOD 0 is the fallback when the XOB can't be read. Nothing here touches
+ * GL, so the same code serves the file browser grid and headless contact
+ * sheets.
+ */
+
+#pragma once
+
+#include "enfusion/types.hpp"
+#include "enfusion/mesh_rasterizer.hpp"
+#include "enfusion/task_scheduler.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace enfusion {
+
+/**
+ * One mesh to thumbnail. `read` returns the XOB bytes; it is only called
+ * when the caches can't answer, and may run on any worker thread.
+ */
+struct ThumbnailRequest {
+    std::string path;
+    std::string key;  // Content key; empty = hash of the bytes
+    std::function<std::vector<uint8_t>()> read;
+};
+
+class ThumbnailCache {
+public:
+    // Least recently used thumbnails are removed once the cache grows past this
+    static constexpr uint64_t MAX_BYTES = 512ull << 20;
+
+    static ThumbnailCache& instance();
+
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    const std::filesystem::path& directory() const { return directory_; }
+
+    std::optional<TextureData> load(const std::string& key, const RasterOptions& options) const;
+    bool store(const std::string& key, const RasterOptions& options, const TextureData& image);
+
+    /** Delete every stored thumbnail. */
+    void clear();
+
+    /**
+     * Thumbnail for one mesh, from the cache or rendered and stored.
+     * Returns an empty image (width 0) if the mesh can't be read or parsed.
+     */
+    TextureData render(const ThumbnailRequest& request, const RasterOptions& options = {});
+
+    /**
+     * Render every request on the shared workers, one mesh per task, and
+     * return once all are done or `token` is cancelled. `done(index, image)`
+     * is called on the worker that finished it.
+     */
+    void render_all(const std::vector<ThumbnailRequest>& requests, const RasterOptions& options,
+                    TaskPriority priority, CancellationToken token,
+                    const std::function<void(size_t, TextureData)>& done);
+
+private:
+    ThumbnailCache();
+
+    std::filesystem::path path_for(const std::string& key, const RasterOptions& options) const;
+    void trim();
+
+    std::filesystem::path directory_;
+
+    // Size of the directory, scanned on first store and kept up to date after
+    std::mutex mutex_;
+    uint64_t total_bytes_ = 0;
+    bool scanned_ = false;
+};
+
+/**
+ * Lay equally sized tiles out row by row on an opaque background.
+ * Empty tiles leave their cell blank.
+ */
+TextureData make_contact_sheet(const std::vector<TextureData>& tiles, uint32_t columns,
+                               uint32_t tile_size, uint32_t padding = 4,
+                               glm::vec3 background = glm::vec3(0.12f, 0.12f, 0.14f));
+
+} // namespace enfusion
@@ -0,0 +1,155 @@
+/**
+ * Enfusion Unpacker - Metrics Registry
+ *
+ * Process-wide counters and latency histograms. Recording is a handful of
+ * relaxed atomic operations; callers look a metric up once and keep the
+ * reference:
+ *
+ *     static auto& bytes_read = metrics::counter("pak.bytes_read");
+ *     bytes_read.add(size);
+ *
+ * Naming: "<area>.<what>". Histograms hold nanoseconds. A "<name>.hits" and
+ * "<name>.misses" counter pair is reported as a cache hit rate.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace enfusion {
+namespace metrics {
+
+class Counter {
+public:
+    void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+    void reset() { value_.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * Log-linear histogram in the style of HdrHistogram: every power of two is
+ * split into SUB_BUCKETS linear buckets, so a reported percentile is within
+ * 1/SUB_BUCKETS of the true value over the whole 64-bit range.
+ */
+class Histogram {
+public:
+    void record(uint64_t value);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    /** Approximate value below which `fraction` (0..1) of the samples fall. */
+    uint64_t percentile(double fraction) const;
+
+    void reset();
+
+private:
+    static constexpr int SUB_BITS = 3;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    static size_t bucket_for(uint64_t value);
+    static uint64_t bucket_midpoint(size_t bucket);
+
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+struct CounterValue {
+    std::string name;
+    uint64_t value = 0;
+};
+
+struct HistogramSummary {
+    std::string name;
+    uint64_t count = 0;
+    double mean = 0.0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
+struct HitRate {
+    std::string name;   // Counter name without ".hits"/".misses"
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    double rate() const { return hits + misses ? double(hits) / double(hits + misses) : 0.0; }
+};
+
+struct Snapshot {
+    std::vector<CounterValue> counters;        // Sorted by name
+    std::vector<HistogramSummary> histograms;  // Sorted by name
+    std::vector<HitRate> hit_rates;
+};
+
+/**
+ * Owns every metric. Metrics are created on first lookup and never move or
+ * go away, so references stay valid for the life of the process.
+ */
+class Registry {
+public:
+    static Registry& instance();
+
+    Counter& counter(std::string_view name);
+    Histogram& histogram(std::string_view name);
+
+    Snapshot snapshot() const;
+    std::string to_json() const;
+    bool write_json(const std::filesystem::path& path) const;
+
+    /** Zero every metric; registrations are kept. */
+    void reset();
+
+private:
+    Registry() = default;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<Counter>, std::less<>> counters_;
+    std::map<std::string, std::unique_ptr<Histogram>, std::less<>> histograms_;
+};
+
+inline Counter& counter(std::string_view name) { return Registry::instance().counter(name); }
+inline Histogram& histogram(std::string_view name) { return Registry::instance().histogram(name); }
+
+/**
+ * Records the lifetime of the scope into a histogram, in nanoseconds.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { histogram_.record(elapsed_ns()); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    uint64_t elapsed_ns() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count());
+    }
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace metrics
+} // namespace enfusion
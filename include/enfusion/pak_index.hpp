@@ -15,6 +15,7 @@
 #include <functional>
 #include <thread>
 #include <unordered_map>
+#include <cstdint>
 
 // Forward declare SQLite
 struct sqlite3;
@@ -51,8 +52,17 @@ public:
     // Open/create the database
     bool open_database();
     void close_database();
+
+    // Hand SQLite's cached pages back to the heap (skipped while a query runs)
+    void release_memory();
+    
+    // Make the last committed index queryable straight away, without checking
+    // it against the PAKs on disk. Returns false if nothing was committed yet.
+    bool load_snapshot();
     
     // Scan and index all PAKs (multi-threaded)
+    // A loaded snapshot stays queryable while this runs; PAKs are swapped in
+    // one transaction each and PAKs gone from disk are dropped at the end.
     // Returns true if index was updated
     bool build_index(std::function<void(const std::string&, int, int)> progress_callback = nullptr);
     
@@ -74,13 +84,34 @@ public:
     std::vector<TextureSearchResult> search_files_by_name(const std::string& name_pattern, 
                                                           const std::string& extension = "") const;
     
+    // Every path in the install, each resolved to the PAK that wins it
+    struct VirtualFile {
+        std::string path;
+        uint32_t pak = 0;        // Index into InstallListing::paks
+        uint16_t providers = 1;  // PAKs shipping this path (>1 = overridden)
+    };
+    struct InstallListing {
+        std::vector<std::filesystem::path> paks;
+        std::vector<VirtualFile> files;  // Sorted by lowercase path
+    };
+    InstallListing list_install() const;
+    
+    // All PAKs providing a file, winning PAK first
+    std::vector<std::filesystem::path> find_all_paks_for_file(const std::string& virtual_path) const;
+    
     // Get stats
     size_t total_files() const;
     size_t total_paks() const;
     
-    // Check if index is loaded/ready
+    // Check if index is loaded/ready (possibly from a snapshot still being refreshed)
     bool is_ready() const { return ready_.load(); }
     
+    // True while build_index is checking or re-indexing PAKs
+    bool is_refreshing() const { return refreshing_.load(); }
+    
+    // Bumped whenever a refresh changes what is indexed
+    uint32_t generation() const { return generation_.load(); }
+    
     // Get indexing progress (0-100)
     int progress() const { return progress_.load(); }
     
@@ -97,9 +128,15 @@ private:
     // Index a single PAK file and insert into database
     bool index_pak_to_db(const std::filesystem::path& pak_path);
     
+    // Remove PAKs that are no longer on disk; returns how many were dropped
+    size_t prune_missing_paks(const std::vector<std::filesystem::path>& present);
+    
     // Create database schema
     bool create_schema();
     
+    // Override order: mod PAKs beat base game PAKs
+    static int pak_priority(const std::filesystem::path& pak_path, const std::filesystem::path& mods_root);
+    
     // Prepared statement cache management
     sqlite3_stmt* get_or_prepare_stmt(const std::string& name, const char* sql) const;
     void clear_stmt_cache();
@@ -120,9 +157,12 @@ private:
     
     // State
     std::atomic<bool> ready_{false};
+    std::atomic<bool> refreshing_{false};
+    std::atomic<uint32_t> generation_{0};
     std::atomic<int> progress_{0};
     std::atomic<bool> cancel_requested_{false};
-    unsigned int thread_count_ = 4;
+
+    static constexpr size_t MAX_INDEX_WIDTH = 8;  // Database writes serialize beyond this
 };
 
 } // namespace enfusion
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "types.hpp"
+#include "result.hpp"
 #include <filesystem>
 #include <fstream>
 #include <vector>
@@ -45,8 +46,8 @@ public:
     
     const PakEntry* find_entry(const std::string& path) const;
     
-    std::vector<uint8_t> read_file(const std::string& path);
-    std::vector<uint8_t> read_file(const PakEntry& entry);
+    Result<std::vector<uint8_t>> read_file(const std::string& path);
+    Result<std::vector<uint8_t>> read_file(const PakEntry& entry);
     
     bool extract_file(const std::string& path, const std::filesystem::path& output_path);
     bool extract_file(const PakEntry& entry, const std::filesystem::path& output_path);
@@ -0,0 +1,87 @@
+/**
+ * Enfusion Unpacker - Prefab and world layer parser
+ *
+ * Reads the text entity format used by prefabs (.et) and world files
+ * (.ent, .layer) and flattens it into a list of mesh instances. Prefab
+ * inheritance ("Entity : \"{GUID}Prefabs/X.et\"") is followed through a
+ * loader so instances pick up their base prefab's mesh and children.
+ */
+
+#pragma once
+
+#include "enfusion/result.hpp"
+#include <glm/glm.hpp>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace enfusion {
+
+/**
+ * One entity as written in the file, before inheritance is applied.
+ */
+struct PrefabEntity {
+    std::string class_name;     // e.g. StaticModelEntity, GenericEntity
+    std::string ancestor;       // Base prefab path, GUID stripped
+    std::string mesh;           // XOB from a MeshObject component, GUID stripped
+    glm::vec3 coords{0.0f};
+    glm::vec3 angles{0.0f};     // Degrees around X, Y, Z
+    float scale = 1.0f;
+    std::vector<PrefabEntity> children;
+};
+
+class PrefabParser {
+public:
+    /**
+     * Parse entity text. Top-level entities come back in file order;
+     * "$grp" blocks are expanded into one entity per member.
+     */
+    static Result<std::vector<PrefabEntity>> parse(std::string_view text);
+
+    /** "{1A2B3C4D5E6F7788}Assets/Foo.xob" -> "Assets/Foo.xob" */
+    static std::string strip_guid(std::string_view reference);
+};
+
+/**
+ * Mesh placement produced by flattening a scene.
+ */
+struct SceneInstance {
+    std::string mesh;
+    glm::mat4 transform{1.0f};
+};
+
+/**
+ * Flattens prefabs and layers into mesh instances.
+ *
+ * Each base prefab is loaded and parsed once per builder, however many
+ * entities inherit from it.
+ */
+class SceneBuilder {
+public:
+    using FileLoader = std::function<std::vector<uint8_t>(const std::string&)>;
+
+    explicit SceneBuilder(FileLoader loader);
+
+    Result<std::vector<SceneInstance>> build(std::string_view text);
+
+    size_t prefab_count() const { return prefabs_.size(); }
+
+    /** Base prefabs that could not be loaded or parsed. */
+    const std::vector<std::string>& missing() const { return missing_; }
+
+private:
+    static constexpr int MAX_DEPTH = 32;
+
+    const PrefabEntity* load_prefab(const std::string& path);
+    void flatten(const PrefabEntity& entity, const glm::mat4& parent, int depth,
+                 std::vector<SceneInstance>& out);
+
+    FileLoader loader_;
+    std::unordered_map<std::string, std::optional<PrefabEntity>> prefabs_;  // By lowercase path
+    std::vector<std::string> missing_;
+};
+
+} // namespace enfusion
@@ -120,13 +120,21 @@ public:
     }
     
     // Access value with default
-    T value_or(T default_value) const {
+    T value_or(T default_value) const& {
         if (ok()) {
             return std::get<T>(data_);
         }
         return default_value;
     }
     
+    // Moves the value out of a temporary instead of copying it
+    T value_or(T default_value) && {
+        if (ok()) {
+            return std::move(std::get<T>(data_));
+        }
+        return default_value;
+    }
+    
     // Access error
     const Error& error() const {
         if (ok()) {
@@ -178,7 +186,7 @@ public:
     
     const Error& error() const {
         static Error no_error;
-        return error_.value_or(no_error);
+        return error_ ? *error_ : no_error;
     }
     
     static Result success() { return Result(); }
@@ -0,0 +1,257 @@
+/**
+ * Enfusion Unpacker - Task Scheduler
+ *
+ * One pool of worker threads shared by every background job. Each worker has
+ * its own deque per priority: it pushes and pops at the back, idle workers
+ * steal from the front. Work submitted from outside the pool goes through a
+ * shared injection queue.
+ *
+ *     auto task = TaskScheduler::instance().async(TaskPriority::Interactive,
+ *         [data]() { return parse(data); });
+ *     ...
+ *     if (task.ready()) use(task.get());
+ *
+ * Priorities: Interactive work (something the user is waiting on) always
+ * goes first. Prefetch and Bulk work together never take more than
+ * background_limit() workers, so a long export or re-index can't starve the
+ * model the user just clicked on.
+ *
+ * Tasks run once every task in TaskOptions::after has finished. A task with
+ * main_thread set runs on the UI thread from run_main_thread_tasks(), which
+ * the app calls once per frame; that is how results get back to the UI.
+ *
+ * Cancelling a task that hasn't started drops it. A running task sees the
+ * cancellation through its token and is expected to return early.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace enfusion {
+
+enum class TaskPriority : uint8_t {
+    Interactive,  // The user is waiting on the result
+    Prefetch,     // Speculative, likely needed soon
+    Bulk,         // Long-running: indexing, export, search
+};
+
+constexpr size_t TASK_PRIORITY_COUNT = 3;
+
+const char* task_priority_name(TaskPriority priority);
+
+/**
+ * Shared cancel flag. Copies refer to the same flag.
+ */
+class CancellationToken {
+public:
+    CancellationToken() : cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const { cancelled_->store(true, std::memory_order_release); }
+    bool cancelled() const { return cancelled_->load(std::memory_order_acquire); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+namespace detail {
+struct TaskNode;
+} // namespace detail
+
+/**
+ * Reference to a submitted task. Dropping the handle does not cancel or
+ * wait for the task.
+ */
+class TaskHandle {
+public:
+    TaskHandle() = default;
+
+    bool valid() const { return node_ != nullptr; }
+    bool done() const;
+
+    /** Block until the task has finished; runs it here if no worker has picked it up yet. */
+    void wait() const;
+
+    /** Cancel the task's token; a task that hasn't started finishes without running. */
+    void cancel() const;
+
+    CancellationToken token() const;
+
+private:
+    friend class TaskScheduler;
+    explicit TaskHandle(std::shared_ptr<detail::TaskNode> node) : node_(std::move(node)) {}
+
+    std::shared_ptr<detail::TaskNode> node_;
+};
+
+/**
+ * A task with a result. Mirrors the parts of std::future the UI polls with.
+ * get() on a task that was cancelled before it ran throws std::future_error.
+ */
+template<typename T>
+class Task {
+public:
+    Task() = default;
+
+    bool valid() const { return future_.valid(); }
+    bool ready() const { return handle_.done(); }
+    void wait() const { handle_.wait(); }
+    void cancel() const { handle_.cancel(); }
+
+    T get() {
+        handle_.wait();
+        handle_ = {};
+        return future_.get();
+    }
+
+    const TaskHandle& handle() const { return handle_; }
+
+private:
+    friend class TaskScheduler;
+    Task(TaskHandle handle, std::future<T> future)
+        : handle_(std::move(handle)), future_(std::move(future)) {}
+
+    TaskHandle handle_;
+    std::future<T> future_;
+};
+
+struct TaskOptions {
+    TaskPriority priority = TaskPriority::Interactive;
+    CancellationToken token;
+    std::vector<TaskHandle> after;  // Finished before this one starts
+    bool main_thread = false;       // Run from run_main_thread_tasks()
+    const char* name = nullptr;     // Trace span, "task" if unset
+};
+
+class TaskScheduler {
+public:
+    static constexpr unsigned MAX_WORKERS = 64;
+
+    static TaskScheduler& instance();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /**
+     * Set the number of workers and how many of them Prefetch and Bulk work
+     * may occupy at once (0 = automatic for either). Takes effect
+     * immediately; surplus workers finish their current task and park.
+     */
+    void configure(unsigned workers, unsigned background = 0);
+
+    unsigned worker_count() const { return active_.load(std::memory_order_relaxed); }
+    unsigned background_limit() const { return background_limit_.load(std::memory_order_relaxed); }
+    static unsigned default_worker_count();
+
+    /** Number of tasks queued at a priority, for display. */
+    size_t queued(TaskPriority priority) const;
+    size_t running() const { return running_.load(std::memory_order_relaxed); }
+
+    TaskHandle submit(std::function<void()> fn, TaskOptions options = {});
+
+    template<typename F>
+    auto async(TaskPriority priority, F&& fn, CancellationToken token = {})
+        -> Task<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+        auto future = task->get_future();
+
+        TaskOptions options;
+        options.priority = priority;
+        options.token = std::move(token);
+        TaskHandle handle = submit([task]() { (*task)(); }, std::move(options));
+        return Task<R>(std::move(handle), std::move(future));
+    }
+
+    /** Continuation onto the UI thread once `after` has finished. */
+    TaskHandle run_on_main(std::function<void()> fn, std::vector<TaskHandle> after = {},
+                           CancellationToken token = {});
+
+    /**
+     * Run `worker` on up to `width` threads at once, the caller included, and
+     * return when every copy has. Workers are expected to share a cursor, so
+     * copies that start late find nothing left and return. 0 = one per worker.
+     */
+    void parallel(size_t width, const std::function<void()>& worker,
+                  TaskPriority priority, CancellationToken token = {});
+
+    /** body(i) for every i in [0, count), stopping early once `token` is cancelled. */
+    void parallel_for(size_t count, const std::function<void(size_t)>& body,
+                      TaskPriority priority, CancellationToken token = {}, size_t width = 0);
+
+    /**
+     * Run continuations queued for the UI thread; call once per frame from
+     * that thread. The wake-up is called from any thread when one is queued.
+     */
+    size_t run_main_thread_tasks();
+    void set_main_thread_wakeup(std::function<void()> wakeup);
+
+    /** Finish running tasks, drop queued ones and join the workers. */
+    void shutdown();
+
+private:
+    using NodePtr = std::shared_ptr<detail::TaskNode>;
+
+    struct Worker {
+        std::mutex mutex;
+        std::array<std::deque<NodePtr>, TASK_PRIORITY_COUNT> queues;
+        std::thread thread;
+    };
+
+    TaskScheduler();
+    ~TaskScheduler();
+
+    void worker_loop(unsigned index);
+    NodePtr find_task(unsigned index, bool& background);
+    NodePtr pop_own(unsigned index, size_t priority);
+    NodePtr pop_injected(size_t priority);
+    NodePtr steal(unsigned index, size_t priority);
+    bool has_work(unsigned index) const;
+    void park_queued(unsigned index);
+
+    void enqueue(const NodePtr& node);
+    void execute(const NodePtr& node);
+    void finish(const NodePtr& node);
+    void wait(const NodePtr& node);
+    void cancel(const NodePtr& node);
+    void wake_main_thread();
+
+    friend class TaskHandle;
+
+    std::array<std::unique_ptr<Worker>, MAX_WORKERS> workers_;
+    std::atomic<unsigned> spawned_{0};
+    std::atomic<unsigned> active_{0};
+    std::atomic<unsigned> background_limit_{1};
+    std::atomic<unsigned> background_running_{0};
+    std::atomic<size_t> running_{0};
+    std::array<std::atomic<size_t>, TASK_PRIORITY_COUNT> queued_{};
+    std::atomic<bool> stopping_{false};
+    std::mutex configure_mutex_;
+
+    std::mutex injected_mutex_;
+    std::array<std::deque<NodePtr>, TASK_PRIORITY_COUNT> injected_;
+
+    // Idle workers sleep on wake_cv_, surplus ones on park_cv_
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable park_cv_;
+
+    std::mutex main_mutex_;
+    std::vector<NodePtr> main_queue_;
+    std::function<void()> main_wakeup_;
+    std::thread::id main_thread_;
+};
+
+} // namespace enfusion
@@ -0,0 +1,95 @@
+/**
+ * Enfusion Unpacker - Texture Resolver
+ *
+ * Finds and decodes the colour texture for each material of a model.
+ * Each material is its own interactive task; candidates are checked against a
+ * path index before anything is read, and (material, search dir) pairs
+ * that turned up nothing are remembered for the rest of the session.
+ */
+
+#pragma once
+
+#include "enfusion/types.hpp"
+#include "enfusion/task_scheduler.hpp"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace enfusion {
+
+class TextureResolver {
+public:
+    /** True if a path exists in whatever is being browsed (cheap, no read). */
+    using ExistsFn = std::function<bool(const std::string&)>;
+    /** Reads a file; empty on failure. */
+    using LoadFn = std::function<std::vector<uint8_t>(const std::string&)>;
+
+    struct Resolved {
+        size_t material = 0;   // Index into the material list passed to resolve()
+        std::string path;
+        TextureData texture;
+    };
+
+    TextureResolver() = default;
+    ~TextureResolver();
+
+    TextureResolver(const TextureResolver&) = delete;
+    TextureResolver& operator=(const TextureResolver&) = delete;
+
+    /**
+     * Start resolving textures for the given material paths, cancelling any
+     * previous request. `scope` identifies what is being searched (an addon
+     * or the whole install) so misses from one don't hide hits in another.
+     * Without an exists callback every candidate is read instead.
+     */
+    void resolve(std::string scope, std::vector<std::string> materials, ExistsFn exists, LoadFn load);
+    void cancel();
+
+    bool is_busy() const;
+
+    /** Textures decoded since the last call, in arrival order. */
+    std::vector<Resolved> take_resolved();
+
+    /** EDDS (or plain DDS) bytes to RGBA pixels. */
+    static std::optional<TextureData> decode(const std::vector<uint8_t>& data);
+
+    /** Search directories and candidate paths for a material, best first. */
+    struct CandidateGroup {
+        std::string dir;
+        std::vector<std::string> paths;
+    };
+    static std::vector<CandidateGroup> candidates(const std::string& material_path);
+
+    /** Number of remembered misses (for diagnostics). */
+    static size_t miss_count();
+
+private:
+    struct Request {
+        std::string scope;
+        std::vector<std::string> materials;
+        ExistsFn exists;
+        LoadFn load;
+        CancellationToken cancel;
+        std::mutex mutex;
+        std::vector<Resolved> resolved;
+    };
+
+    static void resolve_material(Request& request, size_t index);
+    static std::string miss_key(const std::string& scope, const std::string& material, const std::string& dir);
+
+    void reap_retired();
+
+    std::shared_ptr<Request> request_;
+    std::vector<TaskHandle> tasks_;
+    std::vector<TaskHandle> retired_;  // Cancelled tasks still finishing a read
+
+    // Session-wide negative cache
+    static std::mutex miss_mutex_;
+    static std::unordered_set<std::string> misses_;
+};
+
+} // namespace enfusion
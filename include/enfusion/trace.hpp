@@ -0,0 +1,134 @@
+/**
+ * Enfusion Unpacker - Span Tracing
+ *
+ * Scoped spans written out as a Chrome trace (chrome://tracing, Perfetto):
+ *
+ *     TRACE_SCOPE("pak.open");
+ *
+ *     TRACE_SPAN(span, "xob.parse");
+ *     TRACE_ARG(span, "bytes", data.size());
+ *
+ * Spans are recorded into a buffer owned by the thread that ends them, so
+ * threads never contend with each other. While tracing is stopped a span is
+ * one relaxed load; argument expressions are not evaluated. Building with
+ * ENFUSION_TRACE=0 removes spans altogether.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#ifndef ENFUSION_TRACE
+#define ENFUSION_TRACE 1
+#endif
+
+namespace enfusion {
+namespace trace {
+
+namespace detail {
+extern std::atomic<bool> g_enabled;
+extern std::atomic<uint32_t> g_session;
+
+uint64_t now_ns();
+void record(const char* name, uint32_t session, uint64_t start_ns, uint64_t end_ns, std::string&& args);
+void append_arg(std::string& args, std::string_view key, std::string_view value);
+void append_arg(std::string& args, std::string_view key, uint64_t value);
+void append_arg(std::string& args, std::string_view key, double value);
+} // namespace detail
+
+inline bool enabled() { return detail::g_enabled.load(std::memory_order_relaxed); }
+
+/** Discard anything recorded so far and begin recording. */
+void start();
+void stop();
+
+/** Write every span recorded in the current session as Chrome trace JSON. */
+bool write_json(const std::filesystem::path& path);
+
+size_t event_count();
+uint64_t dropped();
+
+/** Label the calling thread in the trace ("Main", "Texture Worker", ...). */
+void set_thread_name(std::string name);
+
+/**
+ * Single-operation capture: arm with a target file, and the next operation
+ * that calls begin_capture() records from its start until its end_capture().
+ */
+void arm_capture(const std::filesystem::path& path);
+bool capture_armed();
+bool begin_capture();  // True if this caller now owns the capture
+bool end_capture();    // Stops and writes the file; false if the write failed
+std::filesystem::path capture_path();
+
+#if ENFUSION_TRACE
+
+class Span {
+public:
+    explicit Span(const char* name) {
+        if (enabled()) {
+            name_ = name;
+            session_ = detail::g_session.load(std::memory_order_relaxed);
+            start_ns_ = detail::now_ns();
+        }
+    }
+
+    ~Span() {
+        if (name_) {
+            detail::record(name_, session_, start_ns_, detail::now_ns(), std::move(args_));
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    bool active() const { return name_ != nullptr; }
+
+    void arg(std::string_view key, std::string_view value) { detail::append_arg(args_, key, value); }
+    void arg(std::string_view key, const std::string& value) { detail::append_arg(args_, key, std::string_view(value)); }
+    void arg(std::string_view key, const char* value) { detail::append_arg(args_, key, std::string_view(value)); }
+    void arg(std::string_view key, double value) { detail::append_arg(args_, key, value); }
+    template<typename T> requires std::is_integral_v<T>
+    void arg(std::string_view key, T value) { detail::append_arg(args_, key, static_cast<uint64_t>(value)); }
+
+private:
+    const char* name_ = nullptr;  // Null while tracing is stopped
+    uint32_t session_ = 0;
+    uint64_t start_ns_ = 0;
+    std::string args_;            // Rendered JSON members, only filled when active
+};
+
+#else
+
+class Span {
+public:
+    explicit Span(const char*) {}
+    static constexpr bool active() { return false; }
+    template<typename T> void arg(std::string_view, const T&) {}
+};
+
+#endif
+
+} // namespace trace
+} // namespace enfusion
+
+#define ENFUSION_TRACE_CONCAT_INNER(a, b) a##b
+#define ENFUSION_TRACE_CONCAT(a, b) ENFUSION_TRACE_CONCAT_INNER(a, b)
+
+#if ENFUSION_TRACE
+#define TRACE_SCOPE(name) enfusion::trace::Span ENFUSION_TRACE_CONCAT(_trace_span_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
+
+#define TRACE_SPAN(var, name) enfusion::trace::Span var(name)
+#define TRACE_ARG(var, key, value) \
+    do { \
+        if (var.active()) var.arg(key, value); \
+    } while(0)
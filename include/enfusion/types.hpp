@@ -13,6 +13,7 @@
 #include <memory>
 #include <filesystem>
 #include <functional>
+#include <map>
 
 namespace enfusion {
 
@@ -53,10 +54,13 @@ struct LzoDescriptor {
     uint32_t index_count = 0;
     uint32_t compressed_size = 0;
     uint32_t decompressed_size = 0;
+    uint32_t triangle_count = 0;
+    uint32_t quality_tier = 0;
+    uint32_t submesh_index = 0;
 };
 
 /**
- * Material range for mesh rendering.
+ * Material range for mesh rendering, in indices into the LOD's index buffer.
  */
 struct MaterialRange {
     uint32_t material_index = 0;
@@ -107,6 +111,7 @@ struct XobMesh {
     std::vector<uint32_t> indices;
     std::vector<XobLod> lods;
     std::vector<XobMaterial> materials;
+    std::vector<MaterialRange> material_ranges;  // Sorted by start_index, cover all indices
     uint32_t version = 0;
     glm::vec3 bounds_min{0.0f};
     glm::vec3 bounds_max{0.0f};
@@ -154,6 +159,7 @@ struct AppSettings {
     fs::path last_addon_path;
     fs::path last_export_path;
     fs::path arma_addons_path;
+    fs::path arma_mods_path;  // Workshop addons, loaded over the base game
 
     // Export settings
     bool convert_textures_to_png = true;
@@ -162,6 +168,17 @@ struct AppSettings {
     // UI settings
     float ui_scale = 1.0f;
     int theme = 0;  // 0=Dark, 1=Light, 2=DarkBlue, 3=Purple
+
+    // Memory budgets in MB by subsystem key (see enfusion/memory.hpp), 0 = unlimited
+    std::map<std::string, uint32_t> memory_budgets_mb = {
+        {"pak_data", 4096},
+        {"meshes", 1024},
+        {"index", 256},
+    };
+
+    // Background work, 0 = automatic (see enfusion/task_scheduler.hpp)
+    uint32_t worker_threads = 0;
+    uint32_t background_workers = 0;
 };
 
 /**
@@ -16,6 +16,9 @@ public:
     static constexpr uint8_t MAGIC[4] = {'F', 'O', 'R', 'M'};
     static constexpr uint8_t FORM_TYPE[4] = {'X', 'O', 'B', '9'};
     
+    // Pass to parse() for the lowest-detail LOD the file has
+    static constexpr uint32_t COARSEST_LOD = UINT32_MAX;
+    
     explicit XobParser(std::span<const uint8_t> data);
     
     std::optional<XobMesh> parse(uint32_t lod = 0);
@@ -27,7 +30,7 @@ private:
     std::optional<std::span<const uint8_t>> find_chunk(const uint8_t* chunk_id) const;
     std::vector<LzoDescriptor> parse_descriptors(std::span<const uint8_t> head_data);
     std::vector<XobMaterial> parse_materials(std::span<const uint8_t> head_data);
-    std::vector<MaterialRange> parse_material_ranges(std::span<const uint8_t> head_data, uint32_t triangle_count);
+    std::vector<MaterialRange> parse_material_ranges(uint32_t triangle_count, uint8_t mesh_type);
     std::span<const uint8_t> extract_lod_region(std::span<const uint8_t> decompressed, uint32_t lod);
     std::optional<XobMesh> parse_mesh_region(std::span<const uint8_t> region, const LzoDescriptor& desc);
     void calculate_bounds(XobMesh& mesh);
@@ -5,8 +5,10 @@
 #pragma once
 
 #include "enfusion/types.hpp"
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>
 
 struct GLFWwindow;
 
@@ -17,6 +19,10 @@ class MainWindow;
 /**
  * Main application class.
  * Handles window creation, rendering loop, and global state.
+ *
+ * The loop sleeps in glfwWaitEventsTimeout while nothing changes. Input
+ * wakes it for a few frames; anything animating or polling a job asks for
+ * its next frame with request_redraw().
  */
 class App {
 public:
@@ -32,6 +38,8 @@ public:
     const AppSettings& settings() const { return settings_; }
     void save_settings();
     void load_settings();
+    void apply_memory_budgets();
+    void apply_worker_settings();
 
     // Window
     GLFWwindow* window() { return window_; }
@@ -42,12 +50,19 @@ public:
     void set_status(const std::string& msg);
     const std::string& status() const { return status_; }
 
+    /**
+     * Ask for a frame within `delay` seconds (0 = as soon as possible).
+     * Safe to call from worker threads; those also wake the loop.
+     */
+    void request_redraw(double delay = 0.0);
+
 private:
     App() = default;
     ~App() = default;
 
     bool init_glfw();
     bool init_imgui();
+    void wait_for_events();
     void process_events();
     void render();
 
@@ -60,6 +75,16 @@ private:
     int width_ = 1600;
     int height_ = 900;
     bool running_ = false;
+
+    // Idle rendering
+    static constexpr int SETTLE_FRAMES = 3;              // ImGui needs a few frames to settle after input
+    static constexpr double IDLE_TIMEOUT = 0.5;          // Upper bound on sleep, keeps hover tooltips working
+    static constexpr double UNFOCUSED_INTERVAL = 0.25;   // Minimum gap between animation frames in the background
+
+    std::thread::id main_thread_;
+    std::atomic<double> redraw_at_{0.0};  // glfwGetTime() of the earliest requested frame
+    int settle_frames_ = SETTLE_FRAMES;
+    double last_frame_ = 0.0;
 };
 
 } // namespace enfusion
@@ -0,0 +1,45 @@
+﻿/**
+ * Enfusion Unpacker - Content Search Panel
+ */
+
+#pragma once
+
+#include "enfusion/types.hpp"
+#include "enfusion/content_search.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace enfusion {
+
+/**
+ * "Search in Files" panel: runs a ContentSearch over the current addon or
+ * every addon under the addons folder and lists hits as they arrive.
+ */
+class ContentSearchPanel {
+public:
+    std::function<void(const ContentSearchHit&)> on_hit_selected;
+
+    void set_current_addon(const fs::path& addon_dir) { current_addon_ = addon_dir; }
+    void set_addons_root(const fs::path& root) { addons_root_ = root; }
+
+    void render();
+
+private:
+    void start_search();
+
+    ContentSearch search_;
+    std::vector<ContentSearchHit> hits_;
+    std::string error_;
+
+    fs::path current_addon_;
+    fs::path addons_root_;
+
+    char pattern_[256] = {};
+    bool regex_ = false;
+    bool case_sensitive_ = false;
+    bool all_addons_ = false;
+    int selected_hit_ = -1;
+};
+
+} // namespace enfusion
@@ -5,11 +5,13 @@
 #pragma once
 
 #include "enfusion/types.hpp"
+#include "enfusion/task_scheduler.hpp"
 #include <filesystem>
 #include <functional>
 #include <vector>
 #include <string>
 #include <atomic>
+#include <mutex>
 
 namespace enfusion {
 
@@ -21,7 +23,7 @@ class AddonExtractor;
 class ExportDialog {
 public:
     ExportDialog() = default;
-    ~ExportDialog() = default;
+    ~ExportDialog();
 
     void render(bool* open);
 
@@ -56,14 +58,18 @@ private:
 
     // State
     bool exporting_ = false;
-    float progress_ = 0.0f;
+    bool export_finished_ = false;  // Set on the UI thread once the export task is done
+    std::string error_message_;
+
+    // Written by the export task
+    std::mutex progress_mutex_;
     std::string current_file_;
-    int files_processed_ = 0;
-    int total_files_ = 0;
+    std::atomic<int> files_processed_{0};
+    std::atomic<int> total_files_{0};
 
-    std::atomic<bool> cancel_requested_{false};
-    std::atomic<bool> export_finished_{false};
-    std::string error_message_;
+    TaskHandle export_task_;
+    TaskHandle finish_task_;
+    CancellationToken export_token_;
 };
 
 } // namespace enfusion
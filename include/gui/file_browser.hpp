@@ -5,11 +5,21 @@
 #pragma once
 
 #include "enfusion/types.hpp"
+#include "enfusion/pak_index.hpp"
+#include "enfusion/memory.hpp"
+#include "enfusion/task_scheduler.hpp"
+#include "enfusion/mesh_thumbnails.hpp"
 #include <filesystem>
 #include <functional>
 #include <string>
 #include <vector>
 #include <memory>
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
 
 namespace enfusion {
 
@@ -33,20 +43,30 @@ enum class FileType {
 struct FileEntry {
     std::string path;
     std::string name;
+    std::string name_lower;  // Precomputed once for searching
     size_t size = 0;
     FileType type = FileType::Other;
     bool is_directory = false;
     int rdb_index = -1;  // Index in RDB for reading from PAK
+    int32_t source = -1;     // Owning PAK in the whole-install view
+    uint16_t providers = 1;  // PAKs shipping this path; >1 means others are shadowed
 };
 
 /**
  * Tree node for hierarchical file view.
+ * Nodes live in a flat arena and link to each other by index (-1 = none),
+ * so growing the arena never invalidates a link.
  */
 struct TreeNode {
-    std::string name;
-    bool is_file = false;
+    uint32_t name = 0;          // Interned name id
+    int32_t parent = -1;
+    int32_t first_child = -1;
+    int32_t last_child = -1;
+    int32_t next_sibling = -1;
     const FileEntry* entry = nullptr;
-    std::vector<TreeNode> children;
+    uint16_t depth = 0;
+    bool is_file = false;
+    bool open = false;          // Expanded in the tree view
 };
 
 /**
@@ -54,7 +74,8 @@ struct TreeNode {
  */
 enum class ViewMode {
     Tree = 0,
-    List = 1
+    List = 1,
+    Grid = 2    // Tiles with mesh thumbnails
 };
 
 /**
@@ -66,10 +87,21 @@ public:
 
     std::function<void(const std::string&)> on_file_selected;
 
-    FileBrowser() = default;
-    ~FileBrowser() = default;
+    FileBrowser();
+    ~FileBrowser();
 
     void load(const std::filesystem::path& addon_path);
+
+    /**
+     * Browse every indexed PAK under the game/mods folders as one tree.
+     * Listing comes from PakIndex; an addon is only opened when one of
+     * its files is read. The last committed index is shown straight away
+     * and re-listed if the background refresh finds changes.
+     */
+    void load_install(const std::filesystem::path& game_path, const std::filesystem::path& mods_path = {});
+    bool is_install_view() const { return install_view_; }
+    bool is_loading() const { return install_future_.valid(); }
+
     void render();
 
     const FileEntry* selected() const { return selected_entry_; }
@@ -83,6 +115,26 @@ public:
      * Get the addon extractor (for reading files)
      */
     std::shared_ptr<AddonExtractor> extractor() const { return extractor_; }
+
+    /**
+     * Extractor that can read the given path: the loaded addon, or in the
+     * whole-install view the addon owning the winning PAK (opened on demand).
+     * UI thread only; it reads which view is current.
+     */
+    std::shared_ptr<AddonExtractor> extractor_for(const std::string& path);
+
+    /**
+     * Whole-install lookup for workers: resolves through the PakIndex and the
+     * addon cache only, so it never reads state the UI thread reassigns.
+     */
+    std::shared_ptr<AddonExtractor> install_extractor_for(const std::string& path);
+
+    /**
+     * Extractor for an addon folder from the same cache the whole-install
+     * view uses; opened on first use with its PAK indexed in the background.
+     * Safe to call from workers.
+     */
+    std::shared_ptr<AddonExtractor> extractor_for_addon(const std::filesystem::path& addon_dir);
     
     /**
      * Get all texture file paths (.edds files)
@@ -97,40 +149,129 @@ public:
         return textures;
     }
 
-    void clear() {
-        entries_.clear();
-        filtered_entries_.clear();
-        tree_root_.children.clear();
-        selected_entry_ = nullptr;
-        extractor_.reset();
-    }
+    void clear();
 
 private:
     void load_from_directory(const std::filesystem::path& dir_path);
     void load_from_addon(const std::filesystem::path& addon_dir);
+    void poll_install_job();
+    void apply_install_listing(PakIndex::InstallListing listing);
+    void reset_install_view();
+    void evict_install_addons(size_t usage, size_t budget);
+    void update_listing_account();
     void build_tree();
-    void add_to_tree(TreeNode* parent, const std::string& path, const FileEntry* entry);
+    void clear_tree();
+    int32_t add_node(int32_t parent, uint32_t name, bool is_file, const FileEntry* entry);
+    uint32_t intern_name(std::string_view name);
     void apply_filter();
+    void poll_filter_job();
+    void cancel_filter_job();
 
-    void render_tree_node(const TreeNode& node);
+    void rebuild_visible_rows();
+    void render_tree();
+    void render_tree_row(int32_t index);
     void render_flat_list();
+    void render_grid();
+    void request_thumbnail(const FileEntry& entry);
+    void poll_thumbnails();
+    void reset_thumbnails();
+    void render_entry_tooltip(const FileEntry& entry) const;
 
     const char* get_type_icon(FileType type) const;
     std::string format_size(size_t bytes) const;
 
+    /**
+     * Filter run off the UI thread for large candidate sets.
+     */
+    struct FilterJob {
+        std::string query;
+        bool textures = false;
+        bool meshes = false;
+        std::vector<const FileEntry*> candidates;
+        std::vector<const FileEntry*> results;
+        std::atomic<bool> cancel{false};
+    };
+
+    static constexpr size_t BACKGROUND_FILTER_THRESHOLD = 20000;
+
+    /**
+     * A batch of grid thumbnails rendered on the workers. Results are
+     * uploaded to GL on the UI thread as they arrive.
+     */
+    struct ThumbnailJob {
+        uint64_t generation = 0;  // thumbnail_generation_ when queued
+        std::vector<ThumbnailRequest> requests;
+        CancellationToken cancel;
+        std::mutex mutex;
+        std::vector<std::pair<std::string, TextureData>> finished;
+    };
+
+    struct Thumbnail {
+        uint32_t texture = 0;  // 0 while rendering, or if the mesh couldn't be drawn
+    };
+
+    static constexpr uint32_t THUMBNAIL_SIZE = 128;
+    static constexpr size_t THUMBNAIL_BATCH = 32;
+
     std::filesystem::path root_path_;
     std::vector<FileEntry> entries_;
     std::vector<const FileEntry*> filtered_entries_;
-    TreeNode tree_root_;
+
+    // Tree arena: nodes_[0] is the root
+    std::vector<TreeNode> nodes_;
+    std::deque<std::string> names_;  // deque keeps views into names stable
+    std::unordered_map<std::string_view, uint32_t> name_ids_;
+    // Directory lookup: (parent node << 32 | name id) -> child node
+    std::unordered_map<uint64_t, int32_t> dir_children_;
+
+    // Flattened rows of the expanded tree, rebuilt only on expand/collapse
+    std::vector<int32_t> visible_rows_;
+    bool rows_dirty_ = true;
 
     const FileEntry* selected_entry_ = nullptr;
     std::string search_filter_;
 
+    // What filtered_entries_ currently holds, for incremental narrowing
+    std::string filtered_query_;
+    bool filtered_textures_ = false;
+    bool filtered_meshes_ = false;
+    bool filter_valid_ = false;
+
+    std::shared_ptr<FilterJob> filter_job_;
+    Task<void> filter_future_;
+
     ViewMode view_mode_ = ViewMode::Tree;
     bool filter_textures_ = false;
     bool filter_meshes_ = false;
     
     std::shared_ptr<AddonExtractor> extractor_;
+
+    // Whole-install view: listing built on a worker, addons opened lazily
+    bool install_view_ = false;
+    Task<PakIndex::InstallListing> install_future_;
+    std::atomic<bool> install_from_snapshot_{false};
+    Task<bool> index_refresh_;   // Staleness check and re-index behind the snapshot
+    uint32_t listed_generation_ = 0;    // PakIndex generation the entries were listed from
+    std::vector<std::filesystem::path> install_paks_;
+
+    struct InstallAddon {
+        std::shared_ptr<AddonExtractor> extractor;
+        uint64_t last_used = 0;  // install_use_clock_ at the last lookup
+    };
+    std::unordered_map<std::string, InstallAddon> install_addons_;  // addon dir -> extractor, also for search hits
+    uint64_t install_use_clock_ = 0;
+    std::mutex install_addons_mutex_;
+
+    // Grid view: path -> thumbnail, plus meshes scrolled into view but not yet rendered
+    std::unordered_map<std::string, Thumbnail> thumbnails_;
+    std::deque<std::string> thumbnail_queue_;
+    std::shared_ptr<ThumbnailJob> thumbnail_job_;
+    Task<void> thumbnail_task_;
+    uint64_t thumbnail_generation_ = 0;           // Bumped by reset_thumbnails()
+    std::vector<Task<void>> abandoned_thumbnails_;  // Cancelled, waited for only on destruction
+
+    memory::Account listing_account_{memory::Subsystem::FileLists, "File browser"};
+    uint64_t pak_enforcer_ = 0;
 };
 
 } // namespace enfusion
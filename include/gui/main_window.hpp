@@ -5,14 +5,19 @@
 #pragma once
 
 #include "enfusion/types.hpp"
+#include "enfusion/task_scheduler.hpp"
 #include "gui/addon_browser.hpp"
 #include "gui/file_browser.hpp"
 #include "gui/texture_viewer.hpp"
 #include "gui/model_viewer.hpp"
+#include "gui/scene_viewer.hpp"
 #include "gui/text_viewer.hpp"
 #include "gui/export_dialog.hpp"
 #include "gui/settings_dialog.hpp"
+#include "gui/performance_panel.hpp"
+#include "gui/content_search_panel.hpp"
 #include <imgui.h>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <string>
@@ -40,6 +45,27 @@ private:
     void render_dialogs();
     void render_about_dialog();
     void setup_default_layout();
+    void prepare_model_viewer(const std::shared_ptr<AddonExtractor>& extractor);
+
+    // A file opened for the viewers: resolved and read on a worker, shown on the UI thread
+    struct OpenJob {
+        std::string path;
+        std::string ext;  // Lowercased
+        std::function<std::shared_ptr<AddonExtractor>()> resolve;  // Runs on the worker if set
+        std::shared_ptr<AddonExtractor> extractor;
+        std::string mesh_key;
+        uint32_t line = 0;  // Search hit: shown as text at this 1-based line
+        bool cached_mesh = false;
+        bool trace_capture = false;
+        bool finished = false;
+        std::vector<uint8_t> data;
+        std::string error;
+        CancellationToken cancel;
+    };
+
+    void start_open_job(std::shared_ptr<OpenJob> job);
+    void finish_open_job(OpenJob& job);
+    static void read_open_job(OpenJob& job);
 
     void open_addon_dialog();
     void open_addons_folder_dialog();
@@ -56,22 +82,30 @@ private:
     std::unique_ptr<FileBrowser> file_browser_;
     std::unique_ptr<TextureViewer> texture_viewer_;
     std::unique_ptr<ModelViewer> model_viewer_;
+    std::unique_ptr<SceneViewer> scene_viewer_;
     std::unique_ptr<TextViewer> text_viewer_;
     std::unique_ptr<ExportDialog> export_dialog_;
     std::unique_ptr<SettingsDialog> settings_dialog_;
+    std::unique_ptr<PerformancePanel> performance_panel_;
+    std::unique_ptr<ContentSearchPanel> content_search_;
 
     // Current addon
     fs::path current_addon_path_;
     std::string selected_file_path_;  // Path within PAK
+    std::shared_ptr<OpenJob> open_job_;
+    TaskHandle open_read_;
 
     // UI state
     bool show_addon_browser_ = true;
     bool show_file_browser_ = true;
     bool show_texture_viewer_ = true;
     bool show_model_viewer_ = true;
+    bool show_scene_viewer_ = true;
     bool show_text_viewer_ = true;
+    bool show_content_search_ = false;
     bool show_export_dialog_ = false;
     bool show_settings_ = false;
+    bool show_performance_ = false;
     bool show_about_ = false;
     bool reset_layout_ = false;
     ImGuiID dockspace_id_ = 0;
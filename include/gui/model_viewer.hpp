@@ -5,8 +5,13 @@
 #pragma once
 
 #include "enfusion/types.hpp"
+#include "enfusion/texture_resolver.hpp"
+#include "enfusion/memory.hpp"
+#include "enfusion/task_scheduler.hpp"
+#include "enfusion/mesh_cache.hpp"
 #include "renderer/mesh_renderer.hpp"
 #include "renderer/camera.hpp"
+#include "renderer/texture_uploader.hpp"
 #include <glm/glm.hpp>
 #include <memory>
 #include <filesystem>
@@ -14,6 +19,9 @@
 #include <vector>
 #include <cstdint>
 #include <functional>
+#include <atomic>
+#include <optional>
+#include <unordered_map>
 
 namespace enfusion {
 
@@ -31,8 +39,19 @@ public:
 
     /**
      * Load model from raw XOB data.
+     * Parsing and texture decoding run on workers; the GL upload happens
+     * on a later frame. Loading another model cancels this one.
+     * `cache_key` identifies the contents in the mesh cache; empty hashes
+     * the data instead. A cached mesh skips parsing, a parsed one is stored.
      */
-    void load_model_data(const std::vector<uint8_t>& data, const std::string& name);
+    void load_model_data(const std::vector<uint8_t>& data, const std::string& name,
+                         std::string cache_key = {});
+
+    /**
+     * Load a model straight from the mesh cache, without its XOB bytes.
+     * Check MeshCache::contains() first.
+     */
+    void load_cached_model(const std::string& cache_key, const std::string& name);
 
     /**
      * Load model from file path.
@@ -52,6 +71,15 @@ public:
     void set_texture_loader(std::function<std::vector<uint8_t>(const std::string&)> loader) {
         texture_loader_ = loader;
     }
+
+    /**
+     * Set a cheap existence check for texture candidates and the scope it
+     * covers (addon or install). Misses are cached per scope.
+     */
+    void set_texture_lookup(std::string scope, std::function<bool(const std::string&)> exists) {
+        texture_scope_ = std::move(scope);
+        texture_exists_ = std::move(exists);
+    }
     
     /**
      * Set available texture list for texture browser
@@ -61,13 +89,45 @@ public:
         filtered_textures_ = textures;
     }
 
+    /**
+     * Take over a trace capture the caller began for this load. It is written
+     * once the mesh and every material texture have arrived, or the load ends.
+     */
+    void finish_trace_capture_when_loaded() { trace_capture_ = true; }
+
 private:
     void render_toolbar();
     void render_info_bar();
     void ensure_framebuffer(int width, int height);
     void reset_camera();
     void set_view(float yaw, float pitch);
-    void calculate_bounds();
+
+    /**
+     * One model load. A worker maps the mesh from the cache or parses it,
+     * then a continuation on the UI thread does the GL upload and hands the
+     * materials to the texture resolver. Both tasks hold the job, so a
+     * cancelled one can simply be dropped.
+     */
+    struct LoadJob {
+        std::string name;
+        std::vector<uint8_t> data;
+        std::string cache_key;
+        CancellationToken cancel;
+
+        std::unique_ptr<CachedMesh> cached;  // Geometry stays in the mapping until upload
+        std::unique_ptr<XobMesh> mesh;
+        glm::vec3 bounds_min{0.0f};
+        glm::vec3 bounds_max{0.0f};
+        std::string error;
+    };
+
+    void start_load_job(std::shared_ptr<LoadJob> job);
+    void finish_load_job(LoadJob& job);
+    void poll_textures();
+    void cancel_load_job();
+    void install_mesh(LoadJob& job);
+
+    static void parse_model(LoadJob& job);
 
     std::unique_ptr<Camera> camera_;
     std::unique_ptr<MeshRenderer> renderer_;
@@ -94,6 +154,8 @@ private:
     // State
     bool model_loaded_ = false;
     bool loading_ = false;
+    bool loading_textures_ = false;
+    bool trace_capture_ = false;
     std::string error_message_;
 
     // Framebuffer
@@ -105,7 +167,14 @@ private:
     
     // Texture loading
     std::function<std::vector<uint8_t>(const std::string&)> texture_loader_;
-    uint32_t diffuse_texture_ = 0;
+    std::function<bool(const std::string&)> texture_exists_;
+    std::string texture_scope_;
+    TextureResolver texture_resolver_;
+    uint32_t diffuse_texture_ = 0;           // Picked by hand in the texture browser
+    std::vector<uint32_t> material_textures_;  // Resolved per material, 0 = none yet
+    TextureUploader texture_uploader_{"Model viewer textures"};
+    std::unordered_map<TextureUploader::Ticket, size_t> material_uploads_;  // Ticket -> material
+    TextureUploader::Ticket picked_upload_ = 0;
     
     // Texture browser
     std::vector<std::string> available_textures_;
@@ -115,8 +184,15 @@ private:
     int selected_texture_idx_ = -1;
     bool show_texture_browser_ = false;
     
-    void load_material_textures();
+    std::shared_ptr<LoadJob> job_;
+
+    // The GPU has its own copy once uploaded; over budget the CPU one goes
+    memory::Account mesh_account_{memory::Subsystem::Meshes, "Model viewer"};
+    uint64_t mesh_enforcer_ = 0;
+
     void destroy_textures();
+    void finish_trace_capture();
+    void release_cpu_geometry();
     void apply_texture(const std::string& path);
     void render_texture_browser();
     void filter_textures();
@@ -0,0 +1,36 @@
+﻿/**
+ * Enfusion Unpacker - Performance Panel
+ */
+
+#pragma once
+
+#include "enfusion/metrics.hpp"
+#include "enfusion/trace.hpp"
+#include "enfusion/memory.hpp"
+#include <string>
+
+namespace enfusion {
+
+/**
+ * Live view of the metrics registry: counters, latency percentiles and
+ * cache hit rates, with reset and JSON export. Also shows memory use per
+ * subsystem against its budget, and starts, stops and saves span traces.
+ */
+class PerformancePanel {
+public:
+    void render();
+
+private:
+    void render_counters(const metrics::Snapshot& snap);
+    void render_latencies(const metrics::Snapshot& snap);
+    void render_hit_rates(const metrics::Snapshot& snap);
+    void render_memory();
+    void render_tracing();
+
+    std::string format_size(uint64_t bytes) const;
+
+    char export_path_[260] = "enfusion_metrics.json";
+    char trace_path_[260] = "enfusion_trace.json";
+};
+
+} // namespace enfusion
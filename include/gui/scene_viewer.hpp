@@ -0,0 +1,104 @@
+﻿/**
+ * Enfusion Unpacker - Scene Viewer Panel
+ */
+
+#pragma once
+
+#include "enfusion/task_scheduler.hpp"
+#include "renderer/scene_renderer.hpp"
+#include <glm/glm.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace enfusion {
+
+class Camera;
+class MeshRenderer;
+
+/**
+ * Panel for viewing prefabs (.et) and world layers (.ent, .layer) as a
+ * whole, with every placed XOB drawn through the instanced renderer.
+ */
+class SceneViewer {
+public:
+    using FileLoader = std::function<std::vector<uint8_t>(const std::string&)>;
+
+    SceneViewer();
+    ~SceneViewer();
+
+    void render();
+
+    /**
+     * Parse the entity text and load every mesh it places on worker threads.
+     * The loader resolves base prefabs and XOBs by virtual path and must be
+     * safe to call from several threads at once.
+     */
+    void load_scene_data(const std::vector<uint8_t>& data, const std::string& name, FileLoader loader);
+
+    void clear();
+
+    bool has_scene() const { return scene_loaded_; }
+
+private:
+    struct LoadJob {
+        std::atomic<bool> cancel{false};
+        std::atomic<size_t> meshes_done{0};
+        std::atomic<size_t> meshes_total{0};
+
+        std::string text;
+        FileLoader loader;
+        Task<void> future;
+
+        std::vector<SceneMesh> meshes;
+        std::vector<MeshInstance> instances;
+        size_t prefab_count = 0;
+        size_t missing_prefabs = 0;
+        size_t missing_meshes = 0;
+        std::string error;
+    };
+
+    static void build_scene(LoadJob& job);
+    static bool load_mesh(const std::vector<uint8_t>& data, SceneMesh& mesh);
+
+    void poll_load_job();
+    void cancel_load_job();
+    void reset_camera();
+    void ensure_framebuffer(int width, int height);
+    void render_toolbar();
+    void render_info_bar();
+
+    std::unique_ptr<Camera> camera_;
+    std::unique_ptr<SceneRenderer> renderer_;
+    std::unique_ptr<MeshRenderer> grid_;  // Only draws the ground grid
+
+    std::string scene_name_;
+    bool scene_loaded_ = false;
+    bool loading_ = false;
+    std::string error_message_;
+    size_t mesh_count_ = 0;
+    size_t prefab_count_ = 0;
+    size_t missing_prefabs_ = 0;
+    size_t missing_meshes_ = 0;
+
+    // View settings
+    bool show_wireframe_ = false;
+    bool show_grid_ = true;
+    float lod_bias_ = 1.0f;
+    glm::vec3 bg_color_{0.15f, 0.15f, 0.18f};
+
+    // Framebuffer
+    uint32_t fbo_ = 0;
+    uint32_t fb_texture_ = 0;
+    uint32_t fb_depth_ = 0;
+    int fb_width_ = 0;
+    int fb_height_ = 0;
+
+    std::shared_ptr<LoadJob> job_;
+    std::vector<std::shared_ptr<LoadJob>> retired_jobs_;
+};
+
+} // namespace enfusion
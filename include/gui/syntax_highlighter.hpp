@@ -0,0 +1,86 @@
+/**
+ * Enfusion Unpacker - Syntax Highlighter
+ *
+ * Line-at-a-time lexer for Enforce script and Enfusion config text.
+ * Token spans are cached per line along with the lexer state the line
+ * starts in, so only lines that are actually drawn ever get tokenized.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace enfusion {
+
+enum class TokenKind : uint8_t {
+    Text,
+    Keyword,
+    Type,
+    Comment,
+    String,
+    Number,
+    Preprocessor
+};
+
+struct Token {
+    uint32_t start = 0;   // Byte offset within the line
+    uint32_t length = 0;
+    TokenKind kind = TokenKind::Text;
+};
+
+class SyntaxHighlighter {
+public:
+    enum class Language {
+        None,
+        EnforceScript,  // .c
+        Config          // .et, .conf, .layout, .meta
+    };
+
+    /** Supplies the text of a line (without its newline). */
+    using LineSource = std::function<std::string_view(size_t)>;
+
+    static Language language_for(const std::string& filename);
+
+    void reset(Language language, size_t line_count, LineSource source);
+    Language language() const { return language_; }
+
+    /**
+     * Tokens covering the whole of a line.
+     * Lexes the line on first use; lines above it are only scanned for
+     * state (open block comments), never stored.
+     */
+    const std::vector<Token>& tokens(size_t line);
+
+    /**
+     * A line's text changed: drop its tokens and re-derive entry states
+     * from there. Later lines keep their tokens unless their entry state
+     * turns out different.
+     */
+    void invalidate_from(size_t line);
+
+private:
+    enum class LexState : uint8_t {
+        Normal,
+        BlockComment
+    };
+
+    struct CachedLine {
+        std::vector<Token> tokens;
+        LexState entry = LexState::Normal;
+        bool tokens_valid = false;
+    };
+
+    void ensure_entry_state(size_t line);
+    LexState lex_line(std::string_view text, LexState state, std::vector<Token>* out) const;
+
+    Language language_ = Language::None;
+    LineSource source_;
+    std::vector<CachedLine> lines_;
+    size_t states_known_ = 0;  // Entry state is valid for lines [0, states_known_)
+};
+
+} // namespace enfusion
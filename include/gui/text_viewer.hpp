@@ -5,7 +5,9 @@
 #pragma once
 
 #include "enfusion/types.hpp"
+#include "gui/syntax_highlighter.hpp"
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace enfusion {
@@ -19,15 +21,38 @@ public:
     void render();
     void clear();
 
+    /** Scroll so a (0-based) line is centred on the next frame. */
+    void goto_line(size_t line);
+
     bool has_content() const { return !text_.empty(); }
     const std::string& filename() const { return filename_; }
 
 private:
     void render_toolbar();
+    void render_line(size_t line, bool wrap);
+
+    void build_line_index();
+    std::string_view line_text(size_t line) const;
+    size_t line_for_offset(size_t offset) const;
+
+    void run_search();
+    void goto_match(int index);
+
+    // Wrapped lines have varying heights, which the clipper cannot skip over
+    static constexpr size_t WRAP_LINE_LIMIT = 5000;
+    static constexpr size_t MAX_SEARCH_MATCHES = 100000;
 
     std::string text_;
     std::string filename_;
-    bool word_wrap_ = true;
+    std::vector<size_t> line_starts_;  // Offset of each line's first byte in text_
+    SyntaxHighlighter highlighter_;
+
+    std::string search_query_;
+    std::vector<size_t> matches_;      // Offsets of matches in text_
+    int current_match_ = -1;
+    int scroll_to_line_ = -1;
+
+    bool word_wrap_ = false;
     bool show_line_numbers_ = true;
     bool scroll_to_top_ = false;
     float font_size_ = 14.0f;
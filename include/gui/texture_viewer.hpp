@@ -5,7 +5,9 @@
 #pragma once
 
 #include "enfusion/types.hpp"
+#include "renderer/texture_uploader.hpp"
 #include <memory>
+#include <optional>
 #include <string>
 #include <filesystem>
 #include <vector>
@@ -47,8 +49,21 @@ private:
     void render_channel_selector();
     void render_info_bar();
 
+    // EDDS/DDS decode runs on a worker; the pixels are queued for upload on the UI thread
+    struct DecodeJob {
+        std::vector<uint8_t> data;
+        std::optional<TextureData> texture;
+        std::string error;
+        CancellationToken cancel;
+    };
+
+    static void decode_texture(DecodeJob& job);
+    void finish_decode(DecodeJob& job);
+    void cancel_decode();
+
     bool parse_dds(const std::vector<uint8_t>& data);
     void create_gl_texture();
+    void poll_upload();
     void destroy_gl_texture();
     void fit_to_view(float view_width, float view_height);
 
@@ -61,6 +76,9 @@ private:
     bool loading_ = false;
     std::string error_message_;
     uint32_t texture_id_ = 0;
+    std::shared_ptr<DecodeJob> decode_job_;
+    TextureUploader uploader_{"Texture viewer"};
+    TextureUploader::Ticket upload_ticket_ = 0;  // Upload still in flight, 0 if none
     uint32_t width_ = 0;
     uint32_t height_ = 0;
     uint32_t channels_ = 4;
@@ -0,0 +1,50 @@
+﻿/**
+ * Enfusion Unpacker - Reusable GPU buffer
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace enfusion {
+
+/**
+ * OpenGL buffer object that keeps its storage across uploads.
+ *
+ * Storage only ever grows. An upload that fits orphans the old contents and
+ * writes into the existing allocation with glBufferSubData, so switching
+ * between meshes of similar size does not allocate on the driver side.
+ */
+class GpuBuffer {
+public:
+    explicit GpuBuffer(uint32_t target);
+    ~GpuBuffer();
+
+    GpuBuffer(const GpuBuffer&) = delete;
+    GpuBuffer& operator=(const GpuBuffer&) = delete;
+
+    /** Bind to the buffer's target and replace its contents. */
+    void upload(const void* data, size_t bytes);
+
+    void bind() const;
+
+    /** Delete the GL object. Needs a current context. */
+    void release();
+
+    uint32_t id() const { return id_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    size_t reallocations() const { return reallocations_; }
+
+private:
+    static constexpr size_t GRANULARITY = 64 * 1024;
+
+    uint32_t target_;
+    uint32_t id_ = 0;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    size_t reallocations_ = 0;
+};
+
+} // namespace enfusion
@@ -5,7 +5,10 @@
 #pragma once
 
 #include "enfusion/types.hpp"
+#include "renderer/gpu_buffer.hpp"
 #include <memory>
+#include <span>
+#include <vector>
 
 namespace enfusion {
 
@@ -23,7 +26,21 @@ public:
     void cleanup();
 
     void set_mesh(const XobMesh* mesh);
+
+    /**
+     * Draw `mesh` (LODs and material ranges) using geometry that lives
+     * elsewhere, e.g. a mapped mesh cache entry. The spans are only read
+     * during this call; the mesh must outlive the renderer's use of it.
+     */
+    void set_mesh(const XobMesh* mesh, std::span<const XobVertex> vertices,
+                  std::span<const uint32_t> indices);
+
+    /** Texture drawn over the whole mesh, ignoring materials. 0 clears it. */
     void set_texture(uint32_t texture_id) { diffuse_texture_ = texture_id; }
+
+    /** Diffuse texture per material index; 0 draws that material untextured. */
+    void set_material_textures(std::vector<uint32_t> textures);
+
     void render(const glm::mat4& view, const glm::mat4& projection);
 
     // Render option setters
@@ -40,16 +57,29 @@ public:
     float grid_size() const { return grid_size_; }
 
 private:
-    void upload_mesh();
+    /**
+     * Index ranges of the current LOD that share a texture.
+     * Drawn with a single glMultiDrawElements call.
+     */
+    struct DrawBatch {
+        uint32_t texture = 0;
+        std::vector<int32_t> counts;
+        std::vector<const void*> offsets;
+        size_t end_index = 0;  // One past the last index, for merging adjacent ranges
+    };
+
+    void upload_mesh(std::span<const XobVertex> vertices, std::span<const uint32_t> indices);
+    void build_batches();
+    void lod_span(size_t& offset, size_t& count) const;
     void create_grid();
     void render_mesh(const glm::mat4& view, const glm::mat4& projection);
     void render_grid(const glm::mat4& view, const glm::mat4& projection);
     void render_normals(const glm::mat4& view, const glm::mat4& projection);
 
-    // Mesh buffers
+    // Mesh buffers, reused across meshes
     uint32_t vao_ = 0;
-    uint32_t vbo_ = 0;
-    uint32_t ebo_ = 0;
+    GpuBuffer vertex_buffer_;
+    GpuBuffer index_buffer_;
 
     // Grid buffers
     uint32_t grid_vao_ = 0;
@@ -73,6 +103,12 @@ private:
     
     // Textures
     uint32_t diffuse_texture_ = 0;
+    std::vector<uint32_t> material_textures_;
+
+    // Per-material draws, rebuilt when the mesh, LOD or textures change
+    std::vector<DrawBatch> batches_;
+    bool batches_dirty_ = true;
+    int batched_lod_ = -1;
 };
 
 } // namespace enfusion
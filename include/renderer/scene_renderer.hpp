@@ -0,0 +1,122 @@
+﻿/**
+ * Enfusion Unpacker - Instanced scene renderer
+ */
+
+#pragma once
+
+#include "enfusion/types.hpp"
+#include "renderer/gpu_buffer.hpp"
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace enfusion {
+
+class Shader;
+
+/**
+ * Geometry of one distinct XOB in a scene. LOD spans index into this
+ * mesh's own vertex and index arrays.
+ */
+struct SceneMesh {
+    struct Lod {
+        uint32_t first_index = 0;
+        uint32_t index_count = 0;
+        int32_t base_vertex = 0;
+    };
+
+    std::string path;
+    std::vector<XobVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Lod> lods;  // Most detailed first
+    glm::vec3 center{0.0f};
+    float radius = 0.0f;
+};
+
+struct MeshInstance {
+    uint32_t mesh = 0;
+    glm::mat4 transform{1.0f};
+};
+
+/**
+ * Draws many placements of a few meshes.
+ *
+ * All meshes share one vertex and one index buffer. Each frame the
+ * instances are frustum culled, given a LOD from their projected size,
+ * and bucketed by (mesh, LOD). Every bucket is one instanced draw fed from
+ * a single per-frame instance buffer.
+ */
+class SceneRenderer {
+public:
+    static constexpr int MAX_LODS = 4;
+
+    struct Stats {
+        size_t instances = 0;
+        size_t visible = 0;
+        size_t draw_calls = 0;
+        size_t triangles = 0;
+    };
+
+    SceneRenderer();
+    ~SceneRenderer();
+
+    void init();
+    void cleanup();
+
+    /** Upload all geometry at once; the CPU copies are released afterwards. */
+    void set_scene(std::vector<SceneMesh> meshes, std::vector<MeshInstance> instances);
+    void clear();
+
+    void render(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& eye);
+
+    void set_wireframe(bool enable) { wireframe_ = enable; }
+    void set_lod_bias(float bias) { lod_bias_ = bias; }
+
+    bool empty() const { return instances_.empty(); }
+    const Stats& stats() const { return stats_; }
+    glm::vec3 bounds_min() const { return bounds_min_; }
+    glm::vec3 bounds_max() const { return bounds_max_; }
+
+private:
+    struct MeshRecord {
+        std::vector<SceneMesh::Lod> lods;  // Rebased into the shared buffers
+        float radius = 0.0f;
+    };
+
+    struct InstanceRecord {
+        uint32_t mesh = 0;
+        glm::mat4 transform{1.0f};
+        glm::vec3 center{0.0f};  // World-space bounding sphere
+        float radius = 0.0f;
+    };
+
+    int choose_lod(const MeshRecord& mesh, float radius, float distance) const;
+    void point_instance_attributes(size_t first_instance);
+
+    // Projected size (radius / distance) below which the next LOD is used
+    static constexpr std::array<float, MAX_LODS - 1> LOD_THRESHOLDS = {0.3f, 0.1f, 0.03f};
+    static constexpr uint32_t CULLED = UINT32_MAX;
+
+    uint32_t vao_ = 0;
+    GpuBuffer vertex_buffer_;
+    GpuBuffer index_buffer_;
+    GpuBuffer instance_buffer_;
+
+    std::vector<MeshRecord> meshes_;
+    std::vector<InstanceRecord> instances_;
+    glm::vec3 bounds_min_{0.0f};
+    glm::vec3 bounds_max_{0.0f};
+
+    // Per-frame scratch, kept between frames to avoid reallocating
+    std::vector<uint32_t> instance_keys_;
+    std::vector<uint32_t> bucket_offsets_;
+    std::vector<glm::mat4> instance_data_;
+
+    std::unique_ptr<Shader> shader_;
+    bool wireframe_ = false;
+    float lod_bias_ = 1.0f;
+    Stats stats_;
+};
+
+} // namespace enfusion
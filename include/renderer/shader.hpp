@@ -44,6 +44,7 @@ public:
     // Built-in shader sources
     static const char* MESH_VERTEX_SHADER;
     static const char* MESH_FRAGMENT_SHADER;
+    static const char* INSTANCED_VERTEX_SHADER;  // Per-instance model matrix at locations 3-6
     static const char* GRID_VERTEX_SHADER;
     static const char* GRID_FRAGMENT_SHADER;
 
@@ -0,0 +1,105 @@
+﻿/**
+ * Enfusion Unpacker - Asynchronous texture uploads
+ */
+
+#pragma once
+
+#include "enfusion/types.hpp"
+#include "enfusion/memory.hpp"
+#include "enfusion/task_scheduler.hpp"
+#include <array>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+namespace enfusion {
+
+/**
+ * Streams decoded textures to the GPU through a small ring of pixel buffer
+ * objects.
+ *
+ * Pixels are copied into a mapped PBO on a worker thread. The GL thread then
+ * only unmaps, starts the transfer with glTexImage2D from the PBO, and drops
+ * a fence. A slot is reused once its fence has signalled, and the frame
+ * never waits on a copy or an upload.
+ */
+class TextureUploader {
+public:
+    using Ticket = uint64_t;
+
+    struct Finished {
+        Ticket ticket = 0;
+        uint32_t texture = 0;  // Owned by the caller from here on
+        uint32_t width = 0;
+        uint32_t height = 0;
+        bool failed = false;   // Could not be staged; texture is 0
+    };
+
+    explicit TextureUploader(std::string label = "Texture uploads")
+        : account_(memory::Subsystem::Textures, std::move(label)) {}
+    ~TextureUploader();
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    /** Queue decoded pixels. Safe from any thread. */
+    Ticket enqueue(TextureData texture);
+
+    /** Advance every upload in flight. Call once per frame on the GL thread. */
+    void pump();
+
+    /** Textures whose upload has been issued (or has failed) since the last call. */
+    std::vector<Finished> take_finished();
+
+    /** Drop everything queued or in flight; their textures are never handed out. */
+    void discard();
+
+    /** Wait for outstanding copies and delete the GL objects. Needs a current context. */
+    void cleanup();
+
+    bool is_busy() const;
+
+private:
+    enum class SlotState { Free, Filling, Fenced };
+
+    struct Slot {
+        SlotState state = SlotState::Free;
+        uint32_t pbo = 0;
+        size_t capacity = 0;
+        void* fence = nullptr;  // GLsync
+        Ticket ticket = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t channels = 4;
+        bool discarded = false;
+        size_t staged_bytes = 0;  // Pixels held by the fill worker
+        Task<void> fill;
+    };
+
+    struct Pending {
+        Ticket ticket = 0;
+        TextureData texture;
+    };
+
+    bool start_fill(Slot& slot, Pending& pending);
+    void finish_fill(Slot& slot);
+    void release_slot(Slot& slot);
+
+    static constexpr size_t RING_SIZE = 3;
+    static constexpr size_t INLINE_COPY_LIMIT = 1024 * 1024;   // Smaller copies skip the worker
+    static constexpr size_t KEEP_CAPACITY = 64 * 1024 * 1024;  // Larger staging is freed after use
+
+    std::array<Slot, RING_SIZE> ring_;
+
+    mutable std::mutex mutex_;
+    std::deque<Pending> pending_;
+    Ticket next_ticket_ = 1;
+
+    std::vector<Finished> finished_;
+
+    // Decoded pixels not yet copied into a PBO
+    memory::Account account_;
+};
+
+} // namespace enfusion
@@ -10,6 +10,9 @@
 #include "enfusion/addon_extractor.hpp"
 #include "enfusion/compression.hpp"
 #include "enfusion/files.hpp"
+#include "enfusion/path_utils.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/trace.hpp"
 
 #include <nlohmann/json.hpp>
 #include <fstream>
@@ -20,16 +23,43 @@
 namespace enfusion {
 
 AddonExtractor::AddonExtractor() = default;
-AddonExtractor::~AddonExtractor() = default;
 
-bool AddonExtractor::load(const std::filesystem::path& addon_dir) {
+AddonExtractor::~AddonExtractor() {
+    // Background indexing reads our members; stop it and let it finish first
+    cancel_index_ = true;
+    if (index_future_.valid()) {
+        index_future_.cancel();
+        index_future_.wait();
+    }
+}
+
+Result<void> AddonExtractor::load(const std::filesystem::path& addon_dir) {
+    TRY(open(addon_dir));
+    return ensure_indexed();
+}
+
+Result<void> AddonExtractor::open(const std::filesystem::path& addon_dir) {
+    TRY(locate_files(addon_dir));
+    
+    // Parse RDB - this is all the file list needs
+    if (!parse_rdb()) return Error::parse_error("Invalid resource database", rdb_path_.string());
+    update_accounts();
+    
+    loaded_ = true;
+    return Result<void>::success();
+}
+
+Result<void> AddonExtractor::locate_files(const std::filesystem::path& addon_dir) {
     addon_dir_ = addon_dir;
     pak_path_ = addon_dir / "data.pak";
+    pak_account_.set_label(addon_dir.filename().string());
+    list_account_.set_label(addon_dir.filename().string());
     rdb_path_ = addon_dir / "resourceDatabase.rdb";
     
     // Find manifest file (data.pak_*_manifest.json)
     manifest_path_.clear();
-    for (const auto& entry : std::filesystem::directory_iterator(addon_dir)) {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(addon_dir, ec)) {
         auto name = entry.path().filename().string();
         if (name.find("data.pak_") != std::string::npos && 
             name.find("_manifest.json") != std::string::npos) {
@@ -37,88 +67,150 @@ bool AddonExtractor::load(const std::filesystem::path& addon_dir) {
             break;
         }
     }
+    if (ec) return Error::io_error(ec.message(), addon_dir.string());
+    
+    if (!std::filesystem::exists(pak_path_)) return Error::file_not_found(pak_path_.string());
+    if (!std::filesystem::exists(rdb_path_)) return Error::file_not_found(rdb_path_.string());
+    if (manifest_path_.empty() || !std::filesystem::exists(manifest_path_)) {
+        return Error::file_not_found((addon_dir / "data.pak_*_manifest.json").string());
+    }
+    
+    return Result<void>::success();
+}
+
+Result<void> AddonExtractor::ensure_indexed() {
+    if (!loaded_) return Error(Error::Code::InvalidArgument, "Addon not opened");
     
-    if (!std::filesystem::exists(pak_path_)) return false;
-    if (!std::filesystem::exists(rdb_path_)) return false;
-    if (manifest_path_.empty() || !std::filesystem::exists(manifest_path_)) return false;
+    std::call_once(index_once_, [this]() {
+        auto result = build_index();
+        if (!result) {
+            index_error_ = result.error();
+        }
+        update_accounts();
+        indexed_ = true;
+    });
+    
+    if (index_error_) return *index_error_;
+    return Result<void>::success();
+}
+
+void AddonExtractor::index_async() {
+    if (!loaded_ || indexed_ || index_future_.valid()) return;
+    index_future_ = TaskScheduler::instance().async(TaskPriority::Prefetch, [this]() { ensure_indexed(); });
+}
+
+Result<void> AddonExtractor::build_index() {
+    static auto& index_time = metrics::histogram("addon.index");
+    static auto& bytes_read = metrics::counter("addon.bytes_read");
+    metrics::ScopedTimer timer(index_time);
+    TRACE_SPAN(span, "addon.index");
+    TRACE_ARG(span, "path", pak_path_.string());
     
     // Load PAK data
-    pak_data_ = enfusion::read_file(pak_path_);
-    if (pak_data_.empty()) return false;
+    // Chunked so dropping an extractor mid-index doesn't wait for a multi-GB read
+    pak_data_ = enfusion::read_file(pak_path_, cancel_index_);
+    if (cancel_index_) return Error(Error::Code::Unknown, "Indexing cancelled");
+    if (pak_data_.empty()) return Error::io_error("Failed to read PAK", pak_path_.string());
+    bytes_read.add(pak_data_.size());
     
     // Load manifest first (needed for decompressed size index)
-    if (!load_manifest()) return false;
+    if (!load_manifest()) return Error::parse_error("Invalid manifest", manifest_path_.string());
     
     // Build decompressed size index
     build_decompressed_index();
+    if (cancel_index_) return Error(Error::Code::Unknown, "Indexing cancelled");
     
     // Index special fragments
     index_special_fragments();
     
-    // Parse RDB
-    if (!parse_rdb()) return false;
-    
-    loaded_ = true;
-    return true;
+    return Result<void>::success();
+}
+
+void AddonExtractor::update_accounts() {
+    pak_account_.set(pak_data_.capacity());
+
+    // Approximate: container storage plus heap-allocated strings. Map nodes
+    // are counted as their payload plus three pointers of overhead.
+    constexpr size_t NODE_OVERHEAD = 3 * sizeof(void*);
+    size_t lists = memory::heap_bytes(files_) + memory::heap_bytes(fragments_);
+    for (const auto& file : files_) lists += memory::heap_bytes(file.path);
+    for (const auto& frag : fragments_) lists += memory::heap_bytes(frag.sha512);
+    for (const auto& [path, index] : path_index_) {
+        lists += sizeof(std::pair<const std::string, size_t>) + NODE_OVERHEAD + memory::heap_bytes(path);
+    }
+    lists += path_index_.bucket_count() * sizeof(void*);
+    for (const auto& [size, indices] : size_to_fragments_) {
+        lists += sizeof(std::pair<const uint32_t, std::vector<int>>) + NODE_OVERHEAD + memory::heap_bytes(indices);
+    }
+    for (const auto& [size, entries] : decompressed_sizes_) {
+        lists += sizeof(std::pair<const size_t, std::vector<std::tuple<int, uint64_t, uint32_t>>>) + NODE_OVERHEAD +
+                 memory::heap_bytes(entries);
+    }
+    list_account_.set(lists);
 }
 
 bool AddonExtractor::load_manifest() {
-    try {
-        std::ifstream f(manifest_path_);
-        if (!f.is_open()) return false;
-        
-        nlohmann::json data = nlohmann::json::parse(f);
+    std::ifstream f(manifest_path_);
+    if (!f.is_open()) return false;
+    
+    // Non-throwing parse; malformed manifests come back discarded
+    nlohmann::json data = nlohmann::json::parse(f, nullptr, false);
+    if (data.is_discarded() || !data.is_object()) return false;
+    
+    fragments_.clear();
+    size_to_fragments_.clear();
+    
+    if (!data.contains("fragments") || !data["fragments"].is_array()) return false;
+    
+    auto& frags = data["fragments"];
+    fragments_.reserve(frags.size());
+    for (size_t i = 0; i < frags.size(); ++i) {
+        const auto& entry = frags[i];
+        if (!entry.is_object() || !entry.contains("size") || !entry["size"].is_number_unsigned()) {
+            return false;
+        }
         
-        fragments_.clear();
-        size_to_fragments_.clear();
+        ManifestFragment frag;
+        frag.index = static_cast<int>(i);
+        frag.size = entry["size"].get<uint32_t>();
         
-        if (!data.contains("fragments")) return false;
+        // Handle 'offsets' array format (from v2 code)
+        if (entry.contains("offsets") && entry["offsets"].is_array() && !entry["offsets"].empty() &&
+            entry["offsets"].front().is_number_unsigned()) {
+            frag.offset = entry["offsets"].front().get<uint64_t>();
+        } else if (entry.contains("offset") && entry["offset"].is_number_unsigned()) {
+            frag.offset = entry["offset"].get<uint64_t>();
+        } else {
+            frag.offset = 0;
+        }
         
-        auto& frags = data["fragments"];
-        for (size_t i = 0; i < frags.size(); ++i) {
-            ManifestFragment frag;
-            frag.index = static_cast<int>(i);
-            frag.size = frags[i]["size"].get<uint32_t>();
-            
-            // Handle 'offsets' array format (from v2 code)
-            if (frags[i].contains("offsets") && !frags[i]["offsets"].empty()) {
-                frag.offset = frags[i]["offsets"][0].get<uint64_t>();
-            } else if (frags[i].contains("offset")) {
-                frag.offset = frags[i]["offset"].get<uint64_t>();
-            } else {
-                frag.offset = 0;
-            }
-            
-            if (frags[i].contains("sha512")) {
-                frag.sha512 = frags[i]["sha512"].get<std::string>();
-            }
-            
-            fragments_.push_back(frag);
-            size_to_fragments_[frag.size].push_back(static_cast<int>(fragments_.size() - 1));
+        if (entry.contains("sha512") && entry["sha512"].is_string()) {
+            frag.sha512 = entry["sha512"].get<std::string>();
         }
         
-        return true;
-    } catch (...) {
-        return false;
+        fragments_.push_back(frag);
+        size_to_fragments_[frag.size].push_back(static_cast<int>(fragments_.size() - 1));
     }
+    
+    return true;
 }
 
 void AddonExtractor::build_decompressed_index() {
     decompressed_sizes_.clear();
     
     for (const auto& frag : fragments_) {
+        if (cancel_index_) return;
         if (frag.offset + frag.size > pak_data_.size()) continue;
         
         const uint8_t* data = pak_data_.data() + frag.offset;
         
         // Check for ZLIB header (0x78 0x9c specifically, per v2 code)
         if (frag.size >= 2 && data[0] == 0x78 && data[1] == 0x9c) {
-            try {
-                auto decompressed = decompress_zlib(data, frag.size, frag.size * 20);
-                if (!decompressed.empty()) {
-                    decompressed_sizes_[decompressed.size()].push_back({frag.index, frag.offset, frag.size});
-                }
-            } catch (...) {}
+            // Only the decompressed size is needed; corrupt fragments are just skipped
+            auto decompressed_size = measure_zlib(data, frag.size, static_cast<size_t>(frag.size) * 20);
+            if (decompressed_size && *decompressed_size > 0) {
+                decompressed_sizes_[*decompressed_size].push_back({frag.index, frag.offset, frag.size});
+            }
         }
     }
 }
@@ -283,43 +375,82 @@ bool AddonExtractor::parse_rdb() {
         entry_idx++;
     }
     
+    path_index_.clear();
+    path_index_.reserve(files_.size());
+    for (size_t i = 0; i < files_.size(); ++i) {
+        path_index_.emplace(normalize_path(files_[i].path), i);
+    }
+    
     return !files_.empty();
 }
 
+const RdbFile* AddonExtractor::find_file(const std::string& path) const {
+    auto it = path_index_.find(normalize_path(path));
+    return it != path_index_.end() ? &files_[it->second] : nullptr;
+}
+
 std::vector<RdbFile> AddonExtractor::list_files() const {
     return files_;
 }
 
-std::vector<uint8_t> AddonExtractor::read_file(const RdbFile& file) {
+Result<std::vector<uint8_t>> AddonExtractor::read_file(const RdbFile& file) {
+    static auto& read_time = metrics::histogram("addon.read_file");
+    static auto& bytes_decompressed = metrics::counter("addon.bytes_decompressed");
+    
+    TRY(ensure_indexed());
+    metrics::ScopedTimer timer(read_time);
+    TRACE_SPAN(span, "addon.read_file");
+    TRACE_ARG(span, "path", file.path);
+    TRACE_ARG(span, "bytes", file.size);
+    
     auto location = find_file_location(file.size, file.path);
-    if (!location) return {};
+    if (!location) {
+        return Error::file_not_found(file.path);
+    }
     
-    auto [offset, size, is_compressed] = *location;
+    auto [fragment, offset, size, is_compressed] = *location;
     
-    if (offset + size > pak_data_.size()) return {};
+    if (offset + size > pak_data_.size()) {
+        return Error::invalid_format("Fragment outside PAK bounds", file.path);
+    }
     
+    const uint8_t* data = pak_data_.data() + offset;
     if (is_compressed) {
-        const uint8_t* data = pak_data_.data() + offset;
-        try {
-            return decompress_zlib(data, size, file.size * 2);
-        } catch (...) {
-            return {};
+        auto decompressed = decompress_zlib(data, size, static_cast<size_t>(file.size) * 2);
+        if (!decompressed) {
+            return Error(decompressed.error().code, decompressed.error().message, file.path);
         }
-    } else {
-        return std::vector<uint8_t>(pak_data_.begin() + offset, pak_data_.begin() + offset + size);
+        bytes_decompressed.add(decompressed->size());
+        return decompressed;
     }
+    
+    return std::vector<uint8_t>(data, data + size);
 }
 
-std::vector<uint8_t> AddonExtractor::read_file(const std::string& path) {
-    for (const auto& file : files_) {
-        if (file.path == path) {
-            return read_file(file);
-        }
+Result<std::vector<uint8_t>> AddonExtractor::read_file(const std::string& path) {
+    static auto& lookup_hits = metrics::counter("addon.lookup.hits");
+    static auto& lookup_misses = metrics::counter("addon.lookup.misses");
+    
+    if (const RdbFile* file = find_file(path)) {
+        lookup_hits.add();
+        return read_file(*file);
+    }
+    lookup_misses.add();
+    return Error::file_not_found(path);
+}
+
+std::string AddonExtractor::content_key(const std::string& path) {
+    const RdbFile* file = find_file(path);
+    if (!file || !ensure_indexed()) return {};
+    
+    auto location = find_file_location(file->size, file->path);
+    if (!location || location->fragment < 0 || location->fragment >= static_cast<int>(fragments_.size())) {
+        return {};
     }
-    return {};
+    return fragments_[location->fragment].sha512;
 }
 
-std::optional<std::tuple<uint64_t, uint32_t, bool>> AddonExtractor::find_file_location(
+std::optional<AddonExtractor::FileLocation> AddonExtractor::find_file_location(
     uint32_t file_size, const std::string& path) {
     
     std::string path_lower = path;
@@ -331,28 +462,29 @@ std::optional<std::tuple<uint64_t, uint32_t, bool>> AddonExtractor::find_file_lo
     if (is_xob && file_size < 100 && !xob_fragments_.empty()) {
         int idx = xob_fragments_[0];
         const auto& frag = fragments_[idx];
-        return std::make_tuple(frag.offset, frag.size, false);
+        return FileLocation{idx, frag.offset, frag.size, false};
     }
     
     // Check single fragment match (uncompressed)
     auto it = size_to_fragments_.find(file_size);
     if (it != size_to_fragments_.end() && !it->second.empty()) {
-        const auto& frag = fragments_[it->second[0]];
-        return std::make_tuple(frag.offset, frag.size, false);
+        int idx = it->second[0];
+        const auto& frag = fragments_[idx];
+        return FileLocation{idx, frag.offset, frag.size, false};
     }
     
     // Check compressed fragment match (decompressed size)
     auto dit = decompressed_sizes_.find(file_size);
     if (dit != decompressed_sizes_.end() && !dit->second.empty()) {
         auto& [idx, offset, size] = dit->second[0];
-        return std::make_tuple(offset, size, true);
+        return FileLocation{idx, offset, size, true};
     }
     
     // For prefab files, use prefab fragment fallback
     if (is_prefab && !prefab_fragments_.empty()) {
         int idx = prefab_fragments_[0];
         const auto& frag = fragments_[idx];
-        return std::make_tuple(frag.offset, frag.size, false);
+        return FileLocation{idx, frag.offset, frag.size, false};
     }
     
     return std::nullopt;
@@ -360,30 +492,34 @@ std::optional<std::tuple<uint64_t, uint32_t, bool>> AddonExtractor::find_file_lo
 
 bool AddonExtractor::extract_file(const RdbFile& file, const std::filesystem::path& output_path) {
     auto data = read_file(file);
-    if (data.empty()) return false;
+    if (!data || data->empty()) return false;
     
     std::filesystem::create_directories(output_path.parent_path());
-    return enfusion::write_file(output_path, data);
+    return enfusion::write_file(output_path, *data);
 }
 
 bool AddonExtractor::extract_all(const std::filesystem::path& output_dir, 
                                   std::function<bool(const std::string&, size_t, size_t)> callback) {
+    if (!ensure_indexed()) return false;
+    
+    // read_file() is safe to call concurrently once the addon is indexed
     size_t total = files_.size();
     size_t current = 0;
+    std::mutex callback_mutex;
+    CancellationToken stop;
     
-    for (const auto& file : files_) {
-        auto output_path = output_dir / file.path;
-        extract_file(file, output_path);
+    TaskScheduler::instance().parallel_for(total, [&](size_t i) {
+        const RdbFile& file = files_[i];
+        extract_file(file, output_dir / file.path);
         
+        std::lock_guard<std::mutex> lock(callback_mutex);
         ++current;
-        if (callback) {
-            if (!callback(file.path, current, total)) {
-                return false;
-            }
+        if (callback && !callback(file.path, current, total)) {
+            stop.cancel();
         }
-    }
+    }, TaskPriority::Bulk, stop);
     
-    return true;
+    return !stop.cancelled();
 }
 
 } // namespace enfusion
@@ -0,0 +1,306 @@
+/**
+ * Enfusion Unpacker - Content Search Implementation
+ */
+
+#include "enfusion/content_search.hpp"
+#include "enfusion/addon_extractor.hpp"
+#include "enfusion/logging.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace enfusion {
+
+namespace {
+
+// Branch-free ASCII lowercase so the compiler can vectorize the loop
+void lowercase_into(const uint8_t* src, size_t size, std::string& out) {
+    out.resize(size);
+    char* dst = out.data();
+    for (size_t i = 0; i < size; ++i) {
+        uint8_t c = src[i];
+        uint8_t is_upper = static_cast<uint8_t>(c - 'A') < 26;
+        dst[i] = static_cast<char>(c | (is_upper << 5));
+    }
+}
+
+uint32_t count_newlines(const char* begin, const char* end) {
+    uint32_t count = 0;
+    while (begin < end) {
+        const void* nl = std::memchr(begin, '\n', static_cast<size_t>(end - begin));
+        if (!nl) break;
+        ++count;
+        begin = static_cast<const char*>(nl) + 1;
+    }
+    return count;
+}
+
+} // namespace
+
+ContentSearch::~ContentSearch() {
+    cancel();
+}
+
+std::vector<std::filesystem::path> ContentSearch::find_addons(const std::filesystem::path& root) {
+    std::vector<std::filesystem::path> addons;
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root, ec)) return addons;
+
+    if (std::filesystem::exists(root / "resourceDatabase.rdb", ec)) {
+        addons.push_back(root);
+        return addons;
+    }
+
+    auto options = std::filesystem::directory_options::skip_permission_denied;
+    for (auto it = std::filesystem::recursive_directory_iterator(root, options, ec);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+        if (!it->is_directory(ec)) continue;
+
+        if (std::filesystem::exists(it->path() / "resourceDatabase.rdb", ec)) {
+            addons.push_back(it->path());
+            it.disable_recursion_pending();  // Addons don't nest
+        }
+    }
+
+    std::sort(addons.begin(), addons.end());
+    return addons;
+}
+
+Result<void> ContentSearch::start(std::vector<std::filesystem::path> addon_dirs, ContentSearchOptions options) {
+    cancel();
+
+    if (options.pattern.empty()) {
+        return Error(Error::Code::InvalidArgument, "Search pattern is empty");
+    }
+
+    if (options.regex) {
+        auto flags = std::regex::ECMAScript | std::regex::optimize;
+        if (!options.case_sensitive) flags |= std::regex::icase;
+        try {
+            regex_ = std::regex(options.pattern, flags);
+        } catch (const std::regex_error& e) {
+            return Error::parse_error(std::string("Invalid regex: ") + e.what(), options.pattern);
+        }
+    } else {
+        needle_ = options.pattern;
+        if (!options.case_sensitive) {
+            lowercase_into(reinterpret_cast<const uint8_t*>(needle_.data()), needle_.size(), needle_);
+        }
+    }
+
+    for (auto& ext : options.extensions) {
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    }
+
+    addon_dirs_ = std::move(addon_dirs);
+    options_ = std::move(options);
+    cancel_ = false;
+    addons_done_ = 0;
+    files_searched_ = 0;
+    hit_count_ = 0;
+    truncated_ = false;
+    {
+        std::lock_guard<std::mutex> lock(hits_mutex_);
+        pending_hits_.clear();
+    }
+
+    worker_ = TaskScheduler::instance().async(TaskPriority::Bulk, [this]() { run(); });
+    return Result<void>::success();
+}
+
+void ContentSearch::cancel() {
+    cancel_ = true;
+    if (worker_.valid()) {
+        worker_.wait();
+        worker_ = {};
+    }
+}
+
+bool ContentSearch::is_running() const {
+    return worker_.valid() && !worker_.ready();
+}
+
+std::vector<ContentSearchHit> ContentSearch::take_hits() {
+    std::lock_guard<std::mutex> lock(hits_mutex_);
+    std::vector<ContentSearchHit> hits;
+    hits.swap(pending_hits_);
+    return hits;
+}
+
+void ContentSearch::run() {
+    auto start_time = std::chrono::steady_clock::now();
+
+    auto open_addon = [](std::filesystem::path dir) -> std::shared_ptr<AddonExtractor> {
+        auto extractor = std::make_shared<AddonExtractor>();
+        auto loaded = extractor->load(dir);
+        if (!loaded) {
+            LOG_WARNING("ContentSearch", "Skipping " << dir.filename().string() << ": "
+                        << loaded.error().full_message());
+            return nullptr;
+        }
+        return extractor;
+    };
+
+    auto pak_size = [](const std::filesystem::path& dir) -> uint64_t {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(dir / "data.pak", ec);
+        return ec ? 0 : size;
+    };
+
+    // Keep one addon loading while the current one is searched, unless
+    // holding both whole PAKs at once would cost too much memory
+    auto& scheduler = TaskScheduler::instance();
+    auto prefetch = [&](size_t i) {
+        return scheduler.async(TaskPriority::Prefetch, [open_addon, dir = addon_dirs_[i]]() { return open_addon(dir); });
+    };
+
+    Task<std::shared_ptr<AddonExtractor>> next;
+    if (!addon_dirs_.empty()) {
+        next = prefetch(0);
+    }
+
+    for (size_t i = 0; i < addon_dirs_.size(); ++i) {
+        auto extractor = next.valid() ? next.get() : open_addon(addon_dirs_[i]);
+        if (cancel_) break;
+        if (i + 1 < addon_dirs_.size() &&
+            pak_size(addon_dirs_[i]) + pak_size(addon_dirs_[i + 1]) <= PREFETCH_PAK_LIMIT) {
+            next = prefetch(i + 1);
+        }
+
+        if (extractor) {
+            search_addon(*extractor);
+        }
+        addons_done_++;
+        if (cancel_) break;
+    }
+
+    // A prefetch may still be in flight after a cancel
+    if (next.valid()) {
+        next.cancel();
+        next.wait();
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    LOG_INFO("ContentSearch", "Searched " << files_searched_.load() << " files in "
+             << addons_done_.load() << " addons, " << hit_count_.load() << " hits in "
+             << elapsed.count() << "ms");
+}
+
+bool ContentSearch::wants_file(const std::string& path) const {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return false;
+
+    std::string ext = path.substr(dot);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return std::find(options_.extensions.begin(), options_.extensions.end(), ext) !=
+           options_.extensions.end();
+}
+
+void ContentSearch::search_addon(AddonExtractor& extractor) {
+    std::vector<const RdbFile*> files;
+    for (const auto& file : extractor.files()) {
+        if (wants_file(file.path)) files.push_back(&file);
+    }
+    if (files.empty()) return;
+
+    auto& scheduler = TaskScheduler::instance();
+    size_t width = options_.threads > 0 ? options_.threads : scheduler.worker_count();
+    width = std::min(width, files.size());
+
+    // Workers pull files off a shared cursor; read_file() is safe to call
+    // concurrently once the addon is indexed
+    std::atomic<size_t> cursor{0};
+    auto worker = [&]() {
+        std::string scratch;
+        for (size_t index = cursor++; index < files.size() && !cancel_; index = cursor++) {
+            const RdbFile& file = *files[index];
+            auto data = extractor.read_file(file);
+            if (data && !data->empty()) {
+                search_file(extractor.addon_dir(), file, *data, scratch);
+            }
+            files_searched_++;
+        }
+    };
+
+    scheduler.parallel(width, worker, TaskPriority::Bulk);
+}
+
+void ContentSearch::search_file(const std::filesystem::path& addon_dir, const RdbFile& file,
+                                const std::vector<uint8_t>& data, std::string& scratch) {
+    const char* text = reinterpret_cast<const char*>(data.data());
+    size_t size = data.size();
+
+    auto report = [&](size_t line_begin, size_t line_end, size_t match, uint32_t line) {
+        ContentSearchHit hit;
+        hit.addon_dir = addon_dir;
+        hit.path = file.path;
+        hit.line = line;
+        hit.column = static_cast<uint32_t>(match - line_begin);
+        size_t length = std::min(line_end - line_begin, MAX_LINE_CONTEXT);
+        hit.text.assign(text + line_begin, length);
+        if (!hit.text.empty() && hit.text.back() == '\r') hit.text.pop_back();
+        add_hit(std::move(hit));
+    };
+
+    if (options_.regex) {
+        // Regex runs line by line so ^ and $ anchor to lines
+        uint32_t line = 1;
+        size_t begin = 0;
+        while (begin <= size && !cancel_) {
+            const void* nl = std::memchr(text + begin, '\n', size - begin);
+            size_t end = nl ? static_cast<size_t>(static_cast<const char*>(nl) - text) : size;
+            std::cmatch match;
+            if (std::regex_search(text + begin, text + end, match, regex_)) {
+                report(begin, end, begin + static_cast<size_t>(match.position(0)), line);
+            }
+            if (!nl) break;
+            begin = end + 1;
+            ++line;
+        }
+        return;
+    }
+
+    // Literal: string_view::find is memchr on the first byte plus a compare
+    std::string_view haystack(text, size);
+    if (!options_.case_sensitive) {
+        lowercase_into(data.data(), size, scratch);
+        haystack = scratch;
+    }
+
+    uint32_t line = 1;
+    size_t counted_to = 0;
+    size_t pos = haystack.find(needle_);
+    while (pos != std::string_view::npos && !cancel_) {
+        line += count_newlines(haystack.data() + counted_to, haystack.data() + pos);
+
+        size_t line_begin = haystack.rfind('\n', pos);
+        line_begin = line_begin == std::string_view::npos ? 0 : line_begin + 1;
+        size_t line_end = haystack.find('\n', pos);
+        if (line_end == std::string_view::npos) line_end = size;
+
+        report(line_begin, line_end, pos, line);
+
+        // One hit per line: carry on from the start of the next one
+        if (line_end >= size) break;
+        line += 1;
+        counted_to = line_end + 1;
+        pos = haystack.find(needle_, counted_to);
+    }
+}
+
+void ContentSearch::add_hit(ContentSearchHit hit) {
+    if (hit_count_.load() >= options_.max_hits) {
+        truncated_ = true;
+        cancel_ = true;
+        return;
+    }
+
+    hit_count_++;
+    std::lock_guard<std::mutex> lock(hits_mutex_);
+    pending_hits_.push_back(std::move(hit));
+}
+
+} // namespace enfusion
@@ -6,15 +6,20 @@
 
 #include "enfusion/pak_index.hpp"
 #include "enfusion/pak_reader.hpp"
+#include "enfusion/logging.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/memory.hpp"
+#include "enfusion/trace.hpp"
+#include "enfusion/task_scheduler.hpp"
 
 #include <sqlite3.h>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <iostream>
-#include <future>
 #include <chrono>
 #include <set>
+#include <unordered_map>
 
 namespace enfusion {
 
@@ -24,12 +29,15 @@ PakIndex& PakIndex::instance() {
 }
 
 PakIndex::PakIndex() {
-    // Use available hardware threads, leave 1 for UI
-    thread_count_ = std::max(1u, std::thread::hardware_concurrency() - 1);
-    if (thread_count_ > 8) thread_count_ = 8;  // Cap at 8 threads
-    
     // Default database path
     db_path_ = std::filesystem::temp_directory_path() / "enfusion_unpacker_index.db";
+
+    // SQLite allocates on its own; its counter is the index's share
+    auto& registry = memory::Registry::instance();
+    registry.set_probe(memory::Subsystem::Index, []() {
+        return static_cast<size_t>(sqlite3_memory_used());
+    });
+    registry.add_enforcer(memory::Subsystem::Index, [this](size_t, size_t) { release_memory(); });
 }
 
 PakIndex::~PakIndex() {
@@ -51,6 +59,12 @@ void PakIndex::set_db_path(const std::filesystem::path& path) {
     db_path_ = path;
 }
 
+void PakIndex::release_memory() {
+    std::unique_lock<std::mutex> lock(db_mutex_, std::try_to_lock);
+    if (!lock || !db_) return;
+    sqlite3_db_release_memory(db_);
+}
+
 bool PakIndex::open_database() {
     std::lock_guard<std::mutex> lock(db_mutex_);
     
@@ -86,6 +100,20 @@ bool PakIndex::open_database() {
     return true;
 }
 
+bool PakIndex::load_snapshot() {
+    if (!open_database()) return false;
+    if (ready_) return true;
+    
+    // Every PAK is committed in its own transaction, so whatever the database
+    // holds is a consistent view of the install, if possibly a stale one
+    size_t paks = total_paks();
+    if (paks == 0) return false;
+    
+    ready_ = true;
+    LOG_DEBUG("PakIndex", "Using index snapshot: " << paks << " PAKs");
+    return true;
+}
+
 void PakIndex::close_database() {
     std::lock_guard<std::mutex> lock(db_mutex_);
     
@@ -202,6 +230,9 @@ std::vector<std::filesystem::path> PakIndex::scan_for_paks(const std::filesystem
 bool PakIndex::pak_needs_update(const std::filesystem::path& pak_path) const {
     if (!db_) return true;
     
+    // Readers share the connection while a snapshot is being refreshed
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    
     try {
         uint64_t current_size = std::filesystem::file_size(pak_path);
         uint64_t current_mtime = std::filesystem::last_write_time(pak_path).time_since_epoch().count();
@@ -385,12 +416,17 @@ bool PakIndex::index_pak_to_db(const std::filesystem::path& pak_path) {
 }
 
 bool PakIndex::build_index(std::function<void(const std::string&, int, int)> progress_callback) {
-    ready_ = false;
+    static auto& build_time = metrics::histogram("index.build");
+    metrics::ScopedTimer timer(build_time);
+    TRACE_SCOPE("index.build");
+    
     cancel_requested_ = false;
     progress_ = 0;
+    refreshing_ = true;
     
     if (!open_database()) {
         std::cerr << "[PakIndex] Failed to open database\n";
+        refreshing_ = false;
         return false;
     }
     
@@ -412,6 +448,7 @@ bool PakIndex::build_index(std::function<void(const std::string&, int, int)> pro
     if (all_paks.empty()) {
         std::cerr << "[PakIndex] No PAKs found to index\n";
         ready_ = true;
+        refreshing_ = false;
         return false;
     }
     
@@ -435,59 +472,120 @@ bool PakIndex::build_index(std::function<void(const std::string&, int, int)> pro
     std::atomic<int> completed{0};
     std::atomic<int> success_count{0};
     
-    // Use thread pool approach
-    size_t chunk_size = (paks_to_update.size() + thread_count_ - 1) / thread_count_;
-    std::vector<std::future<void>> futures;
-    
-    for (unsigned int t = 0; t < thread_count_; t++) {
-        size_t start_idx = t * chunk_size;
-        size_t end_idx = std::min(start_idx + chunk_size, paks_to_update.size());
-        
-        if (start_idx >= paks_to_update.size()) break;
-        
-        futures.push_back(std::async(std::launch::async, [&, start_idx, end_idx]() {
-            for (size_t i = start_idx; i < end_idx && !cancel_requested_; i++) {
-                const auto& pak_path = paks_to_update[i];
-                
-                if (index_pak_to_db(pak_path)) {
-                    success_count++;
-                }
-                
-                completed++;
-                progress_ = paks_to_update.empty() ? 100 : 
-                    (completed * 100) / static_cast<int>(paks_to_update.size());
-                
-                if (progress_callback && (completed % 10 == 0 || completed == paks_to_update.size())) {
-                    progress_callback(pak_path.filename().string(),
-                                    completed.load(),
-                                    static_cast<int>(paks_to_update.size()));
-                }
+    // PAKs differ wildly in size, so workers take them one at a time rather
+    // than in fixed chunks; a bulk job never takes the workers the UI needs
+    std::atomic<size_t> cursor{0};
+    TaskScheduler::instance().parallel(MAX_INDEX_WIDTH, [&]() {
+        for (size_t i = cursor++; i < paks_to_update.size() && !cancel_requested_; i = cursor++) {
+            const auto& pak_path = paks_to_update[i];
+            
+            if (index_pak_to_db(pak_path)) {
+                success_count++;
             }
-        }));
-    }
-    
-    // Wait for all threads
-    for (auto& f : futures) {
-        f.get();
-    }
+            
+            const int total = static_cast<int>(paks_to_update.size());
+            const int done = ++completed;
+            progress_ = (done * 100) / total;
+            
+            if (progress_callback && (done % 10 == 0 || done == total)) {
+                progress_callback(pak_path.filename().string(), done, total);
+            }
+        }
+    }, TaskPriority::Bulk);
     
     if (cancel_requested_) {
         std::cerr << "[PakIndex] Indexing cancelled\n";
+        refreshing_ = false;
         return false;
     }
     
+    // The scan ran to completion, so anything not in it has been removed
+    size_t pruned = prune_missing_paks(all_paks);
+    
     auto end_time = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
     
     std::cerr << "[PakIndex] Indexing complete: " << total_paks() << " PAKs, "
               << total_files() << " files in " << duration.count() << "ms ("
-              << success_count << " updated)\n";
+              << success_count << " updated, " << pruned << " removed)\n";
+    
+    static auto& reindexed = metrics::counter("index.paks_reindexed");
+    reindexed.add(success_count.load());
+    
+    bool changed = success_count > 0 || pruned > 0;
+    if (changed) generation_++;
     
     ready_ = true;
-    return success_count > 0;
+    refreshing_ = false;
+    return changed;
+}
+
+size_t PakIndex::prune_missing_paks(const std::vector<std::filesystem::path>& present) {
+    std::set<std::string> keep;
+    for (const auto& pak : present) {
+        keep.insert(pak.string());
+    }
+    
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    
+    std::vector<std::string> gone;
+    {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db_, "SELECT path FROM paks", -1, &stmt, nullptr) != SQLITE_OK) {
+            return 0;
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            if (path && keep.find(path) == keep.end()) {
+                gone.emplace_back(path);
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+    
+    if (gone.empty()) return 0;
+    
+    // Drop them together so readers never see half of them gone
+    if (sqlite3_exec(db_, "BEGIN IMMEDIATE TRANSACTION;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        LOG_WARN("PakIndex", "Failed to begin prune transaction: " << sqlite3_errmsg(db_));
+        return 0;
+    }
+    
+    sqlite3_stmt* delete_files = nullptr;
+    sqlite3_stmt* delete_pak = nullptr;
+    bool ok = sqlite3_prepare_v2(db_, "DELETE FROM files WHERE pak_id IN (SELECT id FROM paks WHERE path = ?)",
+                                 -1, &delete_files, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db_, "DELETE FROM paks WHERE path = ?", -1, &delete_pak, nullptr) == SQLITE_OK;
+    
+    for (size_t i = 0; ok && i < gone.size(); i++) {
+        for (sqlite3_stmt* stmt : {delete_files, delete_pak}) {
+            sqlite3_reset(stmt);
+            sqlite3_bind_text(stmt, 1, gone[i].c_str(), -1, SQLITE_TRANSIENT);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                LOG_WARN("PakIndex", "Failed to remove " << gone[i] << ": " << sqlite3_errmsg(db_));
+                ok = false;
+                break;
+            }
+        }
+    }
+    
+    sqlite3_finalize(delete_files);
+    sqlite3_finalize(delete_pak);
+    
+    if (!ok || sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return 0;
+    }
+    
+    return gone.size();
 }
 
 std::filesystem::path PakIndex::find_pak_for_file(const std::string& virtual_path) const {
+    static auto& query_time = metrics::histogram("index.find_pak_for_file");
+    metrics::ScopedTimer timer(query_time);
+    TRACE_SPAN(span, "index.find_pak_for_file");
+    TRACE_ARG(span, "query", virtual_path);
+    
     if (!db_ || !ready_) {
         return {};
     }
@@ -527,6 +625,11 @@ std::filesystem::path PakIndex::find_pak_for_file(const std::string& virtual_pat
 }
 
 std::vector<std::filesystem::path> PakIndex::find_paks_for_pattern(const std::string& pattern) const {
+    static auto& query_time = metrics::histogram("index.find_paks_for_pattern");
+    metrics::ScopedTimer timer(query_time);
+    TRACE_SPAN(span, "index.find_paks_for_pattern");
+    TRACE_ARG(span, "query", pattern);
+    
     std::vector<std::filesystem::path> results;
     
     if (!db_ || !ready_) {
@@ -564,6 +667,130 @@ std::vector<std::filesystem::path> PakIndex::find_paks_for_pattern(const std::st
     return results;
 }
 
+int PakIndex::pak_priority(const std::filesystem::path& pak_path, const std::filesystem::path& mods_root) {
+    if (mods_root.empty()) return 0;
+    
+    // Anything under the mods folder is loaded on top of the base game. Whole
+    // components are compared so a sibling such as mods2 is not inside mods
+    auto pak = pak_path.lexically_normal();
+    auto root = mods_root.lexically_normal();
+    if (root.filename().empty()) root = root.parent_path();  // Trailing separator
+    auto mismatch = std::mismatch(root.begin(), root.end(), pak.begin(), pak.end());
+    return mismatch.first == root.end() ? 1 : 0;
+}
+
+PakIndex::InstallListing PakIndex::list_install() const {
+    static auto& query_time = metrics::histogram("index.list_install");
+    metrics::ScopedTimer timer(query_time);
+    TRACE_SCOPE("index.list_install");
+    
+    InstallListing listing;
+    if (!db_ || !ready_) return listing;
+    
+    std::filesystem::path mods_root;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        mods_root = mods_path_;
+    }
+    
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    
+    // PAK table is small; map row ids to listing slots with their priority
+    std::unordered_map<int64_t, uint32_t> pak_slots;
+    std::vector<int> priorities;
+    {
+        sqlite3_stmt* stmt = get_or_prepare_stmt("list_install_paks", "SELECT id, path FROM paks ORDER BY path");
+        if (!stmt) return listing;
+        
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            if (!path) continue;
+            pak_slots[sqlite3_column_int64(stmt, 0)] = static_cast<uint32_t>(listing.paks.size());
+            listing.paks.emplace_back(path);
+            priorities.push_back(pak_priority(listing.paks.back(), mods_root));
+        }
+    }
+    
+    // Walk files in path order (served by idx_files_path_pak) so every
+    // provider of a path arrives back to back and collapses into one entry
+    sqlite3_stmt* stmt = get_or_prepare_stmt("list_install_files",
+        "SELECT path, path_lower, pak_id FROM files ORDER BY path_lower");
+    if (!stmt) return listing;
+    
+    std::string last_lower;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        const char* path_lower = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        auto slot = pak_slots.find(sqlite3_column_int64(stmt, 2));
+        if (!path || !path_lower || slot == pak_slots.end()) continue;
+        
+        if (!listing.files.empty() && last_lower == path_lower) {
+            // Same virtual path shipped again: the higher priority PAK shadows the other
+            auto& file = listing.files.back();
+            file.providers++;
+            int incoming = priorities[slot->second];
+            int current = priorities[file.pak];
+            // Slots follow PAK path order, which breaks ties deterministically
+            if (incoming > current || (incoming == current && slot->second < file.pak)) {
+                file.pak = slot->second;
+                file.path = path;
+            }
+            continue;
+        }
+        
+        last_lower = path_lower;
+        listing.files.push_back({path, slot->second, 1});
+    }
+    
+    return listing;
+}
+
+std::vector<std::filesystem::path> PakIndex::find_all_paks_for_file(const std::string& virtual_path) const {
+    static auto& query_time = metrics::histogram("index.find_all_paks_for_file");
+    metrics::ScopedTimer timer(query_time);
+    TRACE_SPAN(span, "index.find_all_paks_for_file");
+    TRACE_ARG(span, "query", virtual_path);
+    
+    std::vector<std::filesystem::path> results;
+    if (!db_ || !ready_) return results;
+    
+    std::string normalized = virtual_path;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
+    
+    std::filesystem::path mods_root;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        mods_root = mods_path_;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(db_mutex_);
+        
+        static const char* sql = R"(
+            SELECT p.path FROM paks p
+            JOIN files f ON f.pak_id = p.id
+            WHERE f.path_lower = ?
+            ORDER BY p.path
+        )";
+        
+        sqlite3_stmt* stmt = get_or_prepare_stmt("find_all_paks_for_file", sql);
+        if (!stmt) return results;
+        
+        sqlite3_bind_text(stmt, 1, normalized.c_str(), -1, SQLITE_TRANSIENT);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            if (path) results.emplace_back(path);
+        }
+    }
+    
+    // Same order list_install() resolves with: priority first, then path
+    std::stable_sort(results.begin(), results.end(), [&](const auto& a, const auto& b) {
+        return pak_priority(a, mods_root) > pak_priority(b, mods_root);
+    });
+    return results;
+}
+
 size_t PakIndex::total_files() const {
     if (!db_) return 0;
     
@@ -600,6 +827,11 @@ size_t PakIndex::total_paks() const {
 
 std::vector<PakIndex::TextureSearchResult> PakIndex::search_textures_for_material(
     const std::string& material_name) const {
+    static auto& query_time = metrics::histogram("index.search_textures");
+    metrics::ScopedTimer timer(query_time);
+    TRACE_SPAN(span, "index.search_textures");
+    TRACE_ARG(span, "query", material_name);
+    
     
     std::vector<TextureSearchResult> results;
     if (!db_ || !ready_) return results;
@@ -706,6 +938,11 @@ std::vector<PakIndex::TextureSearchResult> PakIndex::search_textures_for_materia
 
 std::vector<PakIndex::TextureSearchResult> PakIndex::search_files_by_name(
     const std::string& name_pattern, const std::string& extension) const {
+    static auto& query_time = metrics::histogram("index.search_files");
+    metrics::ScopedTimer timer(query_time);
+    TRACE_SPAN(span, "index.search_files");
+    TRACE_ARG(span, "query", name_pattern);
+    
     
     std::vector<TextureSearchResult> results;
     if (!db_ || !ready_) return results;
@@ -35,9 +35,10 @@ bool PakManager::load_pak(const std::filesystem::path& pak_path) {
     pak->path = pak_path;
     pak->extractor = std::make_unique<AddonExtractor>();
     
-    if (!pak->extractor->load(pak_path)) {
+    auto loaded = pak->extractor->load(pak_path);
+    if (!loaded) {
         LOG_ERROR("PakManager", "Failed to load PAK: " << path_str 
-                  << " - " << pak->extractor->last_error());
+                  << " - " << loaded.error().full_message());
         if (load_callback_) {
             load_callback_(pak_path.filename().string(), false);
         }
@@ -121,13 +122,14 @@ std::vector<uint8_t> PakManager::read_file(const std::string& virtual_path) {
             if (file_normalized == normalized) {
                 // Read using the stored path to avoid case mismatches
                 auto data = pak->extractor->read_file(file);
-                if (!data.empty()) {
+                if (data && !data->empty()) {
                     LOG_DEBUG("PakManager", "Found in: " << pak->path.filename().string() 
-                              << " (" << data.size() << " bytes)");
-                    return data;
+                              << " (" << data->size() << " bytes)");
+                    return std::move(data).value_or({});
                 }
                 LOG_WARNING("PakManager", "File listed but read failed: " << file 
-                            << " in " << pak->path.filename().string());
+                            << " in " << pak->path.filename().string()
+                            << (data ? "" : " - " + data.error().message));
                 return {};
             }
         }
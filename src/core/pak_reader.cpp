@@ -5,6 +5,8 @@
 #include "enfusion/pak_reader.hpp"
 #include "enfusion/compression.hpp"
 #include "enfusion/files.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/trace.hpp"
 
 #include <fstream>
 #include <cstring>
@@ -28,6 +30,11 @@ PakReader::PakReader() = default;
 PakReader::~PakReader() = default;
 
 bool PakReader::open(const std::filesystem::path& path) {
+    static auto& open_time = metrics::histogram("pak.open");
+    metrics::ScopedTimer timer(open_time);
+    TRACE_SPAN(span, "pak.open");
+    TRACE_ARG(span, "path", path.string());
+    
     file_.open(path, std::ios::binary);
     if (!file_) {
         return false;
@@ -121,41 +128,54 @@ const PakEntry* PakReader::find_entry(const std::string& path) const {
     return nullptr;
 }
 
-std::vector<uint8_t> PakReader::read_file(const std::string& path) {
+Result<std::vector<uint8_t>> PakReader::read_file(const std::string& path) {
     const PakEntry* entry = find_entry(path);
     if (!entry) {
-        return {};
+        return Error::file_not_found(path);
     }
     return read_file(*entry);
 }
 
-std::vector<uint8_t> PakReader::read_file(const PakEntry& entry) {
+Result<std::vector<uint8_t>> PakReader::read_file(const PakEntry& entry) {
+    static auto& read_time = metrics::histogram("pak.read_file");
+    static auto& bytes_read = metrics::counter("pak.bytes_read");
+    static auto& bytes_decompressed = metrics::counter("pak.bytes_decompressed");
+    metrics::ScopedTimer timer(read_time);
+    TRACE_SPAN(span, "pak.read_file");
+    TRACE_ARG(span, "path", entry.path);
+    TRACE_ARG(span, "bytes", entry.size);
+    
     if (!file_.is_open()) {
-        return {};
+        return Error::io_error("PAK file not open", pak_path_.string());
     }
     
     // Seek to file data
+    file_.clear();
     file_.seekg(entry.offset);
     
     // Read compressed or raw data
     size_t read_size = entry.is_compressed ? entry.compressed_size : entry.size;
     std::vector<uint8_t> data(read_size);
     file_.read(reinterpret_cast<char*>(data.data()), read_size);
+    if (static_cast<size_t>(file_.gcount()) != read_size) {
+        return Error::io_error("Short read", entry.path);
+    }
+    bytes_read.add(read_size);
     
     // Decompress if needed
     if (entry.is_compressed) {
-        try {
-            // Detect compression type
-            CompressionType type = detect_compression(data.data(), data.size());
-            if (type == CompressionType::None) {
-                // Try LZ4 as default for unknown
-                type = CompressionType::LZ4;
-            }
-            return decompress_auto(data.data(), data.size(), entry.size, type);
-        } catch (...) {
-            // Decompression failed, return empty
-            return {};
+        // Detect compression type
+        CompressionType type = detect_compression(data.data(), data.size());
+        if (type == CompressionType::None) {
+            // Try LZ4 as default for unknown
+            type = CompressionType::LZ4;
+        }
+        auto decompressed = decompress_auto(data.data(), data.size(), entry.size, type);
+        if (!decompressed) {
+            return Error(decompressed.error().code, decompressed.error().message, entry.path);
         }
+        bytes_decompressed.add(decompressed->size());
+        return decompressed;
     }
     
     return data;
@@ -163,18 +183,18 @@ std::vector<uint8_t> PakReader::read_file(const PakEntry& entry) {
 
 bool PakReader::extract_file(const std::string& path, const std::filesystem::path& output_path) {
     auto data = read_file(path);
-    if (data.empty()) {
+    if (!data || data->empty()) {
         return false;
     }
-    return write_file(output_path, data);
+    return write_file(output_path, *data);
 }
 
 bool PakReader::extract_file(const PakEntry& entry, const std::filesystem::path& output_path) {
     auto data = read_file(entry);
-    if (data.empty()) {
+    if (!data || data->empty()) {
         return false;
     }
-    return write_file(output_path, data);
+    return write_file(output_path, *data);
 }
 
 bool PakReader::extract_all(const std::filesystem::path& output_dir, ProgressCallback callback) {
@@ -5,6 +5,8 @@
  */
 
 #include "enfusion/dds_loader.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/trace.hpp"
 #include <cstring>
 #include <algorithm>
 #include <cstdint>
@@ -369,6 +371,12 @@ static void decode_bc7_block(const uint8_t* block, uint8_t* output, int stride)
 }
 
 std::optional<TextureData> DdsLoader::load(std::span<const uint8_t> data) {
+    static auto& decode_time = metrics::histogram("decode.dds");
+    static auto& bytes_in = metrics::counter("decode.dds.bytes");
+    metrics::ScopedTimer timer(decode_time);
+    TRACE_SCOPE("dds.load");
+    bytes_in.add(data.size());
+    
     if (data.size() < 128) return std::nullopt;
     
     // Check DDS magic
@@ -462,12 +470,16 @@ std::optional<TextureData> DdsLoader::load(std::span<const uint8_t> data) {
     tex.format = format_name;
     tex.mip_count = mip_count;
     tex.channels = 4;
-    tex.pixels.resize(width * height * 4);
-    std::fill(tex.pixels.begin(), tex.pixels.end(), 128);
+    tex.pixels.assign(static_cast<size_t>(width) * height * 4, 128);
     
     const uint8_t* src = data.data() + data_offset;
     size_t src_remaining = data.size() - data_offset;
     
+    TRACE_SPAN(span, "dds.decode_blocks");
+    TRACE_ARG(span, "format", format_name);
+    TRACE_ARG(span, "width", width);
+    TRACE_ARG(span, "height", height);
+    
     for (uint32_t by = 0; by < blocks_y; by++) {
         for (uint32_t bx = 0; bx < blocks_x; bx++) {
             size_t block_offset = (by * blocks_x + bx) * bytes_per_block;
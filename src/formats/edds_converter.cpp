@@ -15,6 +15,9 @@
  */
 
 #include "enfusion/edds_converter.hpp"
+#include "enfusion/arena.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/trace.hpp"
 #include <lz4.h>
 #include <cstring>
 #include <algorithm>
@@ -44,11 +47,11 @@ static inline uint32_t read_u32_le(const uint8_t* p) {
  * 
  * CRITICAL: Dictionary MUST persist across ALL blocks
  */
-static std::vector<uint8_t> decompress_lz4_stream(const uint8_t* data, size_t size, size_t expected_size) {
-    if (size < 4) return {};
+static ScratchBuffer decompress_lz4_stream(const uint8_t* data, size_t size, size_t expected_size,
+                                           std::pmr::memory_resource* resource) {
+    if (size < 4) return ScratchBuffer(resource);
     
-    std::vector<uint8_t> result;
-    result.reserve(expected_size);
+    ScratchBuffer result(resource);
     
     size_t pos = 0;
     
@@ -56,8 +59,11 @@ static std::vector<uint8_t> decompress_lz4_stream(const uint8_t* data, size_t si
     uint32_t total_size = read_u32_le(data + pos);
     pos += 4;
     
+    result.reserve(std::max<size_t>(expected_size, total_size));
+    
     size_t remaining = total_size;
-    std::vector<uint8_t> prev_dict;
+    size_t dict_start = 0;
+    size_t dict_size = 0;
     
     while (pos < size && remaining > 0) {
         if (pos + 4 > size) break;
@@ -74,22 +80,25 @@ static std::vector<uint8_t> decompress_lz4_stream(const uint8_t* data, size_t si
         if (pos + block_size > size) break;
         
         size_t expected_block = std::min(remaining, size_t(0x10000));
-        std::vector<uint8_t> decompressed(expected_block);
+        size_t out_pos = result.size();
+        result.resize(out_pos + expected_block);
+        char* out = reinterpret_cast<char*>(result.data() + out_pos);
         
+        // Previous block sits right before the write position and acts as dictionary
         int dec_size;
-        if (!prev_dict.empty()) {
+        if (dict_size > 0) {
             dec_size = LZ4_decompress_safe_usingDict(
                 reinterpret_cast<const char*>(data + pos),
-                reinterpret_cast<char*>(decompressed.data()),
+                out,
                 static_cast<int>(block_size),
                 static_cast<int>(expected_block),
-                reinterpret_cast<const char*>(prev_dict.data()),
-                static_cast<int>(prev_dict.size())
+                reinterpret_cast<const char*>(result.data() + dict_start),
+                static_cast<int>(dict_size)
             );
         } else {
             dec_size = LZ4_decompress_safe(
                 reinterpret_cast<const char*>(data + pos),
-                reinterpret_cast<char*>(decompressed.data()),
+                out,
                 static_cast<int>(block_size),
                 static_cast<int>(expected_block)
             );
@@ -97,18 +106,16 @@ static std::vector<uint8_t> decompress_lz4_stream(const uint8_t* data, size_t si
         
         pos += block_size;
         
-        if (dec_size <= 0) break;
+        if (dec_size <= 0) {
+            result.resize(out_pos);
+            break;
+        }
         
-        decompressed.resize(dec_size);
-        result.insert(result.end(), decompressed.begin(), decompressed.end());
+        result.resize(out_pos + dec_size);
         remaining -= dec_size;
         
-        // Use this block as dictionary for next
-        if (decompressed.size() <= 0x10000) {
-            prev_dict = std::move(decompressed);
-        } else {
-            prev_dict.assign(decompressed.end() - 0x10000, decompressed.end());
-        }
+        dict_start = out_pos;
+        dict_size = static_cast<size_t>(dec_size);
         
         // Do NOT break on is_final - continue until remaining == 0
     }
@@ -120,8 +127,9 @@ static std::vector<uint8_t> decompress_lz4_stream(const uint8_t* data, size_t si
  * Alternative: Simple LZ4 block decompression (no header size, single block)
  * Used when the data is a simple compressed block without stream format
  */
-static std::vector<uint8_t> decompress_lz4_block(const uint8_t* data, size_t size, size_t expected_size) {
-    std::vector<uint8_t> result(expected_size);
+static ScratchBuffer decompress_lz4_block(const uint8_t* data, size_t size, size_t expected_size,
+                                          std::pmr::memory_resource* resource) {
+    ScratchBuffer result(expected_size, resource);
     
     int dec_size = LZ4_decompress_safe(
         reinterpret_cast<const char*>(data),
@@ -135,7 +143,7 @@ static std::vector<uint8_t> decompress_lz4_block(const uint8_t* data, size_t siz
         return result;
     }
     
-    return {};
+    return ScratchBuffer(resource);
 }
 
 EddsConverter::EddsConverter(std::span<const uint8_t> data) : data_(data) {
@@ -160,10 +168,13 @@ bool EddsConverter::is_edds() const {
     return (std::memcmp(tag, "COPY", 4) == 0 || std::memcmp(tag, "LZ4 ", 4) == 0);
 }
 
-std::vector<uint8_t> EddsConverter::convert() {
-    if (!is_edds()) {
-        return std::vector<uint8_t>(data_.begin(), data_.end());
-    }
+size_t EddsConverter::decode_mips(std::pmr::vector<ScratchBuffer>& mip_data) {
+    static auto& decode_time = metrics::histogram("decode.edds");
+    static auto& bytes_in = metrics::counter("decode.edds.bytes");
+    metrics::ScopedTimer timer(decode_time);
+    TRACE_SPAN(span, "edds.decode_mips");
+    TRACE_ARG(span, "bytes", data_.size());
+    bytes_in.add(data_.size());
     
     size_t header_size = 128;
     if (data_.size() >= 88 && std::memcmp(data_.data() + 84, DX10_FOURCC, 4) == 0) {
@@ -171,13 +182,10 @@ std::vector<uint8_t> EddsConverter::convert() {
     }
     
     parse_mip_table(header_size);
-    if (mip_table_.empty()) {
-        return std::vector<uint8_t>(data_.begin(), data_.end());
-    }
-    
-    std::vector<uint8_t> output(data_.begin(), data_.begin() + header_size);
+    if (mip_table_.empty()) return 0;
     
-    std::vector<std::vector<uint8_t>> mip_data;
+    auto* resource = mip_data.get_allocator().resource();
+    mip_data.reserve(mip_table_.size());
     size_t data_pos = header_size + mip_table_.size() * 8;
     
     for (size_t i = 0; i < mip_table_.size(); i++) {
@@ -193,15 +201,18 @@ std::vector<uint8_t> EddsConverter::convert() {
         const uint8_t* chunk = data_.data() + data_pos;
         data_pos += compressed_size;
         
-        if (std::memcmp(tag.data(), "COPY", 4) == 0) {
-            mip_data.emplace_back(chunk, chunk + compressed_size);
-        } else if (std::memcmp(tag.data(), "LZ4 ", 4) == 0) {
+        if (std::memcmp(tag.data(), "LZ4 ", 4) == 0) {
+            TRACE_SPAN(lz4_span, "edds.lz4");
+            TRACE_ARG(lz4_span, "mip", mip_level);
+            TRACE_ARG(lz4_span, "compressed", compressed_size);
+            TRACE_ARG(lz4_span, "bytes", expected_size);
+
             // Try stream decompression first (with header size)
-            auto decompressed = decompress_lz4_stream(chunk, compressed_size, expected_size);
+            auto decompressed = decompress_lz4_stream(chunk, compressed_size, expected_size, resource);
             
             // If stream failed, try simple block decompression
             if (decompressed.empty() || decompressed.size() < expected_size / 2) {
-                decompressed = decompress_lz4_block(chunk, compressed_size, expected_size);
+                decompressed = decompress_lz4_block(chunk, compressed_size, expected_size, resource);
             }
             
             // Pad if still too small
@@ -210,14 +221,59 @@ std::vector<uint8_t> EddsConverter::convert() {
             }
             mip_data.push_back(std::move(decompressed));
         } else {
+            // COPY and unknown tags are stored raw
             mip_data.emplace_back(chunk, chunk + compressed_size);
         }
     }
     
+    return header_size;
+}
+
+template <typename Output>
+static void assemble_dds(std::span<const uint8_t> header, const std::pmr::vector<ScratchBuffer>& mip_data,
+                         Output& output) {
+    size_t total = header.size();
+    for (const auto& mip : mip_data) total += mip.size();
+    output.reserve(total);
+    
+    output.insert(output.end(), header.begin(), header.end());
     for (auto it = mip_data.rbegin(); it != mip_data.rend(); ++it) {
         output.insert(output.end(), it->begin(), it->end());
     }
+}
+
+std::vector<uint8_t> EddsConverter::convert() {
+    if (!is_edds()) {
+        return std::vector<uint8_t>(data_.begin(), data_.end());
+    }
+    
+    ArenaScope scope;
+    std::pmr::vector<ScratchBuffer> mip_data(scope.resource());
+    size_t header_size = decode_mips(mip_data);
+    if (header_size == 0) {
+        return std::vector<uint8_t>(data_.begin(), data_.end());
+    }
+    
+    std::vector<uint8_t> output;
+    assemble_dds(data_.first(header_size), mip_data, output);
+    return output;
+}
+
+std::pmr::vector<uint8_t> EddsConverter::convert(std::pmr::memory_resource* resource) {
+    std::pmr::vector<uint8_t> output(resource);
+    if (!is_edds()) {
+        output.assign(data_.begin(), data_.end());
+        return output;
+    }
+    
+    std::pmr::vector<ScratchBuffer> mip_data(resource);
+    size_t header_size = decode_mips(mip_data);
+    if (header_size == 0) {
+        output.assign(data_.begin(), data_.end());
+        return output;
+    }
     
+    assemble_dds(data_.first(header_size), mip_data, output);
     return output;
 }
 
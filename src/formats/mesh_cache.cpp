@@ -0,0 +1,386 @@
+/**
+ * Enfusion Unpacker - Mesh Cache Implementation
+ */
+
+#include "enfusion/mesh_cache.hpp"
+#include "enfusion/logging.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace enfusion {
+
+namespace {
+
+constexpr char MAGIC[4] = {'E', 'M', 'S', 'H'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr uint64_t SECTION_ALIGN = 16;
+constexpr const char* EXTENSION = ".mesh";
+
+// Vertices are uploaded to GL exactly as stored, so the layout must not drift
+static_assert(std::is_trivially_copyable_v<XobVertex> && sizeof(XobVertex) == 32);
+static_assert(std::is_trivially_copyable_v<MaterialRange> && sizeof(MaterialRange) == 12);
+
+/**
+ * File layout, all little-endian:
+ *   Header | key | vertices | indices | LOD table | material ranges | materials
+ * Each section starts on a SECTION_ALIGN boundary. Materials are five
+ * length-prefixed strings each (name, diffuse, normal, specular, emissive).
+ */
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t xob_version;
+    uint32_t key_size;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t lod_count;
+    uint32_t range_count;
+    uint32_t material_count;
+    uint32_t reserved;
+    float bounds_min[3];
+    float bounds_max[3];
+    uint64_t key_offset;
+    uint64_t vertex_offset;
+    uint64_t index_offset;
+    uint64_t lod_offset;
+    uint64_t range_offset;
+    uint64_t material_offset;
+    uint64_t file_size;
+};
+
+struct LodRecord {
+    float distance;
+    uint32_t index_offset;
+    uint32_t index_count;
+    uint32_t reserved;
+};
+
+uint64_t align_up(uint64_t offset) {
+    return (offset + SECTION_ALIGN - 1) & ~(SECTION_ALIGN - 1);
+}
+
+uint64_t fnv1a(std::span<const uint8_t> data) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint8_t byte : data) {
+        hash ^= byte;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string hex64(uint64_t value) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(value));
+    return buf;
+}
+
+bool section_fits(uint64_t offset, uint64_t count, uint64_t element, uint64_t file_size) {
+    return offset % SECTION_ALIGN == 0 && offset <= file_size &&
+           count <= (file_size - offset) / element;
+}
+
+/**
+ * Reads the length-prefixed material strings, refusing to run off the end.
+ */
+class StringReader {
+public:
+    StringReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    bool read(std::string& out) {
+        uint32_t length = 0;
+        if (size_ - pos_ < sizeof(length)) return false;
+        std::memcpy(&length, data_ + pos_, sizeof(length));
+        pos_ += sizeof(length);
+        if (size_ - pos_ < length) return false;
+        out.assign(reinterpret_cast<const char*>(data_ + pos_), length);
+        pos_ += length;
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+void append_string(std::vector<uint8_t>& out, const std::string& value) {
+    uint32_t length = static_cast<uint32_t>(value.size());
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&length);
+    out.insert(out.end(), bytes, bytes + sizeof(length));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+} // namespace
+
+MeshCache& MeshCache::instance() {
+    static MeshCache instance;
+    return instance;
+}
+
+MeshCache::MeshCache()
+    : directory_(std::filesystem::temp_directory_path() / "enfusion_unpacker_mesh_cache") {}
+
+std::string MeshCache::key_for(std::span<const uint8_t> data) {
+    return "fnv1a-" + hex64(fnv1a(data)) + "-" + std::to_string(data.size());
+}
+
+std::filesystem::path MeshCache::path_for(const std::string& key) const {
+    // Keys come from manifests and may hold any character; the full key is checked on open
+    auto bytes = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    return directory_ / (hex64(fnv1a(bytes)) + EXTENSION);
+}
+
+bool MeshCache::contains(const std::string& key) const {
+    if (key.empty()) return false;
+    std::error_code ec;
+    return std::filesystem::is_regular_file(path_for(key), ec);
+}
+
+std::unique_ptr<CachedMesh> MeshCache::open(const std::string& key) {
+    static auto& hits = metrics::counter("mesh_cache.hits");
+    static auto& misses = metrics::counter("mesh_cache.misses");
+    static auto& open_time = metrics::histogram("mesh_cache.open");
+
+    if (key.empty()) return nullptr;
+
+    metrics::ScopedTimer timer(open_time);
+    TRACE_SPAN(span, "mesh_cache.open");
+
+    auto path = path_for(key);
+    auto cached = std::make_unique<CachedMesh>();
+    if (!cached->file.open(path)) {
+        misses.add();
+        return nullptr;
+    }
+
+    const uint8_t* base = cached->file.data();
+    uint64_t size = cached->file.size();
+
+    auto reject = [&](const char* reason) -> std::unique_ptr<CachedMesh> {
+        LOG_DEBUG("MeshCache", "Dropping " << path.filename().string() << ": " << reason);
+        cached->file.close();
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        misses.add();
+        return nullptr;
+    };
+
+    Header header;
+    if (size < sizeof(header)) return reject("truncated header");
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return reject("bad magic");
+    if (header.version != FORMAT_VERSION) return reject("older format");
+    if (header.file_size != size) return reject("size mismatch");
+    if (header.lod_count == 0) return reject("no LODs");
+    if (!section_fits(header.key_offset, header.key_size, 1, size) ||
+        !section_fits(header.vertex_offset, header.vertex_count, sizeof(XobVertex), size) ||
+        !section_fits(header.index_offset, header.index_count, sizeof(uint32_t), size) ||
+        !section_fits(header.lod_offset, header.lod_count, sizeof(LodRecord), size) ||
+        !section_fits(header.range_offset, header.range_count, sizeof(MaterialRange), size) ||
+        header.material_offset > size) {
+        return reject("section out of bounds");
+    }
+    if (std::string_view(reinterpret_cast<const char*>(base + header.key_offset), header.key_size) != key) {
+        return reject("key collision");
+    }
+
+    XobMesh& mesh = cached->mesh;
+    mesh.version = header.xob_version;
+    mesh.bounds_min = glm::vec3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]);
+    mesh.bounds_max = glm::vec3(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]);
+
+    mesh.lods.resize(header.lod_count);
+    for (uint32_t i = 0; i < header.lod_count; i++) {
+        LodRecord record;
+        std::memcpy(&record, base + header.lod_offset + i * sizeof(LodRecord), sizeof(record));
+        if (uint64_t(record.index_offset) + record.index_count > header.index_count) {
+            return reject("LOD outside index buffer");
+        }
+        mesh.lods[i].distance = record.distance;
+        mesh.lods[i].index_offset = record.index_offset;
+        mesh.lods[i].index_count = record.index_count;
+    }
+
+    mesh.material_ranges.resize(header.range_count);
+    std::memcpy(mesh.material_ranges.data(), base + header.range_offset,
+                header.range_count * sizeof(MaterialRange));
+
+    StringReader strings(base + header.material_offset, size - header.material_offset);
+    mesh.materials.resize(header.material_count);
+    for (auto& material : mesh.materials) {
+        if (!strings.read(material.name) || !strings.read(material.diffuse_texture) ||
+            !strings.read(material.normal_texture) || !strings.read(material.specular_texture) ||
+            !strings.read(material.emissive_texture)) {
+            return reject("truncated materials");
+        }
+    }
+
+    // Sections are aligned within a page-aligned mapping, so these casts are sound
+    cached->vertices = {reinterpret_cast<const XobVertex*>(base + header.vertex_offset), header.vertex_count};
+    cached->indices = {reinterpret_cast<const uint32_t*>(base + header.index_offset), header.index_count};
+
+    // The modification time doubles as the last-used time for trimming
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+    TRACE_ARG(span, "vertices", header.vertex_count);
+    TRACE_ARG(span, "indices", header.index_count);
+    hits.add();
+    return cached;
+}
+
+bool MeshCache::store(const std::string& key, const XobMesh& mesh) {
+    static auto& stores = metrics::counter("mesh_cache.stores");
+    static auto& bytes_written = metrics::counter("mesh_cache.bytes_written");
+
+    if (key.empty() || mesh.vertices.empty() || mesh.indices.empty() || mesh.lods.empty()) return false;
+    if (mesh.vertices.size() > UINT32_MAX || mesh.indices.size() > UINT32_MAX) return false;
+
+    TRACE_SPAN(span, "mesh_cache.store");
+
+    std::vector<uint8_t> materials;
+    for (const auto& material : mesh.materials) {
+        append_string(materials, material.name);
+        append_string(materials, material.diffuse_texture);
+        append_string(materials, material.normal_texture);
+        append_string(materials, material.specular_texture);
+        append_string(materials, material.emissive_texture);
+    }
+
+    std::vector<LodRecord> lods;
+    lods.reserve(mesh.lods.size());
+    for (const auto& lod : mesh.lods) {
+        lods.push_back({lod.distance, lod.index_offset, lod.index_count, 0});
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.xob_version = mesh.version;
+    header.key_size = static_cast<uint32_t>(key.size());
+    header.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+    header.index_count = static_cast<uint32_t>(mesh.indices.size());
+    header.lod_count = static_cast<uint32_t>(lods.size());
+    header.range_count = static_cast<uint32_t>(mesh.material_ranges.size());
+    header.material_count = static_cast<uint32_t>(mesh.materials.size());
+    for (int i = 0; i < 3; i++) {
+        header.bounds_min[i] = mesh.bounds_min[i];
+        header.bounds_max[i] = mesh.bounds_max[i];
+    }
+    header.key_offset = align_up(sizeof(Header));
+    header.vertex_offset = align_up(header.key_offset + key.size());
+    header.index_offset = align_up(header.vertex_offset + mesh.vertices.size() * sizeof(XobVertex));
+    header.lod_offset = align_up(header.index_offset + mesh.indices.size() * sizeof(uint32_t));
+    header.range_offset = align_up(header.lod_offset + lods.size() * sizeof(LodRecord));
+    header.material_offset = align_up(header.range_offset + mesh.material_ranges.size() * sizeof(MaterialRange));
+    header.file_size = header.material_offset + materials.size();
+
+    auto path = path_for(key);
+    auto temp = path;
+    temp += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+
+        uint64_t written = 0;
+        auto section = [&](uint64_t offset, const void* data, size_t bytes) {
+            static const char zeros[SECTION_ALIGN] = {};
+            file.write(zeros, static_cast<std::streamsize>(offset - written));
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            written = offset + bytes;
+        };
+        section(0, &header, sizeof(header));
+        section(header.key_offset, key.data(), key.size());
+        section(header.vertex_offset, mesh.vertices.data(), mesh.vertices.size() * sizeof(XobVertex));
+        section(header.index_offset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+        section(header.lod_offset, lods.data(), lods.size() * sizeof(LodRecord));
+        section(header.range_offset, mesh.material_ranges.data(), mesh.material_ranges.size() * sizeof(MaterialRange));
+        section(header.material_offset, materials.data(), materials.size());
+
+        if (!file) {
+            file.close();
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+    }
+
+    // Fails on Windows while a reader has the old entry mapped; it stays valid, so keep it
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    TRACE_ARG(span, "bytes", header.file_size);
+    stores.add();
+    bytes_written.add(header.file_size);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    total_bytes_ += header.file_size;
+    if (!scanned_ || total_bytes_ > MAX_BYTES) trim();
+    return true;
+}
+
+void MeshCache::trim() {
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type used;
+        uint64_t size;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const auto& item : std::filesystem::directory_iterator(directory_, ec)) {
+        if (item.path().extension() != EXTENSION) continue;
+        std::error_code item_ec;
+        uint64_t size = item.file_size(item_ec);
+        auto used = item.last_write_time(item_ec);
+        if (item_ec) continue;
+        entries.push_back({item.path(), used, size});
+        total += size;
+    }
+    scanned_ = true;
+
+    if (total > MAX_BYTES) {
+        // Least recently used first, down to three quarters so this doesn't run on every store
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.used < b.used; });
+        uint64_t target = MAX_BYTES / 4 * 3;
+        size_t removed = 0;
+        for (const auto& entry : entries) {
+            if (total <= target) break;
+            if (std::filesystem::remove(entry.path, ec)) {
+                total -= entry.size;
+                removed++;
+            }
+        }
+        LOG_DEBUG("MeshCache", "Trimmed " << removed << " entries, " << total << " bytes left");
+    }
+    total_bytes_ = total;
+}
+
+void MeshCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::error_code ec;
+    for (const auto& item : std::filesystem::directory_iterator(directory_, ec)) {
+        if (item.path().extension() == EXTENSION) {
+            std::filesystem::remove(item.path(), ec);
+        }
+    }
+    total_bytes_ = 0;
+    scanned_ = true;
+}
+
+} // namespace enfusion
@@ -0,0 +1,238 @@
+/**
+ * Enfusion Unpacker - Mesh Thumbnails Implementation
+ */
+
+#include "enfusion/mesh_thumbnails.hpp"
+#include "enfusion/mesh_cache.hpp"
+#include "enfusion/xob_parser.hpp"
+#include "enfusion/image_io.hpp"
+#include "enfusion/arena.hpp"
+#include "enfusion/logging.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace enfusion {
+
+ThumbnailCache& ThumbnailCache::instance() {
+    static ThumbnailCache instance;
+    return instance;
+}
+
+ThumbnailCache::ThumbnailCache()
+    : directory_(std::filesystem::temp_directory_path() / "enfusion_unpacker_thumbnails") {}
+
+std::filesystem::path ThumbnailCache::path_for(const std::string& key, const RasterOptions& options) const {
+    // Anything that changes the picture is part of the name; hashing keeps it filesystem-safe
+    std::string id = key + "|" + std::to_string(options.size) + "|" + std::to_string(options.supersample) +
+                     "|" + std::to_string(std::lround(options.yaw)) + "|" + std::to_string(std::lround(options.pitch));
+    auto bytes = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(id.data()), id.size());
+    return directory_ / (MeshCache::key_for(bytes) + ".png");
+}
+
+std::optional<TextureData> ThumbnailCache::load(const std::string& key, const RasterOptions& options) const {
+    if (key.empty()) return std::nullopt;
+    auto path = path_for(key, options);
+    auto image = read_png(path);
+    if (!image || image->width != options.size || image->height != options.size) return std::nullopt;
+
+    // The modification time doubles as the last-used time for trimming
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    return image;
+}
+
+bool ThumbnailCache::store(const std::string& key, const RasterOptions& options, const TextureData& image) {
+    if (key.empty() || image.width == 0) return false;
+
+    // Written next to the final name and renamed, so a concurrent load never sees half a PNG
+    auto path = path_for(key, options);
+    auto temp = path;
+    temp += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    if (!write_png(temp, image)) return false;
+
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(temp, ec);
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    total_bytes_ += size;
+    if (!scanned_ || total_bytes_ > MAX_BYTES) trim();
+    return true;
+}
+
+void ThumbnailCache::trim() {
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type used;
+        uint64_t size;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const auto& item : std::filesystem::directory_iterator(directory_, ec)) {
+        if (item.path().extension() != ".png") continue;
+        std::error_code item_ec;
+        uint64_t size = item.file_size(item_ec);
+        auto used = item.last_write_time(item_ec);
+        if (item_ec) continue;
+        entries.push_back({item.path(), used, size});
+        total += size;
+    }
+    scanned_ = true;
+
+    if (total > MAX_BYTES) {
+        // Least recently used first, down to three quarters so this doesn't run on every store
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.used < b.used; });
+        uint64_t target = MAX_BYTES / 4 * 3;
+        size_t removed = 0;
+        for (const auto& entry : entries) {
+            if (total <= target) break;
+            if (std::filesystem::remove(entry.path, ec)) {
+                total -= entry.size;
+                removed++;
+            }
+        }
+        LOG_DEBUG("ThumbnailCache", "Trimmed " << removed << " thumbnails, " << total << " bytes left");
+    }
+    total_bytes_ = total;
+}
+
+void ThumbnailCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::error_code ec;
+    for (const auto& item : std::filesystem::directory_iterator(directory_, ec)) {
+        if (item.path().extension() == ".png") {
+            std::filesystem::remove(item.path(), ec);
+        }
+    }
+    total_bytes_ = 0;
+    scanned_ = true;
+}
+
+TextureData ThumbnailCache::render(const ThumbnailRequest& request, const RasterOptions& options) {
+    static auto& hits = metrics::counter("thumbnails.hits");
+    static auto& misses = metrics::counter("thumbnails.misses");
+    static auto& render_time = metrics::histogram("thumbnails.render");
+
+    TRACE_SPAN(span, "thumbnail.render");
+    TRACE_ARG(span, "path", request.path);
+
+    // Without a manifest hash the bytes are the key, so they have to be read first
+    std::vector<uint8_t> data;
+    std::string key = request.key;
+    if (key.empty()) {
+        if (request.read) data = request.read();
+        if (data.empty()) return {};
+        key = MeshCache::key_for(data);
+    }
+
+    if (auto cached = load(key, options)) {
+        hits.add();
+        return std::move(*cached);
+    }
+    misses.add();
+    metrics::ScopedTimer timer(render_time);
+
+    TextureData image;
+    auto& meshes = MeshCache::instance();
+    std::unique_ptr<CachedMesh> cached = meshes.contains(key) ? meshes.open(key) : nullptr;
+
+    // The viewer caches LOD 0 only, so a single stored LOD isn't known to be
+    // the coarsest; parse that from the XOB unless the cache has the full table
+    if (!cached || cached->mesh.lods.size() < 2) {
+        if (data.empty() && request.read) data = request.read();
+        if (!data.empty()) {
+            ArenaScope scope;
+            XobParser parser(std::span<const uint8_t>(data.data(), data.size()));
+            auto mesh = parser.parse(XobParser::COARSEST_LOD);
+            if (mesh && !mesh->vertices.empty() && !mesh->indices.empty()) {
+                image = rasterize_mesh(mesh->vertices, mesh->indices, options);
+            }
+        }
+    }
+
+    // Opened in the viewer before: draw the coarsest stored LOD from the mapping
+    if (image.width == 0 && cached && !cached->mesh.lods.empty()) {
+        const XobLod& lod = cached->mesh.lods.back();
+        image = rasterize_mesh(cached->vertices, cached->indices.subspan(lod.index_offset, lod.index_count), options);
+    }
+    if (image.width == 0) return {};
+
+    store(key, options, image);
+    return image;
+}
+
+void ThumbnailCache::render_all(const std::vector<ThumbnailRequest>& requests, const RasterOptions& options,
+                                TaskPriority priority, CancellationToken token,
+                                const std::function<void(size_t, TextureData)>& done) {
+    TRACE_SPAN(span, "thumbnail.render_all");
+    TRACE_ARG(span, "count", requests.size());
+
+    TaskScheduler::instance().parallel_for(requests.size(), [&](size_t i) {
+        TextureData image;
+        try {
+            image = render(requests[i], options);
+        } catch (const std::exception&) {
+            // A broken mesh only costs its own tile
+        }
+        if (done) done(i, std::move(image));
+    }, priority, token);
+}
+
+TextureData make_contact_sheet(const std::vector<TextureData>& tiles, uint32_t columns,
+                               uint32_t tile_size, uint32_t padding, glm::vec3 background) {
+    columns = std::max(columns, 1u);
+    uint32_t rows = static_cast<uint32_t>((tiles.size() + columns - 1) / columns);
+    uint32_t cell = tile_size + padding;
+
+    TextureData sheet;
+    sheet.width = columns * cell + padding;
+    sheet.height = std::max(rows, 1u) * cell + padding;
+    sheet.channels = 4;
+    sheet.format = "RGBA8";
+    sheet.pixels.resize(static_cast<size_t>(sheet.width) * sheet.height * 4);
+
+    uint8_t bg[3] = {
+        static_cast<uint8_t>(std::clamp(background.x, 0.0f, 1.0f) * 255.0f),
+        static_cast<uint8_t>(std::clamp(background.y, 0.0f, 1.0f) * 255.0f),
+        static_cast<uint8_t>(std::clamp(background.z, 0.0f, 1.0f) * 255.0f),
+    };
+    for (size_t i = 0; i < sheet.pixels.size(); i += 4) {
+        sheet.pixels[i] = bg[0];
+        sheet.pixels[i + 1] = bg[1];
+        sheet.pixels[i + 2] = bg[2];
+        sheet.pixels[i + 3] = 255;
+    }
+
+    for (size_t t = 0; t < tiles.size(); t++) {
+        const TextureData& tile = tiles[t];
+        if (tile.width != tile_size || tile.height != tile_size) continue;
+
+        uint32_t left = padding + static_cast<uint32_t>(t % columns) * cell;
+        uint32_t top = padding + static_cast<uint32_t>(t / columns) * cell;
+        for (uint32_t y = 0; y < tile_size; y++) {
+            const uint8_t* src = tile.pixels.data() + static_cast<size_t>(y) * tile_size * 4;
+            uint8_t* dst = sheet.pixels.data() + (static_cast<size_t>(top + y) * sheet.width + left) * 4;
+            for (uint32_t x = 0; x < tile_size; x++, src += 4, dst += 4) {
+                // Tiles are transparent around the mesh; blend them over the sheet
+                uint32_t alpha = src[3];
+                for (int c = 0; c < 3; c++) {
+                    dst[c] = static_cast<uint8_t>((src[c] * alpha + dst[c] * (255 - alpha) + 127) / 255);
+                }
+            }
+        }
+    }
+
+    return sheet;
+}
+
+} // namespace enfusion
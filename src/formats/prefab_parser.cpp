@@ -0,0 +1,366 @@
+/**
+ * Enfusion Unpacker - Prefab and world layer parser implementation
+ */
+
+#include "enfusion/prefab_parser.hpp"
+#include "enfusion/path_utils.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace enfusion {
+
+namespace {
+
+struct Token {
+    enum class Kind { Word, String, Open, Close, Colon, End };
+    Kind kind = Kind::End;
+    std::string_view text;
+    bool line_start = false;  // First token on its line
+    size_t line = 1;
+};
+
+class Tokenizer {
+public:
+    explicit Tokenizer(std::string_view text) : text_(text) {}
+
+    Token next() {
+        bool newline = skip_space();
+        Token tok;
+        tok.line_start = newline;
+        tok.line = line_;
+        if (pos_ >= text_.size()) return tok;
+
+        char c = text_[pos_];
+        if (c == '{' || c == '}' || c == ':') {
+            tok.kind = c == '{' ? Token::Kind::Open : c == '}' ? Token::Kind::Close : Token::Kind::Colon;
+            tok.text = text_.substr(pos_++, 1);
+            return tok;
+        }
+
+        if (c == '"') {
+            size_t start = ++pos_;
+            while (pos_ < text_.size() && text_[pos_] != '"' && text_[pos_] != '\n') ++pos_;
+            tok.kind = Token::Kind::String;
+            tok.text = text_.substr(start, pos_ - start);
+            if (pos_ < text_.size() && text_[pos_] == '"') ++pos_;
+            return tok;
+        }
+
+        size_t start = pos_;
+        while (pos_ < text_.size()) {
+            char w = text_[pos_];
+            if (w == ' ' || w == '\t' || w == '\r' || w == '\n' ||
+                w == '{' || w == '}' || w == '"') break;
+            ++pos_;
+        }
+        tok.kind = Token::Kind::Word;
+        tok.text = text_.substr(start, pos_ - start);
+        return tok;
+    }
+
+private:
+    // Skips whitespace and comments; true if a line break was crossed
+    bool skip_space() {
+        bool newline = pos_ == 0;
+        while (pos_ < text_.size()) {
+            char c = text_[pos_];
+            if (c == '\n') {
+                newline = true;
+                ++line_;
+                ++pos_;
+            } else if (c == ' ' || c == '\t' || c == '\r') {
+                ++pos_;
+            } else if (c == '/' && pos_ + 1 < text_.size() && text_[pos_ + 1] == '/') {
+                while (pos_ < text_.size() && text_[pos_] != '\n') ++pos_;
+            } else if (c == '/' && pos_ + 1 < text_.size() && text_[pos_ + 1] == '*') {
+                size_t end = text_.find("*/", pos_ + 2);
+                size_t stop = end == std::string_view::npos ? text_.size() : end + 2;
+                line_ += std::count(text_.begin() + pos_, text_.begin() + stop, '\n');
+                newline = newline || text_.substr(pos_, stop - pos_).find('\n') != std::string_view::npos;
+                pos_ = stop;
+            } else {
+                break;
+            }
+        }
+        return newline;
+    }
+
+    std::string_view text_;
+    size_t pos_ = 0;
+    size_t line_ = 1;
+};
+
+/**
+ * Untyped block tree: "header tokens { statements; nested blocks }".
+ * Statements are the tokens of one line, key first.
+ */
+struct ConfigNode {
+    std::vector<Token> header;
+    std::vector<std::vector<Token>> values;
+    std::vector<ConfigNode> blocks;
+};
+
+class ConfigReader {
+public:
+    explicit ConfigReader(std::string_view text) : tokens_(text) { advance(); }
+
+    Result<ConfigNode> read_document() {
+        ConfigNode root;
+        auto done = read_body(root, 0);
+        if (!done) return done.error();
+        return root;
+    }
+
+private:
+    static constexpr int MAX_NESTING = 256;
+
+    void advance() { current_ = tokens_.next(); }
+
+    Result<void> read_body(ConfigNode& node, int depth) {
+        if (depth > MAX_NESTING) {
+            return Error::parse_error("Blocks nested too deeply", "line " + std::to_string(current_.line));
+        }
+
+        while (true) {
+            if (current_.kind == Token::Kind::End) {
+                if (depth == 0) return Result<void>::success();
+                return Error::parse_error("Unexpected end of file, missing '}'");
+            }
+            if (current_.kind == Token::Kind::Close) {
+                advance();
+                if (depth == 0) {
+                    return Error::parse_error("Unmatched '}'", "line " + std::to_string(current_.line));
+                }
+                return Result<void>::success();
+            }
+
+            // Collect one statement: everything up to a line break or a brace
+            std::vector<Token> statement;
+            while (current_.kind == Token::Kind::Word || current_.kind == Token::Kind::String ||
+                   current_.kind == Token::Kind::Colon) {
+                statement.push_back(current_);
+                advance();
+                if (current_.line_start) break;
+            }
+
+            if (current_.kind == Token::Kind::Open) {
+                advance();
+                ConfigNode child;
+                child.header = std::move(statement);
+                auto done = read_body(child, depth + 1);
+                if (!done) return done;
+                node.blocks.push_back(std::move(child));
+            } else if (!statement.empty()) {
+                node.values.push_back(std::move(statement));
+            }
+        }
+    }
+
+    Tokenizer tokens_;
+    Token current_;
+};
+
+float to_float(const Token& tok, float fallback) {
+    std::string text(tok.text);
+    char* end = nullptr;
+    float value = std::strtof(text.c_str(), &end);
+    return end == text.c_str() ? fallback : value;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+bool ends_with_xob(std::string_view path) {
+    return path.size() >= 4 && iequals(path.substr(path.size() - 4), ".xob");
+}
+
+// Mesh reference anywhere under a components block (MeshObject { Object "..." })
+std::string find_mesh(const ConfigNode& node) {
+    for (const auto& value : node.values) {
+        if (value.size() >= 2 && value[0].text == "Object" && ends_with_xob(value[1].text)) {
+            return PrefabParser::strip_guid(value[1].text);
+        }
+    }
+    for (const auto& block : node.blocks) {
+        auto mesh = find_mesh(block);
+        if (!mesh.empty()) return mesh;
+    }
+    return {};
+}
+
+void apply_header(const std::vector<Token>& header, PrefabEntity& entity) {
+    size_t i = 0;
+    if (i < header.size() && header[i].text == "$grp") ++i;
+    if (i < header.size() && header[i].kind == Token::Kind::Word) {
+        entity.class_name = std::string(header[i].text);
+    }
+    for (size_t j = 0; j + 1 < header.size(); ++j) {
+        if (header[j].kind == Token::Kind::Colon) {
+            entity.ancestor = PrefabParser::strip_guid(header[j + 1].text);
+        }
+    }
+}
+
+void read_entities(const ConfigNode& node, std::vector<PrefabEntity>& out);
+
+void read_entity_body(const ConfigNode& node, PrefabEntity& entity) {
+    for (const auto& value : node.values) {
+        std::string_view key = value[0].text;
+        if (key == "coords" && value.size() >= 4) {
+            entity.coords = {to_float(value[1], 0.0f), to_float(value[2], 0.0f), to_float(value[3], 0.0f)};
+        } else if (key == "angles" && value.size() >= 4) {
+            entity.angles = {to_float(value[1], 0.0f), to_float(value[2], 0.0f), to_float(value[3], 0.0f)};
+        } else if (key == "angleX" && value.size() >= 2) {
+            entity.angles.x = to_float(value[1], 0.0f);
+        } else if (key == "angleY" && value.size() >= 2) {
+            entity.angles.y = to_float(value[1], 0.0f);
+        } else if (key == "angleZ" && value.size() >= 2) {
+            entity.angles.z = to_float(value[1], 0.0f);
+        } else if (key == "scale" && value.size() >= 2) {
+            entity.scale = to_float(value[1], 1.0f);
+        }
+    }
+
+    for (const auto& block : node.blocks) {
+        if (block.header.empty()) {
+            // Anonymous block holds child entities
+            read_entities(block, entity.children);
+        } else if (block.header[0].text == "components") {
+            if (entity.mesh.empty()) entity.mesh = find_mesh(block);
+        }
+    }
+}
+
+void read_entities(const ConfigNode& node, std::vector<PrefabEntity>& out) {
+    for (const auto& block : node.blocks) {
+        if (!block.header.empty() && block.header[0].text == "$grp") {
+            // "$grp Class : Prefab { name { coords ... } ... }" places one entity per member
+            PrefabEntity base;
+            apply_header(block.header, base);
+            for (const auto& member : block.blocks) {
+                // Member headers are just a name, optionally with its own prefab
+                PrefabEntity entity = base;
+                for (size_t j = 0; j + 1 < member.header.size(); ++j) {
+                    if (member.header[j].kind == Token::Kind::Colon) {
+                        entity.ancestor = PrefabParser::strip_guid(member.header[j + 1].text);
+                    }
+                }
+                read_entity_body(member, entity);
+                out.push_back(std::move(entity));
+            }
+            continue;
+        }
+
+        PrefabEntity entity;
+        apply_header(block.header, entity);
+        read_entity_body(block, entity);
+        out.push_back(std::move(entity));
+    }
+}
+
+glm::mat4 local_transform(const PrefabEntity& entity) {
+    glm::mat4 m = glm::translate(glm::mat4(1.0f), entity.coords);
+    m = glm::rotate(m, glm::radians(entity.angles.y), glm::vec3(0.0f, 1.0f, 0.0f));
+    m = glm::rotate(m, glm::radians(entity.angles.x), glm::vec3(1.0f, 0.0f, 0.0f));
+    m = glm::rotate(m, glm::radians(entity.angles.z), glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(m, glm::vec3(entity.scale));
+}
+
+} // namespace
+
+Result<std::vector<PrefabEntity>> PrefabParser::parse(std::string_view text) {
+    // Skip a UTF-8 BOM
+    if (text.size() >= 3 && text.substr(0, 3) == "\xEF\xBB\xBF") text.remove_prefix(3);
+
+    ConfigReader reader(text);
+    auto root = reader.read_document();
+    if (!root) return root.error();
+
+    std::vector<PrefabEntity> entities;
+    read_entities(*root, entities);
+    return entities;
+}
+
+std::string PrefabParser::strip_guid(std::string_view reference) {
+    if (!reference.empty() && reference[0] == '{') {
+        size_t close = reference.find('}');
+        if (close != std::string_view::npos) reference.remove_prefix(close + 1);
+    }
+    return std::string(reference);
+}
+
+SceneBuilder::SceneBuilder(FileLoader loader) : loader_(std::move(loader)) {}
+
+Result<std::vector<SceneInstance>> SceneBuilder::build(std::string_view text) {
+    auto entities = PrefabParser::parse(text);
+    if (!entities) return entities.error();
+
+    std::vector<SceneInstance> instances;
+    for (const auto& entity : *entities) {
+        flatten(entity, glm::mat4(1.0f), 0, instances);
+    }
+    return instances;
+}
+
+const PrefabEntity* SceneBuilder::load_prefab(const std::string& path) {
+    std::string key = normalize_path(path);
+    auto it = prefabs_.find(key);
+    if (it != prefabs_.end()) {
+        return it->second ? &*it->second : nullptr;
+    }
+
+    // Insert first so a prefab that inherits from itself terminates
+    auto& slot = prefabs_[key];
+    auto data = loader_ ? loader_(path) : std::vector<uint8_t>{};
+    if (data.empty()) {
+        missing_.push_back(path);
+        return nullptr;
+    }
+
+    auto parsed = PrefabParser::parse(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()));
+    if (!parsed || parsed->empty()) {
+        missing_.push_back(path);
+        return nullptr;
+    }
+
+    // A prefab file holds a single root entity
+    slot = std::move(parsed->front());
+    return &*slot;
+}
+
+void SceneBuilder::flatten(const PrefabEntity& entity, const glm::mat4& parent, int depth,
+                           std::vector<SceneInstance>& out) {
+    if (depth > MAX_DEPTH) return;
+
+    glm::mat4 world = parent * local_transform(entity);
+
+    // The nearest definition of the mesh wins; children accumulate down the chain
+    std::string mesh = entity.mesh;
+    std::string ancestor = entity.ancestor;
+    for (int hops = 0; !ancestor.empty() && hops < MAX_DEPTH; ++hops) {
+        const PrefabEntity* base = load_prefab(ancestor);
+        if (!base) break;
+
+        if (mesh.empty()) mesh = base->mesh;
+        for (const auto& child : base->children) {
+            flatten(child, world, depth + 1, out);
+        }
+        ancestor = base->ancestor;
+    }
+
+    if (!mesh.empty()) {
+        out.push_back({std::move(mesh), world});
+    }
+
+    for (const auto& child : entity.children) {
+        flatten(child, world, depth + 1, out);
+    }
+}
+
+} // namespace enfusion
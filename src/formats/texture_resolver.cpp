@@ -0,0 +1,207 @@
+/**
+ * Enfusion Unpacker - Texture Resolver Implementation
+ */
+
+#include "enfusion/texture_resolver.hpp"
+#include "enfusion/edds_converter.hpp"
+#include "enfusion/dds_loader.hpp"
+#include "enfusion/arena.hpp"
+#include "enfusion/path_utils.hpp"
+#include "enfusion/logging.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/trace.hpp"
+
+#include <algorithm>
+
+namespace enfusion {
+
+std::mutex TextureResolver::miss_mutex_;
+std::unordered_set<std::string> TextureResolver::misses_;
+
+TextureResolver::~TextureResolver() {
+    cancel();
+    // The load callback may reference the caller's extractor
+    for (const auto& task : retired_) task.wait();
+}
+
+std::vector<TextureResolver::CandidateGroup> TextureResolver::candidates(const std::string& material_path) {
+    std::vector<CandidateGroup> groups;
+
+    // The material path is usually an .emat file, we need to find the corresponding .edds
+    std::string base_path = material_path;
+    std::replace(base_path.begin(), base_path.end(), '\\', '/');
+    size_t ext_pos = base_path.rfind('.');
+    if (ext_pos != std::string::npos && base_path.find('/', ext_pos) == std::string::npos) {
+        base_path = base_path.substr(0, ext_pos);
+    }
+
+    // Next to the material, in the usual naming conventions
+    CandidateGroup local;
+    local.dir = get_parent_path(base_path);
+    local.paths = {
+        base_path + "_co.edds",  // color/diffuse
+        base_path + "_diff.edds",
+        base_path + "_d.edds",
+        base_path + ".edds"
+    };
+    groups.push_back(std::move(local));
+
+    // Shared textures folder with the same name
+    size_t last_slash = base_path.rfind('/');
+    if (last_slash != std::string::npos) {
+        std::string filename = base_path.substr(last_slash + 1);
+        CandidateGroup shared;
+        shared.dir = "Assets/Textures";
+        shared.paths = {
+            "Assets/Textures/" + filename + "_co.edds",
+            "Assets/Textures/" + filename + ".edds"
+        };
+        groups.push_back(std::move(shared));
+    }
+
+    return groups;
+}
+
+std::string TextureResolver::miss_key(const std::string& scope, const std::string& material, const std::string& dir) {
+    return normalize_path(scope) + '\n' + normalize_path(material) + '\n' + normalize_path(dir);
+}
+
+size_t TextureResolver::miss_count() {
+    std::lock_guard<std::mutex> lock(miss_mutex_);
+    return misses_.size();
+}
+
+void TextureResolver::resolve(std::string scope, std::vector<std::string> materials, ExistsFn exists, LoadFn load) {
+    cancel();
+    if (materials.empty() || !load) return;
+
+    auto request = std::make_shared<Request>();
+    request->scope = std::move(scope);
+    request->materials = std::move(materials);
+    request->exists = std::move(exists);
+    request->load = std::move(load);
+
+    // Materials are independent, so idle workers spread them out between themselves
+    auto& scheduler = TaskScheduler::instance();
+    tasks_.reserve(request->materials.size());
+    for (size_t i = 0; i < request->materials.size(); ++i) {
+        TaskOptions options;
+        options.priority = TaskPriority::Interactive;
+        options.token = request->cancel;
+        options.name = "texture.resolve";
+        tasks_.push_back(scheduler.submit([request, i]() { resolve_material(*request, i); }, std::move(options)));
+    }
+    request_ = std::move(request);
+}
+
+void TextureResolver::cancel() {
+    // Materials not started yet are dropped; don't block on one mid-read,
+    // it stops at its next check
+    for (auto& task : tasks_) {
+        task.cancel();
+        if (!task.done()) retired_.push_back(std::move(task));
+    }
+    tasks_.clear();
+    request_.reset();
+    reap_retired();
+}
+
+void TextureResolver::reap_retired() {
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(), [](const TaskHandle& task) {
+        return task.done();
+    }), retired_.end());
+}
+
+bool TextureResolver::is_busy() const {
+    return std::any_of(tasks_.begin(), tasks_.end(), [](const TaskHandle& task) { return !task.done(); });
+}
+
+std::vector<TextureResolver::Resolved> TextureResolver::take_resolved() {
+    reap_retired();
+
+    std::vector<Resolved> resolved;
+    if (!request_) return resolved;
+
+    std::lock_guard<std::mutex> lock(request_->mutex);
+    resolved.swap(request_->resolved);
+    return resolved;
+}
+
+void TextureResolver::resolve_material(Request& request, size_t index) {
+    static auto& miss_cache_hits = metrics::counter("texture.miss_cache.hits");
+    static auto& miss_cache_misses = metrics::counter("texture.miss_cache.misses");
+    
+    const std::string& material = request.materials[index];
+    if (material.empty()) return;
+
+    TRACE_SPAN(span, "texture.resolve_material");
+    TRACE_ARG(span, "material", material);
+
+    for (const auto& group : candidates(material)) {
+        if (request.cancel.cancelled()) return;
+
+        std::string key = miss_key(request.scope, material, group.dir);
+        {
+            std::lock_guard<std::mutex> lock(miss_mutex_);
+            if (misses_.count(key)) {
+                miss_cache_hits.add();
+                continue;
+            }
+        }
+        miss_cache_misses.add();
+
+        bool found_any = false;
+        for (const auto& path : group.paths) {
+            if (request.cancel.cancelled()) return;
+
+            TRACE_SPAN(candidate_span, "texture.candidate");
+            TRACE_ARG(candidate_span, "path", path);
+            if (request.exists && !request.exists(path)) continue;
+
+            auto data = request.load(path);
+            if (data.empty()) continue;
+            found_any = true;
+            TRACE_ARG(candidate_span, "bytes", data.size());
+
+            auto texture = decode(data);
+            if (!texture) continue;
+
+            LOG_DEBUG("TextureResolver", "Material " << material << " -> " << path);
+            std::lock_guard<std::mutex> lock(request.mutex);
+            request.resolved.push_back({index, path, std::move(*texture)});
+            return;
+        }
+
+        // Nothing in this directory: skip it for this material from now on
+        if (!found_any) {
+            std::lock_guard<std::mutex> lock(miss_mutex_);
+            misses_.insert(std::move(key));
+        }
+    }
+
+    LOG_DEBUG("TextureResolver", "No texture found for material " << material);
+}
+
+std::optional<TextureData> TextureResolver::decode(const std::vector<uint8_t>& data) {
+    TRACE_SPAN(span, "texture.decode");
+    TRACE_ARG(span, "bytes", data.size());
+
+    // Convert EDDS to DDS
+    ArenaScope scope;
+    EddsConverter converter(std::span<const uint8_t>(data.data(), data.size()));
+    auto dds_data = converter.convert(scope.resource());
+    if (dds_data.empty()) {
+        LOG_WARNING("TextureResolver", "EDDS conversion failed");
+        return std::nullopt;
+    }
+
+    // Load DDS
+    auto texture = DdsLoader::load(std::span<const uint8_t>(dds_data.data(), dds_data.size()));
+    if (!texture || texture->pixels.empty()) {
+        LOG_WARNING("TextureResolver", "DDS loading failed");
+        return std::nullopt;
+    }
+    return texture;
+}
+
+} // namespace enfusion
@@ -11,6 +11,15 @@
 namespace enfusion {
 namespace xob {
 
+// Ranges are worked out in triangles but stored as index spans for drawing
+static MaterialRange make_range(uint32_t material, uint32_t first_triangle, uint32_t triangle_count) {
+    MaterialRange r;
+    r.material_index = material;
+    r.start_index = first_triangle * 3;
+    r.index_count = triangle_count * 3;
+    return r;
+}
+
 MaterialRangeExtractor::MaterialRangeExtractor(
     std::span<const uint8_t> data,
     uint32_t total_triangles,
@@ -31,12 +40,7 @@ std::vector<MaterialRange> MaterialRangeExtractor::extract_from_descriptors(
     std::vector<MaterialRange> result;
     
     if (num_materials_ <= 1 || descriptors.empty()) {
-        MaterialRange r;
-        r.material_index = 0;
-        r.triangle_start = 0;
-        r.triangle_end = total_triangles_;
-        r.triangle_count = total_triangles_;
-        result.push_back(r);
+        result.push_back(make_range(0, 0, total_triangles_));
         return result;
     }
     
@@ -57,12 +61,7 @@ std::vector<MaterialRange> MaterialRangeExtractor::extract_from_descriptors(
         uint32_t mat_idx = !descriptors.empty() ? descriptors[0].submesh_index : 0;
         if (mat_idx >= num_materials_) mat_idx = 0;
         
-        MaterialRange r;
-        r.material_index = mat_idx;
-        r.triangle_start = 0;
-        r.triangle_end = total_triangles_;
-        r.triangle_count = total_triangles_;
-        result.push_back(r);
+        result.push_back(make_range(mat_idx, 0, total_triangles_));
         return result;
     }
     
@@ -83,45 +82,23 @@ std::vector<MaterialRange> MaterialRangeExtractor::extract_from_descriptors(
         
         uint32_t actual = std::min(tri_count, total_triangles_ - current_tri);
         
-        MaterialRange r;
-        r.material_index = mat_idx;
-        r.triangle_start = current_tri;
-        r.triangle_end = current_tri + actual;
-        r.triangle_count = actual;
-        result.push_back(r);
+        result.push_back(make_range(mat_idx, current_tri, actual));
         
         current_tri += actual;
     }
     
-    // Handle remaining triangles
+    // Handle remaining triangles; ranges stay contiguous so only the tail can grow
     if (current_tri < total_triangles_) {
         uint32_t remaining = total_triangles_ - current_tri;
-        bool found = false;
-        for (auto& r : result) {
-            if (r.material_index == 0) {
-                r.triangle_end = total_triangles_;
-                r.triangle_count += remaining;
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
-            MaterialRange r;
-            r.material_index = 0;
-            r.triangle_start = current_tri;
-            r.triangle_end = total_triangles_;
-            r.triangle_count = remaining;
-            result.push_back(r);
+        if (!result.empty() && result.back().material_index == 0) {
+            result.back().index_count += remaining * 3;
+        } else {
+            result.push_back(make_range(0, current_tri, remaining));
         }
     }
     
     if (result.empty()) {
-        MaterialRange r;
-        r.material_index = 0;
-        r.triangle_start = 0;
-        r.triangle_end = total_triangles_;
-        r.triangle_count = total_triangles_;
-        result.push_back(r);
+        result.push_back(make_range(0, 0, total_triangles_));
     }
     
     return result;
@@ -202,12 +179,7 @@ std::vector<MaterialRange> MaterialRangeExtractor::build_ranges(
     uint32_t total_indices = total_triangles_ * 3;
     
     if (all_blocks.empty()) {
-        MaterialRange r;
-        r.material_index = 0;
-        r.triangle_start = 0;
-        r.triangle_end = total_triangles_;
-        r.triangle_count = total_triangles_;
-        result.push_back(r);
+        result.push_back(make_range(0, 0, total_triangles_));
         return result;
     }
     
@@ -317,23 +289,13 @@ std::vector<MaterialRange> MaterialRangeExtractor::build_ranges(
         
         if (tri_count == 0) continue;
         
-        MaterialRange r;
-        r.material_index = block.material_index;
-        r.triangle_start = current;
-        r.triangle_end = current + tri_count;
-        r.triangle_count = tri_count;
-        result.push_back(r);
+        result.push_back(make_range(block.material_index, current, tri_count));
         
         current += tri_count;
     }
     
     if (result.empty()) {
-        MaterialRange r;
-        r.material_index = 0;
-        r.triangle_start = 0;
-        r.triangle_end = total_triangles_;
-        r.triangle_count = total_triangles_;
-        result.push_back(r);
+        result.push_back(make_range(0, 0, total_triangles_));
     }
     
     return result;
@@ -342,12 +304,7 @@ std::vector<MaterialRange> MaterialRangeExtractor::build_ranges(
 std::vector<MaterialRange> MaterialRangeExtractor::extract() {
     if (num_materials_ <= 1) {
         std::vector<MaterialRange> result;
-        MaterialRange r;
-        r.material_index = 0;
-        r.triangle_start = 0;
-        r.triangle_end = total_triangles_;
-        r.triangle_count = total_triangles_;
-        result.push_back(r);
+        result.push_back(make_range(0, 0, total_triangles_));
         return result;
     }
     
@@ -10,12 +10,16 @@
  */
 
 #include "enfusion/xob_parser.hpp"
+#include "enfusion/xob_material_ranges.hpp"
 #include "enfusion/compression.hpp"
+#include "enfusion/arena.hpp"
+#include "enfusion/logging.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/trace.hpp"
 #include <lz4.h>
 #include <cstring>
 #include <algorithm>
 #include <stdexcept>
-#include <iostream>
 #include <cfloat>
 
 namespace enfusion {
@@ -52,16 +56,25 @@ static inline float read_f32_le(const uint8_t* p) {
  * 
  * The has_more flag only indicates logical segments, NOT dictionary boundaries.
  * We must continue decompression until we run out of data or hit a zero block.
+ *
+ * Blocks are decoded straight into the output buffer; the previous block is
+ * already sitting right before the write position, so it serves as the
+ * dictionary without being copied.
  */
-static std::vector<uint8_t> decompress_lz4_chained(const uint8_t* data, size_t size) {
-    std::vector<uint8_t> result;
-    result.reserve(size * 4);
+static ScratchBuffer decompress_lz4_chained(const uint8_t* data, size_t size, size_t size_hint,
+                                            std::pmr::memory_resource* resource) {
+    TRACE_SPAN(span, "xob.lz4");
+    TRACE_ARG(span, "compressed", size);
+    TRACE_ARG(span, "bytes", size_hint);
 
-    std::cerr << "[XOB] Decompressing LZ4 chained, input size=" << size << "\n";
+    ScratchBuffer result(resource);
+    result.reserve(std::max(size_hint, size * 4) + 65536);
+
+    LOG_DEBUG("XOB", "Decompressing LZ4 chained, input size=" << size);
 
     size_t pos = 0;
-    std::vector<uint8_t> prev_dict;
-    prev_dict.reserve(65536);
+    size_t dict_start = 0;
+    size_t dict_size = 0;
     int block_count = 0;
 
     while (pos < size) {
@@ -78,22 +91,24 @@ static std::vector<uint8_t> decompress_lz4_chained(const uint8_t* data, size_t s
         if (block_size > 0x20000) break;
         if (pos + block_size > size) break;
 
-        std::vector<uint8_t> decompressed(65536);
+        size_t out_pos = result.size();
+        result.resize(out_pos + 65536);
+        char* out = reinterpret_cast<char*>(result.data() + out_pos);
         int dec_size;
 
-        if (!prev_dict.empty()) {
+        if (dict_size > 0) {
             dec_size = LZ4_decompress_safe_usingDict(
                 reinterpret_cast<const char*>(data + pos),
-                reinterpret_cast<char*>(decompressed.data()),
+                out,
                 static_cast<int>(block_size),
                 65536,
-                reinterpret_cast<const char*>(prev_dict.data()),
-                static_cast<int>(prev_dict.size())
+                reinterpret_cast<const char*>(result.data() + dict_start),
+                static_cast<int>(dict_size)
             );
         } else {
             dec_size = LZ4_decompress_safe(
                 reinterpret_cast<const char*>(data + pos),
-                reinterpret_cast<char*>(decompressed.data()),
+                out,
                 static_cast<int>(block_size),
                 65536
             );
@@ -101,25 +116,22 @@ static std::vector<uint8_t> decompress_lz4_chained(const uint8_t* data, size_t s
 
         pos += block_size;
         if (dec_size <= 0) {
-            std::cerr << "[XOB] Block " << block_count << " decompression failed, dec_size=" << dec_size << "\n";
+            result.resize(out_pos);
+            LOG_WARN("XOB", "Block " << block_count << " decompression failed, dec_size=" << dec_size);
             break;
         }
 
-        decompressed.resize(dec_size);
-        result.insert(result.end(), decompressed.begin(), decompressed.end());
+        result.resize(out_pos + dec_size);
         
-        // Use this block as dictionary for next (keep last 64KB max)
-        if (decompressed.size() <= 65536) {
-            prev_dict = std::move(decompressed);
-        } else {
-            prev_dict.assign(decompressed.end() - 65536, decompressed.end());
-        }
+        // Use this block as dictionary for next (blocks never exceed 64KB)
+        dict_start = out_pos;
+        dict_size = static_cast<size_t>(dec_size);
         
         block_count++;
         // Do NOT break on has_more=false - continue until end of data
     }
 
-    std::cerr << "[XOB] Decompressed " << block_count << " blocks, total output=" << result.size() << "\n";
+    LOG_DEBUG("XOB", "Decompressed " << block_count << " blocks, total output=" << result.size());
     return result;
 }
 
@@ -150,10 +162,12 @@ struct LzoDescriptorInternal {
     bool has_extra_normals;
 };
 
-static std::vector<LzoDescriptorInternal> parse_lzo4_descriptors(const uint8_t* data, size_t size) {
-    std::vector<LzoDescriptorInternal> descriptors;
+static std::pmr::vector<LzoDescriptorInternal> parse_lzo4_descriptors(const uint8_t* data, size_t size,
+                                                                     std::pmr::memory_resource* resource) {
+    TRACE_SCOPE("xob.descriptors");
+    std::pmr::vector<LzoDescriptorInternal> descriptors(resource);
     
-    std::cerr << "[XOB] Parsing LZO4 descriptors from HEAD chunk, size=" << size << "\n";
+    LOG_DEBUG("XOB", "Parsing LZO4 descriptors from HEAD chunk, size=" << size);
     
     // Search for LZO4 markers
     size_t pos = 0;
@@ -203,28 +217,29 @@ static std::vector<LzoDescriptorInternal> parse_lzo4_descriptors(const uint8_t*
         uint8_t upper_byte = (d.format_flags >> 24) & 0xFF;
         d.position_stride = (upper_byte & 0x10) ? 16 : 12;
         
-        std::cerr << "[XOB] LOD " << descriptors.size() << ": offset=" << found 
-                  << " decomp=" << d.decomp_size
-                  << " tris=" << d.triangle_count 
-                  << " verts=" << d.vertex_count 
-                  << " stride=" << d.position_stride
-                  << " flags=0x" << std::hex << d.format_flags << std::dec << "\n";
+        LOG_DEBUG("XOB", "LOD " << descriptors.size() << ": offset=" << found 
+                         << " decomp=" << d.decomp_size
+                         << " tris=" << d.triangle_count 
+                         << " verts=" << d.vertex_count 
+                         << " stride=" << d.position_stride
+                         << " flags=0x" << std::hex << d.format_flags << std::dec);
         
         descriptors.push_back(d);
         pos = found + 4;
     }
     
-    std::cerr << "[XOB] Found " << descriptors.size() << " LOD descriptors\n";
+    LOG_DEBUG("XOB", "Found " << descriptors.size() << " LOD descriptors");
     return descriptors;
 }
 
 /**
  * Extract LOD region from decompressed data
  * LOD regions are stored in REVERSE order - LOD0 (highest detail) is at END
+ * Returns a view into the decompressed buffer
  */
-static std::vector<uint8_t> extract_lod_region_internal(
-    const std::vector<uint8_t>& decompressed,
-    const std::vector<LzoDescriptorInternal>& descriptors,
+static std::span<const uint8_t> extract_lod_region_internal(
+    std::span<const uint8_t> decompressed,
+    std::span<const LzoDescriptorInternal> descriptors,
     size_t lod_index
 ) {
     if (lod_index >= descriptors.size()) return {};
@@ -238,7 +253,7 @@ static std::vector<uint8_t> extract_lod_region_internal(
     size_t start_pos = end_pos - descriptors[lod_index].decomp_size;
     if (start_pos >= end_pos || end_pos > decompressed.size()) return {};
     
-    return std::vector<uint8_t>(decompressed.begin() + start_pos, decompressed.begin() + end_pos);
+    return decompressed.subspan(start_pos, end_pos - start_pos);
 }
 
 /**
@@ -246,18 +261,23 @@ static std::vector<uint8_t> extract_lod_region_internal(
  * Layout: Index1 -> Index2 -> Positions -> Normals(4 bytes each) -> UVs(4 bytes each)
  */
 static bool parse_mesh_from_region(
-    const std::vector<uint8_t>& region,
+    std::span<const uint8_t> region,
     uint16_t vertex_count,
     uint16_t triangle_count,
     int position_stride,
     XobMesh& mesh
 ) {
-    std::cerr << "[XOB] parse_mesh_from_region: region_size=" << region.size() 
-              << " verts=" << vertex_count << " tris=" << triangle_count 
-              << " stride=" << position_stride << "\n";
+    TRACE_SPAN(span, "xob.parse_region");
+    TRACE_ARG(span, "bytes", region.size());
+    TRACE_ARG(span, "vertices", vertex_count);
+    TRACE_ARG(span, "stride", position_stride);
+
+    LOG_DEBUG("XOB", "parse_mesh_from_region: region_size=" << region.size() 
+                     << " verts=" << vertex_count << " tris=" << triangle_count 
+                     << " stride=" << position_stride);
     
     if (vertex_count == 0 || triangle_count == 0 || region.empty()) {
-        std::cerr << "[XOB] Invalid parameters\n";
+        LOG_WARN("XOB", "Invalid parameters");
         return false;
     }
     
@@ -267,11 +287,11 @@ static bool parse_mesh_from_region(
     // CRITICAL: TWO index arrays before positions (Python: pos_offset = idx_size * 2)
     size_t pos_offset = idx_array_size * 2;
     
-    std::cerr << "[XOB] index_count=" << index_count << " idx_array_size=" << idx_array_size 
-              << " pos_offset=" << pos_offset << "\n";
+    LOG_DEBUG("XOB", "index_count=" << index_count << " idx_array_size=" << idx_array_size 
+                     << " pos_offset=" << pos_offset);
     
     if (pos_offset >= region.size()) {
-        std::cerr << "[XOB] pos_offset >= region.size()\n";
+        LOG_WARN("XOB", "pos_offset >= region.size()");
         return false;
     }
     
@@ -288,7 +308,7 @@ static bool parse_mesh_from_region(
     for (uint32_t idx : mesh.indices) {
         if (idx > max_idx) max_idx = idx;
     }
-    std::cerr << "[XOB] max_idx=" << max_idx << "\n";
+    LOG_DEBUG("XOB", "max_idx=" << max_idx);
     if (max_idx >= vertex_count) {
         // Bad indices - clamp them
         for (uint32_t& idx : mesh.indices) {
@@ -398,7 +418,7 @@ static std::vector<XobMaterial> extract_materials_from_head(const uint8_t* data,
                     mat.diffuse_texture = path;
                     materials.push_back(mat);
                     
-                    std::cerr << "[XOB] Found material: " << name << " path=" << path << "\n";
+                    LOG_DEBUG("XOB", "Found material: " << name << " path=" << path);
                     
                     i = path_end - 1; // Skip past this material
                 }
@@ -422,9 +442,9 @@ std::optional<std::span<const uint8_t>> XobParser::find_chunk(const uint8_t* chu
             
             // Sanity check
             if (chunk_size > 0 && chunk_size < 100000000 && pos + 8 + chunk_size <= data_.size()) {
-                std::cerr << "[XOB] Found chunk '" << (char)chunk_id[0] << (char)chunk_id[1] 
-                          << (char)chunk_id[2] << (char)chunk_id[3] << "' at pos=" << pos 
-                          << " size=" << chunk_size << "\n";
+                LOG_DEBUG("XOB", "Found chunk '" << (char)chunk_id[0] << (char)chunk_id[1] 
+                                 << (char)chunk_id[2] << (char)chunk_id[3] << "' at pos=" << pos 
+                                 << " size=" << chunk_size);
                 return data_.subspan(pos + 8, chunk_size);
             }
         }
@@ -434,6 +454,18 @@ std::optional<std::span<const uint8_t>> XobParser::find_chunk(const uint8_t* chu
 }
 
 std::optional<XobMesh> XobParser::parse(uint32_t target_lod) {
+    static auto& decode_time = metrics::histogram("decode.xob");
+    static auto& bytes_in = metrics::counter("decode.xob.bytes");
+    metrics::ScopedTimer timer(decode_time);
+    TRACE_SPAN(span, "xob.parse");
+    TRACE_ARG(span, "bytes", data_.size());
+    TRACE_ARG(span, "lod", target_lod);
+    bytes_in.add(data_.size());
+
+    // Descriptors and the decompressed LODS stream live in the scratch arena;
+    // callers such as MeshConverter don't open a scope of their own
+    ArenaScope scope;
+    
     if (data_.size() < 12) return std::nullopt;
     
     // Verify FORM header
@@ -449,33 +481,47 @@ std::optional<XobMesh> XobParser::parse(uint32_t target_lod) {
     static constexpr uint8_t HEAD_ID[4] = {'H', 'E', 'A', 'D'};
     auto head_chunk = find_chunk(HEAD_ID);
     if (!head_chunk) {
-        std::cerr << "[XOB] Failed to find HEAD chunk\n";
+        LOG_WARN("XOB", "Failed to find HEAD chunk");
         return std::nullopt;
     }
     
     auto head_data = *head_chunk;
-    std::cerr << "[XOB] HEAD chunk size=" << head_data.size() << "\n";
+    LOG_DEBUG("XOB", "HEAD chunk size=" << head_data.size());
     
     // Extract materials from HEAD chunk
     materials_ = extract_materials_from_head(head_data.data(), head_data.size());
     
     // Parse LZO4 descriptors from HEAD chunk
-    auto descriptors = parse_lzo4_descriptors(head_data.data(), head_data.size());
+    auto* scratch = scratch_resource();
+    auto descriptors = parse_lzo4_descriptors(head_data.data(), head_data.size(), scratch);
     if (descriptors.empty()) {
-        std::cerr << "[XOB] No LZO4 descriptors found\n";
+        LOG_WARN("XOB", "No LZO4 descriptors found");
         return std::nullopt;
     }
     
+    // Keep a copy so callers can ask for lod_count() and pick another LOD
+    descriptors_.clear();
+    for (const auto& d : descriptors) {
+        LzoDescriptor out;
+        out.vertex_count = d.vertex_count;
+        out.index_count = static_cast<uint32_t>(d.triangle_count) * 3;
+        out.decompressed_size = d.decomp_size;
+        out.triangle_count = d.triangle_count;
+        descriptors_.push_back(out);
+    }
+    
     // Validate LOD index
-    if (target_lod >= descriptors.size()) {
+    if (target_lod == COARSEST_LOD) {
+        target_lod = static_cast<uint32_t>(descriptors.size() - 1);
+    } else if (target_lod >= descriptors.size()) {
         target_lod = 0;
     }
     
     // Get descriptor for target LOD
     const auto& desc = descriptors[target_lod];
     if (desc.vertex_count == 0 || desc.triangle_count == 0) {
-        std::cerr << "[XOB] Invalid descriptor: vertex_count=" << desc.vertex_count 
-                  << " triangle_count=" << desc.triangle_count << "\n";
+        LOG_WARN("XOB", "Invalid descriptor: vertex_count=" << desc.vertex_count 
+                        << " triangle_count=" << desc.triangle_count);
         return std::nullopt;
     }
     
@@ -483,35 +529,38 @@ std::optional<XobMesh> XobParser::parse(uint32_t target_lod) {
     static constexpr uint8_t LODS_ID[4] = {'L', 'O', 'D', 'S'};
     auto lods_chunk = find_chunk(LODS_ID);
     if (!lods_chunk) {
-        std::cerr << "[XOB] Failed to find LODS chunk\n";
+        LOG_WARN("XOB", "Failed to find LODS chunk");
         return std::nullopt;
     }
-    std::cerr << "[XOB] LODS chunk size=" << lods_chunk->size() << "\n";
+    LOG_DEBUG("XOB", "LODS chunk size=" << lods_chunk->size());
     
     // Decompress LODS data with dictionary chaining
-    auto decompressed = decompress_lz4_chained(lods_chunk->data(), lods_chunk->size());
+    // All LOD regions together make up the decompressed stream
+    size_t total_size = 0;
+    for (const auto& d : descriptors) total_size += d.decomp_size;
+    auto decompressed = decompress_lz4_chained(lods_chunk->data(), lods_chunk->size(), total_size, scratch);
     if (decompressed.empty()) {
-        std::cerr << "[XOB] Decompression failed\n";
+        LOG_WARN("XOB", "Decompression failed");
         return std::nullopt;
     }
     
     // Extract LOD region (REVERSE order - LOD0 at END)
     auto region = extract_lod_region_internal(decompressed, descriptors, target_lod);
     if (region.empty()) {
-        std::cerr << "[XOB] Failed to extract LOD region\n";
+        LOG_WARN("XOB", "Failed to extract LOD region");
         return std::nullopt;
     }
-    std::cerr << "[XOB] LOD region size=" << region.size() << "\n";
+    LOG_DEBUG("XOB", "LOD region size=" << region.size());
     
     // Parse mesh from region
     XobMesh mesh;
     if (!parse_mesh_from_region(region, desc.vertex_count, desc.triangle_count, 
                                  desc.position_stride, mesh)) {
-        std::cerr << "[XOB] Failed to parse mesh from region\n";
+        LOG_WARN("XOB", "Failed to parse mesh from region");
         return std::nullopt;
     }
-    std::cerr << "[XOB] Mesh parsed: verts=" << mesh.vertices.size() 
-              << " indices=" << mesh.indices.size() << "\n";
+    LOG_DEBUG("XOB", "Mesh parsed: verts=" << mesh.vertices.size() 
+                     << " indices=" << mesh.indices.size());
     
     // Calculate bounds
     mesh.bounds_min = glm::vec3(FLT_MAX);
@@ -532,6 +581,18 @@ std::optional<XobMesh> XobParser::parse(uint32_t target_lod) {
     // Copy materials to mesh
     mesh.materials = materials_;
     
+    // Split the index buffer by material so the renderer can texture each part
+    uint8_t mesh_type = static_cast<uint8_t>(desc.format_flags >> 24);
+    TRACE_SCOPE("xob.material_ranges");
+    mesh.material_ranges = parse_material_ranges(desc.triangle_count, mesh_type);
+    uint32_t index_total = static_cast<uint32_t>(mesh.indices.size());
+    std::erase_if(mesh.material_ranges, [&](MaterialRange& r) {
+        if (r.start_index >= index_total) return true;
+        r.index_count = std::min(r.index_count, index_total - r.start_index);
+        return r.index_count == 0;
+    });
+    LOG_DEBUG("XOB", "Material ranges: " << mesh.material_ranges.size());
+    
     return mesh;
 }
 
@@ -543,8 +604,9 @@ std::vector<XobMaterial> XobParser::parse_materials(std::span<const uint8_t> hea
     return materials_;
 }
 
-std::vector<MaterialRange> XobParser::parse_material_ranges(std::span<const uint8_t> head_data, uint32_t triangle_count) {
-    return {};
+std::vector<MaterialRange> XobParser::parse_material_ranges(uint32_t triangle_count, uint8_t mesh_type) {
+    xob::MaterialRangeExtractor extractor(data_, triangle_count, materials_.size(), mesh_type);
+    return extractor.extract();
 }
 
 std::span<const uint8_t> XobParser::extract_lod_region(std::span<const uint8_t> decompressed, uint32_t lod) {
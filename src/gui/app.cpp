@@ -5,6 +5,9 @@
 #include "gui/app.hpp"
 #include "gui/main_window.hpp"
 #include "gui/theme.hpp"
+#include "enfusion/trace.hpp"
+#include "enfusion/memory.hpp"
+#include "enfusion/task_scheduler.hpp"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -12,7 +15,9 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
+#include <algorithm>
 #include <fstream>
+#include <limits>
 #include <nlohmann/json.hpp>
 
 namespace enfusion {
@@ -23,6 +28,8 @@ App& App::instance() {
 }
 
 bool App::init() {
+    trace::set_thread_name("Main");
+
     if (!init_glfw()) {
         return false;
     }
@@ -32,10 +39,14 @@ bool App::init() {
     }
     
     load_settings();
+    apply_memory_budgets();
+    apply_worker_settings();
     apply_theme(static_cast<Theme>(settings_.theme));
     
     main_window_ = std::make_unique<MainWindow>();
     
+    main_thread_ = std::this_thread::get_id();
+    TaskScheduler::instance().set_main_thread_wakeup([this]() { request_redraw(); });
     running_ = true;
     set_status("Ready");
     
@@ -90,23 +101,80 @@ bool App::init_imgui() {
 
 void App::run() {
     while (running_ && !glfwWindowShouldClose(window_)) {
+        wait_for_events();
         process_events();
+        
+        // Nothing to draw while minimised
+        if (glfwGetWindowAttrib(window_, GLFW_ICONIFIED)) continue;
+        
         render();
     }
 }
 
+void App::wait_for_events() {
+    if (settle_frames_ > 0) {
+        --settle_frames_;
+        return;
+    }
+    
+    double now = glfwGetTime();
+    double wake = redraw_at_.load();
+    if (glfwGetWindowAttrib(window_, GLFW_ICONIFIED)) {
+        wake = now + IDLE_TIMEOUT;
+    } else if (!glfwGetWindowAttrib(window_, GLFW_FOCUSED)) {
+        // Keep animations alive in the background but leave the CPU to workers
+        wake = std::max(wake, last_frame_ + UNFOCUSED_INTERVAL);
+    }
+    
+    double timeout = std::min(wake - now, IDLE_TIMEOUT);
+    if (timeout <= 0.0) return;
+    
+    glfwWaitEventsTimeout(timeout);
+    
+    // Returning before the timeout means an event arrived (input, resize, or a worker's wake-up)
+    if (glfwGetTime() - now < timeout - 0.001) {
+        settle_frames_ = SETTLE_FRAMES;
+    }
+}
+
+void App::request_redraw(double delay) {
+    double at = glfwGetTime() + delay;
+    double current = redraw_at_.load();
+    while (at < current) {
+        if (redraw_at_.compare_exchange_weak(current, at)) {
+            // The loop may be asleep on a later deadline
+            if (std::this_thread::get_id() != main_thread_) glfwPostEmptyEvent();
+            break;
+        }
+    }
+}
+
 void App::process_events() {
     glfwPollEvents();
     glfwGetWindowSize(window_, &width_, &height_);
 }
 
 void App::render() {
+    last_frame_ = glfwGetTime();
+    
+    // This frame satisfies any request that is due; ones made while drawing it stay pending
+    double due = redraw_at_.load();
+    if (due <= last_frame_) {
+        redraw_at_.compare_exchange_strong(due, std::numeric_limits<double>::infinity());
+    }
+    
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
     
+    // Results of background work land before anything draws
+    TaskScheduler::instance().run_main_thread_tasks();
+    
     // Render main window
     main_window_->render();
+
+    // Owners over their memory budget evict on this thread
+    memory::Registry::instance().enforce();
     
     ImGui::Render();
     
@@ -132,6 +200,7 @@ void App::shutdown() {
     save_settings();
     
     main_window_.reset();
+    TaskScheduler::instance().shutdown();
     
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -155,26 +224,56 @@ void App::load_settings() {
             if (j.contains("last_addon_path")) settings_.last_addon_path = j["last_addon_path"].get<std::string>();
             if (j.contains("last_export_path")) settings_.last_export_path = j["last_export_path"].get<std::string>();
             if (j.contains("arma_addons_path")) settings_.arma_addons_path = j["arma_addons_path"].get<std::string>();
+            if (j.contains("arma_mods_path")) settings_.arma_mods_path = j["arma_mods_path"].get<std::string>();
             if (j.contains("theme")) settings_.theme = j["theme"].get<int>();
             if (j.contains("ui_scale")) settings_.ui_scale = j["ui_scale"].get<float>();
             if (j.contains("convert_textures_to_png")) settings_.convert_textures_to_png = j["convert_textures_to_png"].get<bool>();
             if (j.contains("convert_meshes_to_obj")) settings_.convert_meshes_to_obj = j["convert_meshes_to_obj"].get<bool>();
+            if (j.contains("worker_threads")) settings_.worker_threads = j["worker_threads"].get<uint32_t>();
+            if (j.contains("background_workers")) settings_.background_workers = j["background_workers"].get<uint32_t>();
+            if (j.contains("memory_budgets_mb") && j["memory_budgets_mb"].is_object()) {
+                const auto& budgets = j["memory_budgets_mb"];
+                for (size_t i = 0; i < memory::SUBSYSTEM_COUNT; i++) {
+                    const char* key = memory::subsystem_key(static_cast<memory::Subsystem>(i));
+                    if (budgets.contains(key) && budgets[key].is_number_unsigned()) {
+                        settings_.memory_budgets_mb[key] = budgets[key].get<uint32_t>();
+                    }
+                }
+            }
         }
     } catch (...) {
         // Use defaults
     }
 }
 
+void App::apply_memory_budgets() {
+    auto& registry = memory::Registry::instance();
+    for (size_t i = 0; i < memory::SUBSYSTEM_COUNT; i++) {
+        auto subsystem = static_cast<memory::Subsystem>(i);
+        auto it = settings_.memory_budgets_mb.find(memory::subsystem_key(subsystem));
+        size_t mb = it != settings_.memory_budgets_mb.end() ? it->second : 0;
+        registry.set_budget(subsystem, mb * 1024 * 1024);
+    }
+}
+
+void App::apply_worker_settings() {
+    TaskScheduler::instance().configure(settings_.worker_threads, settings_.background_workers);
+}
+
 void App::save_settings() {
     try {
         nlohmann::json j;
         j["last_addon_path"] = settings_.last_addon_path.string();
         j["last_export_path"] = settings_.last_export_path.string();
         j["arma_addons_path"] = settings_.arma_addons_path.string();
+        j["arma_mods_path"] = settings_.arma_mods_path.string();
         j["theme"] = settings_.theme;
         j["ui_scale"] = settings_.ui_scale;
         j["convert_textures_to_png"] = settings_.convert_textures_to_png;
         j["convert_meshes_to_obj"] = settings_.convert_meshes_to_obj;
+        j["memory_budgets_mb"] = settings_.memory_budgets_mb;
+        j["worker_threads"] = settings_.worker_threads;
+        j["background_workers"] = settings_.background_workers;
         
         std::ofstream file("settings.json");
         file << j.dump(2);
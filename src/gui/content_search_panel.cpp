@@ -0,0 +1,105 @@
+﻿/**
+ * Enfusion Unpacker - Content Search Panel Implementation
+ */
+
+#include "gui/content_search_panel.hpp"
+#include "gui/app.hpp"
+
+#include <imgui.h>
+
+namespace enfusion {
+
+void ContentSearchPanel::start_search() {
+    hits_.clear();
+    selected_hit_ = -1;
+    error_.clear();
+
+    std::vector<fs::path> addons;
+    if (all_addons_) {
+        addons = ContentSearch::find_addons(addons_root_);
+    } else if (!current_addon_.empty()) {
+        // Opened through a .pak file: the addon is its folder
+        addons.push_back(current_addon_.has_extension() ? current_addon_.parent_path() : current_addon_);
+    }
+    if (addons.empty()) {
+        error_ = all_addons_ ? "No addons found in the addons folder" : "No addon loaded";
+        return;
+    }
+
+    ContentSearchOptions options;
+    options.pattern = pattern_;
+    options.regex = regex_;
+    options.case_sensitive = case_sensitive_;
+
+    auto started = search_.start(std::move(addons), std::move(options));
+    if (!started) {
+        error_ = started.error().full_message();
+    }
+}
+
+void ContentSearchPanel::render() {
+    // Pull in whatever the workers found since last frame
+    auto fresh = search_.take_hits();
+    hits_.insert(hits_.end(), std::make_move_iterator(fresh.begin()), std::make_move_iterator(fresh.end()));
+
+    bool running = search_.is_running();
+    if (running) App::instance().request_redraw(0.1);
+
+    ImGui::SetNextItemWidth(-90.0f);
+    bool submitted = ImGui::InputTextWithHint("##ContentPattern", "Text or regex...", pattern_, sizeof(pattern_),
+                                              ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SameLine();
+    if (running) {
+        if (ImGui::Button("Stop", ImVec2(-1, 0))) search_.cancel();
+    } else if (ImGui::Button("Search", ImVec2(-1, 0)) || submitted) {
+        start_search();
+    }
+
+    ImGui::Checkbox("Regex", &regex_);
+    ImGui::SameLine();
+    ImGui::Checkbox("Match case", &case_sensitive_);
+    ImGui::SameLine();
+    ImGui::Checkbox("All addons", &all_addons_);
+
+    if (!error_.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", error_.c_str());
+    } else if (running || search_.addons_total() > 0) {
+        ImGui::TextDisabled("%zu hits | %zu files | addon %zu/%zu%s%s",
+                            search_.hit_count(), search_.files_searched(),
+                            search_.addons_done(), search_.addons_total(),
+                            search_.truncated() ? " | limit reached" : "",
+                            running ? " | searching..." : "");
+    }
+
+    ImGui::Separator();
+    ImGui::BeginChild("ContentHits", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(hits_.size()));
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            const auto& hit = hits_[row];
+            ImGui::PushID(row);
+
+            if (ImGui::Selectable("##hit", selected_hit_ == row, ImGuiSelectableFlags_AllowDoubleClick)) {
+                selected_hit_ = row;
+                if (on_hit_selected) on_hit_selected(hit);
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("%s\n%s", hit.addon_dir.filename().string().c_str(), hit.path.c_str());
+            }
+
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(0.45f, 0.75f, 1.0f, 1.0f), "%s:%u", hit.path.c_str(), hit.line);
+            ImGui::SameLine();
+            ImGui::TextUnformatted(hit.text.c_str());
+
+            ImGui::PopID();
+        }
+    }
+    clipper.End();
+
+    ImGui::EndChild();
+}
+
+} // namespace enfusion
@@ -8,7 +8,6 @@
 #include "enfusion/addon_extractor.hpp"
 
 #include <imgui.h>
-#include <thread>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -17,6 +16,13 @@
 
 namespace enfusion {
 
+ExportDialog::~ExportDialog() {
+    // Both tasks reference this dialog
+    export_token_.cancel();
+    export_task_.wait();
+    finish_task_.cancel();
+}
+
 void ExportDialog::render(bool* open) {
     if (!*open) return;
 
@@ -119,16 +125,23 @@ void ExportDialog::render_progress() {
     ImGui::Text("Exporting...");
     ImGui::Spacing();
 
-    ImGui::ProgressBar(progress_, ImVec2(-1, 0), "");
+    int processed = files_processed_.load();
+    int total = total_files_.load();
+    float progress = total > 0 ? static_cast<float>(processed) / static_cast<float>(total) : 0.0f;
+    ImGui::ProgressBar(progress, ImVec2(-1, 0), "");
+    App::instance().request_redraw(0.1);
 
     ImGui::Spacing();
-    ImGui::TextDisabled("Current: %s", current_file_.c_str());
-    ImGui::TextDisabled("Files: %d / %d", files_processed_, total_files_);
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex_);
+        ImGui::TextDisabled("Current: %s", current_file_.c_str());
+    }
+    ImGui::TextDisabled("Files: %d / %d", processed, total);
 
     ImGui::Spacing();
 
     if (ImGui::Button("Cancel", ImVec2(-1, 0))) {
-        cancel_requested_ = true;
+        export_token_.cancel();
     }
 
     // Check if export finished
@@ -136,7 +149,10 @@ void ExportDialog::render_progress() {
         exporting_ = false;
         export_finished_ = false;
 
-        if (error_message_.empty()) {
+        if (export_token_.cancelled()) {
+            App::instance().set_status("Export cancelled");
+            ImGui::CloseCurrentPopup();
+        } else if (error_message_.empty()) {
             App::instance().set_status("Export completed successfully");
             ImGui::CloseCurrentPopup();
         } else {
@@ -153,39 +169,49 @@ void ExportDialog::start_export() {
     }
 
     exporting_ = true;
-    progress_ = 0.0f;
     files_processed_ = 0;
     total_files_ = 0;
     current_file_.clear();
     error_message_.clear();
-    cancel_requested_ = false;
     export_finished_ = false;
 
-    // Start export in background thread
-    std::thread([this]() {
+    CancellationToken token;
+    export_token_ = token;
+
+    // Export is bulk work: it shares the workers without starving model or texture loads
+    auto& scheduler = TaskScheduler::instance();
+    TaskOptions options;
+    options.priority = TaskPriority::Bulk;
+    options.token = token;
+    options.name = "export";
+    export_task_ = scheduler.submit([this, token]() {
         try {
             AddonExtractor extractor;
             
-            if (extractor.load(source_path_)) {
+            auto loaded = extractor.load(source_path_);
+            if (loaded) {
                 extractor.extract_all(output_path_, 
-                    [this](const std::string& file, size_t current, size_t total) {
-                        current_file_ = file;
+                    [this, token](const std::string& file, size_t current, size_t total) {
+                        {
+                            std::lock_guard<std::mutex> lock(progress_mutex_);
+                            current_file_ = file;
+                        }
                         files_processed_ = static_cast<int>(current);
                         total_files_ = static_cast<int>(total);
-                        progress_ = static_cast<float>(current) / static_cast<float>(total);
-                        return !cancel_requested_;
+                        return !token.cancelled();
                     }
                 );
             } else {
-                error_message_ = "Failed to load addon";
+                error_message_ = "Failed to load addon: " + loaded.error().full_message();
             }
 
         } catch (const std::exception& e) {
             error_message_ = e.what();
         }
+    }, std::move(options));
 
-        export_finished_ = true;
-    }).detach();
+    // Runs even if the export was cancelled before it started
+    finish_task_ = scheduler.run_on_main([this]() { export_finished_ = true; }, {export_task_});
 }
 
 void ExportDialog::browse_output_folder() {
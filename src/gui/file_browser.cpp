@@ -3,19 +3,85 @@
  */
 
 #include "gui/file_browser.hpp"
+#include "gui/app.hpp"
 #include "gui/widgets.hpp"
 #include "enfusion/addon_extractor.hpp"
+#include "enfusion/logging.hpp"
 
 #include <imgui.h>
+#include <glad/glad.h>
 #include <algorithm>
+#include <cctype>
+#include <chrono>
 
 namespace enfusion {
 
+static std::string to_lower(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+static FileType file_type_for(const std::string& path) {
+    auto dot = path.find_last_of("./\\");
+    if (dot == std::string::npos || path[dot] != '.') return FileType::Other;
+
+    std::string ext = to_lower(std::string_view(path).substr(dot));
+    if (ext == ".edds" || ext == ".dds") return FileType::Texture;
+    if (ext == ".xob") return FileType::Mesh;
+    if (ext == ".rdb") return FileType::Database;
+    if (ext == ".pak") return FileType::Archive;
+    if (ext == ".bin" || ext == ".dat") return FileType::Binary;
+    return FileType::Other;
+}
+
+static bool entry_matches(const FileEntry& entry, const std::string& query_lower,
+                          bool textures_only, bool meshes_only) {
+    if (textures_only && entry.type != FileType::Texture) return false;
+    if (meshes_only && entry.type != FileType::Mesh) return false;
+    return query_lower.empty() || entry.name_lower.find(query_lower) != std::string::npos;
+}
+
+FileBrowser::FileBrowser() {
+    // Over the PAK budget, addons opened for the whole-install view go first
+    pak_enforcer_ = memory::Registry::instance().add_enforcer(memory::Subsystem::PakData,
+        [this](size_t usage, size_t budget) { evict_install_addons(usage, budget); });
+}
+
+FileBrowser::~FileBrowser() {
+    memory::Registry::instance().remove_enforcer(pak_enforcer_);
+    cancel_filter_job();
+    reset_thumbnails();
+    // Abandoned batches still call back into this browser for extractors
+    for (auto& task : abandoned_thumbnails_) task.wait();
+    reset_install_view();
+}
+
+void FileBrowser::clear() {
+    cancel_filter_job();
+    reset_thumbnails();
+    reset_install_view();
+    entries_.clear();
+    filtered_entries_.clear();
+    filter_valid_ = false;
+    clear_tree();
+    update_listing_account();
+    selected_entry_ = nullptr;
+    extractor_.reset();
+}
+
 void FileBrowser::load(const std::filesystem::path& addon_path) {
+    // A running filter holds pointers into entries_
+    cancel_filter_job();
+    reset_thumbnails();
+    reset_install_view();
+
     root_path_ = addon_path;
     entries_.clear();
-    tree_root_.children.clear();
-    tree_root_.name = addon_path.filename().string();
+    filtered_entries_.clear();
+    filter_valid_ = false;
+    selected_entry_ = nullptr;
 
     // Try to load from addon directory (with data.pak, rdb, manifest)
     if (std::filesystem::is_directory(addon_path)) {
@@ -37,20 +103,28 @@ void FileBrowser::load(const std::filesystem::path& addon_path) {
         }
     }
 
+    for (auto& entry : entries_) {
+        entry.name_lower = to_lower(entry.name);
+    }
+
     build_tree();
+    update_listing_account();
     apply_filter();
 }
 
 void FileBrowser::load_from_addon(const std::filesystem::path& addon_dir) {
     try {
+        // Only the RDB is needed for listing; the PAK is indexed in the background
         extractor_ = std::make_shared<AddonExtractor>();
-        if (!extractor_->load(addon_dir)) {
+        if (!extractor_->open(addon_dir)) {
             extractor_.reset();
             load_from_directory(addon_dir);  // Fallback
             return;
         }
+        extractor_->index_async();
         
-        auto files = extractor_->list_files();
+        const auto& files = extractor_->files();
+        entries_.reserve(files.size());
         for (const auto& file : files) {
             FileEntry fe;
             fe.path = file.path;
@@ -58,23 +132,7 @@ void FileBrowser::load_from_addon(const std::filesystem::path& addon_dir) {
             fe.size = file.size;
             fe.is_directory = false;
             fe.rdb_index = file.index;
-
-            auto ext = std::filesystem::path(file.path).extension().string();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-
-            if (ext == ".edds" || ext == ".dds") {
-                fe.type = FileType::Texture;
-            } else if (ext == ".xob") {
-                fe.type = FileType::Mesh;
-            } else if (ext == ".rdb") {
-                fe.type = FileType::Database;
-            } else if (ext == ".pak") {
-                fe.type = FileType::Archive;
-            } else if (ext == ".bin" || ext == ".dat") {
-                fe.type = FileType::Binary;
-            } else {
-                fe.type = FileType::Other;
-            }
+            fe.type = file_type_for(file.path);
 
             entries_.push_back(fe);
         }
@@ -95,23 +153,7 @@ void FileBrowser::load_from_directory(const std::filesystem::path& dir_path) {
                 fe.size = entry.file_size();
                 fe.is_directory = false;
                 fe.rdb_index = -1;
-
-                auto ext = entry.path().extension().string();
-                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-
-                if (ext == ".edds" || ext == ".dds") {
-                    fe.type = FileType::Texture;
-                } else if (ext == ".xob") {
-                    fe.type = FileType::Mesh;
-                } else if (ext == ".rdb") {
-                    fe.type = FileType::Database;
-                } else if (ext == ".pak") {
-                    fe.type = FileType::Archive;
-                } else if (ext == ".bin" || ext == ".dat") {
-                    fe.type = FileType::Binary;
-                } else {
-                    fe.type = FileType::Other;
-                }
+                fe.type = file_type_for(fe.name);
 
                 entries_.push_back(fe);
             }
@@ -121,83 +163,391 @@ void FileBrowser::load_from_directory(const std::filesystem::path& dir_path) {
     }
 }
 
-void FileBrowser::build_tree() {
-    for (const auto& entry : entries_) {
-        add_to_tree(&tree_root_, entry.path, &entry);
+void FileBrowser::load_install(const std::filesystem::path& game_path, const std::filesystem::path& mods_path) {
+    cancel_filter_job();
+    reset_thumbnails();
+    reset_install_view();
+
+    root_path_ = game_path.empty() ? mods_path : game_path;
+    entries_.clear();
+    filtered_entries_.clear();
+    filter_valid_ = false;
+    selected_entry_ = nullptr;
+    extractor_.reset();
+    clear_tree();
+    install_view_ = true;
+
+    // List the last committed index right away; only a first run has to wait
+    // for the full build. The listing is a single ordered scan of the files table
+    install_from_snapshot_ = false;
+    install_future_ = TaskScheduler::instance().async(TaskPriority::Interactive, [this, game_path, mods_path]() {
+        auto& index = PakIndex::instance();
+        index.set_game_path(game_path);
+        index.set_mods_path(mods_path);
+        if (!index.open_database()) {
+            return PakIndex::InstallListing{};
+        }
+        if (index.load_snapshot()) {
+            install_from_snapshot_ = true;
+        } else {
+            index.build_index();
+        }
+        return index.list_install();
+    });
+}
+
+void FileBrowser::poll_install_job() {
+    auto& index = PakIndex::instance();
+
+    // Background refresh finished: re-list only if it changed anything
+    if (index_refresh_.valid() && index_refresh_.ready()) {
+        index_refresh_.get();
+        if (index.generation() != listed_generation_ && !install_future_.valid()) {
+            install_future_ = TaskScheduler::instance().async(TaskPriority::Interactive, []() {
+                return PakIndex::instance().list_install();
+            });
+        }
+    }
+
+    if (!install_future_.valid()) return;
+    if (!install_future_.ready()) return;
+
+    apply_install_listing(install_future_.get());
+
+    // The snapshot may be stale; checking every PAK against disk runs behind the tree
+    if (install_from_snapshot_.exchange(false)) {
+        index_refresh_ = TaskScheduler::instance().async(TaskPriority::Bulk, []() {
+            return PakIndex::instance().build_index();
+        });
     }
 }
 
-void FileBrowser::add_to_tree(TreeNode* parent, const std::string& path, const FileEntry* entry) {
-    size_t pos = path.find('/');
-    if (pos == std::string::npos) {
-        pos = path.find('\\');
+void FileBrowser::apply_install_listing(PakIndex::InstallListing listing) {
+    listed_generation_ = PakIndex::instance().generation();
+
+    // A refreshed listing replaces the entries the tree and selection point into
+    std::string selected_path = selected_entry_ ? selected_entry_->path : std::string();
+    cancel_filter_job();
+    entries_.clear();
+    filtered_entries_.clear();
+    filter_valid_ = false;
+    selected_entry_ = nullptr;
+    {
+        // Addons opened against the old listing may have changed on disk
+        std::lock_guard<std::mutex> lock(install_addons_mutex_);
+        install_addons_.clear();
+    }
+
+    install_paks_ = std::move(listing.paks);
+
+    entries_.reserve(listing.files.size());
+    for (auto& file : listing.files) {
+        FileEntry fe;
+        fe.path = std::move(file.path);
+        size_t slash = fe.path.find_last_of("/\\");
+        fe.name = slash == std::string::npos ? fe.path : fe.path.substr(slash + 1);
+        fe.name_lower = to_lower(fe.name);
+        fe.type = file_type_for(fe.name);
+        fe.source = static_cast<int32_t>(file.pak);
+        fe.providers = file.providers;
+        entries_.push_back(std::move(fe));
     }
 
-    if (pos == std::string::npos) {
-        // Leaf node (file)
-        TreeNode node;
-        node.name = path;
-        node.is_file = true;
-        node.entry = entry;
-        parent->children.push_back(node);
-    } else {
-        // Directory
-        std::string dir_name = path.substr(0, pos);
-        std::string remaining = path.substr(pos + 1);
-
-        // Find or create directory node
-        TreeNode* dir_node = nullptr;
-        for (auto& child : parent->children) {
-            if (!child.is_file && child.name == dir_name) {
-                dir_node = &child;
-                break;
-            }
+    build_tree();
+    update_listing_account();
+    apply_filter();
+
+    if (!selected_path.empty()) {
+        auto it = std::find_if(entries_.begin(), entries_.end(),
+                               [&](const FileEntry& entry) { return entry.path == selected_path; });
+        if (it != entries_.end()) selected_entry_ = &*it;
+    }
+}
+
+void FileBrowser::reset_install_view() {
+    if (install_future_.valid() || index_refresh_.valid()) {
+        PakIndex::instance().cancel_indexing();
+        if (install_future_.valid()) install_future_.wait();
+        if (index_refresh_.valid()) index_refresh_.wait();
+        install_future_ = {};
+        index_refresh_ = {};
+    }
+    install_from_snapshot_ = false;
+    install_view_ = false;
+    install_paks_.clear();
+
+    std::lock_guard<std::mutex> lock(install_addons_mutex_);
+    install_addons_.clear();
+}
+
+std::shared_ptr<AddonExtractor> FileBrowser::extractor_for(const std::string& path) {
+    if (!install_view_) return extractor_;
+    return install_extractor_for(path);
+}
+
+std::shared_ptr<AddonExtractor> FileBrowser::install_extractor_for(const std::string& path) {
+    // Paths outside the listing (textures a model references) resolve the same way
+    auto paks = PakIndex::instance().find_all_paks_for_file(path);
+    if (paks.empty()) return nullptr;
+    return extractor_for_addon(paks.front().parent_path());
+}
+
+std::shared_ptr<AddonExtractor> FileBrowser::extractor_for_addon(const std::filesystem::path& addon_dir) {
+    std::lock_guard<std::mutex> lock(install_addons_mutex_);
+    auto it = install_addons_.find(addon_dir.string());
+    if (it != install_addons_.end()) {
+        it->second.last_used = ++install_use_clock_;
+        return it->second.extractor;
+    }
+
+    // First read from this addon: parse its RDB and index the PAK in the background
+    auto extractor = std::make_shared<AddonExtractor>();
+    if (!extractor->open(addon_dir)) return nullptr;
+    extractor->index_async();
+    install_addons_.emplace(addon_dir.string(), InstallAddon{extractor, ++install_use_clock_});
+    return extractor;
+}
+
+void FileBrowser::evict_install_addons(size_t usage, size_t budget) {
+    std::vector<std::shared_ptr<AddonExtractor>> evicted;
+    size_t freed = 0;
+    {
+        std::lock_guard<std::mutex> lock(install_addons_mutex_);
+
+        std::vector<decltype(install_addons_)::iterator> order;
+        order.reserve(install_addons_.size());
+        for (auto it = install_addons_.begin(); it != install_addons_.end(); ++it) {
+            order.push_back(it);
         }
+        std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+            return a->second.last_used < b->second.last_used;
+        });
+
+        // Least recently used first. Copies are only handed out under this
+        // lock, so a sole owner here means no worker is reading from it.
+        for (auto it : order) {
+            if (usage - freed <= budget) break;
+            auto& extractor = it->second.extractor;
+            if (extractor.use_count() > 1 || extractor->resident_bytes() == 0) continue;
+
+            freed += std::min(extractor->resident_bytes(), usage - freed);
+            evicted.push_back(std::move(extractor));
+            install_addons_.erase(it);
+        }
+    }
+
+    // Destroyed outside the lock, an extractor may wait for its indexing thread
+    if (!evicted.empty()) {
+        LOG_INFO("FileBrowser", "Evicted " << evicted.size() << " addons (" << format_size(freed)
+                 << ") to stay within the PAK data budget");
+    }
+}
 
-        if (!dir_node) {
-            TreeNode node;
-            node.name = dir_name;
-            node.is_file = false;
-            parent->children.push_back(node);
-            dir_node = &parent->children.back();
+void FileBrowser::update_listing_account() {
+    size_t bytes = memory::heap_bytes(entries_) + memory::heap_bytes(nodes_) + memory::heap_bytes(visible_rows_);
+    for (const auto& entry : entries_) {
+        bytes += memory::heap_bytes(entry.path) + memory::heap_bytes(entry.name) + memory::heap_bytes(entry.name_lower);
+    }
+    for (const auto& name : names_) {
+        bytes += sizeof(std::string) + memory::heap_bytes(name);
+    }
+    // Hash nodes: key, value and a next pointer, plus the bucket array
+    bytes += name_ids_.size() * (sizeof(std::pair<const std::string_view, uint32_t>) + sizeof(void*)) +
+             name_ids_.bucket_count() * sizeof(void*);
+    bytes += dir_children_.size() * (sizeof(std::pair<const uint64_t, int32_t>) + sizeof(void*)) +
+             dir_children_.bucket_count() * sizeof(void*);
+    listing_account_.set(bytes);
+}
+
+void FileBrowser::build_tree() {
+    clear_tree();
+    nodes_.reserve(entries_.size() + entries_.size() / 8 + 1);
+
+    // Root node
+    add_node(-1, intern_name(root_path_.filename().string()), false, nullptr);
+
+    // Single pass: walk each path's directory components, creating them on first sight
+    for (const auto& entry : entries_) {
+        std::string_view path = entry.path;
+        int32_t parent = 0;
+        size_t start = 0;
+
+        size_t sep;
+        while ((sep = path.find_first_of("/\\", start)) != std::string_view::npos) {
+            std::string_view dir_name = path.substr(start, sep - start);
+            start = sep + 1;
+            if (dir_name.empty()) continue;
+
+            uint32_t name = intern_name(dir_name);
+            uint64_t key = (static_cast<uint64_t>(parent) << 32) | name;
+            auto [it, inserted] = dir_children_.try_emplace(key, -1);
+            if (inserted) {
+                it->second = add_node(parent, name, false, nullptr);
+            }
+            parent = it->second;
         }
 
-        add_to_tree(dir_node, remaining, entry);
+        // File names are mostly unique, so store them without interning
+        names_.emplace_back(path.substr(start));
+        add_node(parent, static_cast<uint32_t>(names_.size() - 1), true, &entry);
     }
 }
 
+void FileBrowser::clear_tree() {
+    nodes_.clear();
+    names_.clear();
+    name_ids_.clear();
+    dir_children_.clear();
+    visible_rows_.clear();
+    rows_dirty_ = true;
+}
+
+int32_t FileBrowser::add_node(int32_t parent, uint32_t name, bool is_file, const FileEntry* entry) {
+    int32_t index = static_cast<int32_t>(nodes_.size());
+
+    TreeNode node;
+    node.name = name;
+    node.parent = parent;
+    node.is_file = is_file;
+    node.entry = entry;
+    node.depth = parent >= 0 ? static_cast<uint16_t>(nodes_[parent].depth + 1) : 0;
+    nodes_.push_back(node);
+
+    // Append to parent's child list, keeping insertion order
+    if (parent >= 0) {
+        TreeNode& p = nodes_[parent];
+        if (p.last_child >= 0) {
+            nodes_[p.last_child].next_sibling = index;
+        } else {
+            p.first_child = index;
+        }
+        p.last_child = index;
+    }
+
+    return index;
+}
+
+uint32_t FileBrowser::intern_name(std::string_view name) {
+    auto it = name_ids_.find(name);
+    if (it != name_ids_.end()) return it->second;
+
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.emplace_back(name);
+    name_ids_.emplace(names_.back(), id);
+    return id;
+}
+
 void FileBrowser::apply_filter() {
-    filtered_entries_.clear();
+    std::string query = to_lower(search_filter_);
+
+    // If the current result came from a query contained in the new one (same type
+    // filters), every new match is already in it - narrow that instead of rescanning
+    bool narrowing = filter_valid_ &&
+                     filtered_textures_ == filter_textures_ &&
+                     filtered_meshes_ == filter_meshes_ &&
+                     query.find(filtered_query_) != std::string::npos;
+
+    // Superseded by this request
+    if (filter_job_) {
+        filter_job_->cancel = true;
+    }
 
-    std::string filter_lower = search_filter_;
-    std::transform(filter_lower.begin(), filter_lower.end(), filter_lower.begin(), ::tolower);
+    size_t candidate_count = narrowing ? filtered_entries_.size() : entries_.size();
 
-    for (const auto& entry : entries_) {
-        bool matches = filter_lower.empty();
+    if (candidate_count < BACKGROUND_FILTER_THRESHOLD) {
+        std::vector<const FileEntry*> results;
+        if (narrowing) {
+            for (const auto* entry : filtered_entries_) {
+                if (entry_matches(*entry, query, filter_textures_, filter_meshes_)) {
+                    results.push_back(entry);
+                }
+            }
+        } else {
+            for (const auto& entry : entries_) {
+                if (entry_matches(entry, query, filter_textures_, filter_meshes_)) {
+                    results.push_back(&entry);
+                }
+            }
+        }
 
-        if (!matches) {
-            std::string name_lower = entry.name;
-            std::transform(name_lower.begin(), name_lower.end(), name_lower.begin(), ::tolower);
-            matches = name_lower.find(filter_lower) != std::string::npos;
+        filtered_entries_ = std::move(results);
+        filtered_query_ = std::move(query);
+        filtered_textures_ = filter_textures_;
+        filtered_meshes_ = filter_meshes_;
+        filter_valid_ = true;
+        return;
+    }
+
+    // Large set: filter on a worker and swap the result in when it finishes
+    auto job = std::make_shared<FilterJob>();
+    job->query = std::move(query);
+    job->textures = filter_textures_;
+    job->meshes = filter_meshes_;
+    if (narrowing) {
+        job->candidates = filtered_entries_;
+    } else {
+        job->candidates.reserve(entries_.size());
+        for (const auto& entry : entries_) {
+            job->candidates.push_back(&entry);
         }
+    }
 
-        if (matches) {
-            // Apply type filter
-            if (filter_textures_ && entry.type != FileType::Texture) continue;
-            if (filter_meshes_ && entry.type != FileType::Mesh) continue;
+    // Previous job was cancelled above and exits at its next check
+    if (filter_future_.valid()) {
+        filter_future_.wait();
+    }
 
-            filtered_entries_.push_back(&entry);
+    filter_job_ = job;
+    filter_future_ = TaskScheduler::instance().async(TaskPriority::Interactive, [job]() {
+        for (size_t i = 0; i < job->candidates.size(); ++i) {
+            if ((i & 0xFFF) == 0 && job->cancel) return;
+            const FileEntry* entry = job->candidates[i];
+            if (entry_matches(*entry, job->query, job->textures, job->meshes)) {
+                job->results.push_back(entry);
+            }
         }
+    });
+}
+
+void FileBrowser::poll_filter_job() {
+    if (!filter_future_.valid()) return;
+    if (!filter_future_.ready()) return;
+
+    filter_future_.get();
+    auto job = std::move(filter_job_);
+    if (!job || job->cancel) return;
+
+    filtered_entries_ = std::move(job->results);
+    filtered_query_ = std::move(job->query);
+    filtered_textures_ = job->textures;
+    filtered_meshes_ = job->meshes;
+    filter_valid_ = true;
+}
+
+void FileBrowser::cancel_filter_job() {
+    if (filter_job_) {
+        filter_job_->cancel = true;
     }
+    if (filter_future_.valid()) {
+        filter_future_.wait();
+        filter_future_ = {};
+    }
+    filter_job_.reset();
 }
 
 std::vector<uint8_t> FileBrowser::read_selected_file() {
-    if (!selected_entry_ || !extractor_) return {};
-    
-    return extractor_->read_file(selected_entry_->path);
+    if (!selected_entry_) return {};
+
+    auto extractor = extractor_for(selected_entry_->path);
+    if (!extractor) return {};
+    return extractor->read_file(selected_entry_->path).value_or({});
 }
 
 void FileBrowser::render() {
+    poll_install_job();
+    poll_filter_job();
+    poll_thumbnails();
+
     // Search and filter bar
     ImGui::SetNextItemWidth(-1);
     if (widgets::SearchInput("##FileSearch", search_filter_, 256)) {
@@ -232,17 +582,31 @@ void FileBrowser::render() {
     ImGui::RadioButton("Tree", reinterpret_cast<int*>(&view_mode_), 0);
     ImGui::SameLine();
     ImGui::RadioButton("List", reinterpret_cast<int*>(&view_mode_), 1);
+    ImGui::SameLine();
+    ImGui::RadioButton("Grid", reinterpret_cast<int*>(&view_mode_), 2);
+
+    // The snapshot stays browsable while it is checked against disk
+    if (index_refresh_.valid() && !entries_.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Refreshing index... %d%%", PakIndex::instance().progress());
+        App::instance().request_redraw(0.1);
+    }
 
     ImGui::Spacing();
 
     // File list/tree
     ImGui::BeginChild("FileList", ImVec2(0, 0), true);
 
-    if (entries_.empty()) {
+    if (install_future_.valid() && entries_.empty()) {
+        ImGui::TextDisabled("Indexing install... %d%%", PakIndex::instance().progress());
+        App::instance().request_redraw(0.1);
+    } else if (entries_.empty()) {
         ImGui::TextDisabled("No files loaded.");
         ImGui::TextDisabled("Select an addon to browse.");
     } else if (view_mode_ == ViewMode::Tree) {
-        render_tree_node(tree_root_);
+        render_tree();
+    } else if (view_mode_ == ViewMode::Grid) {
+        render_grid();
     } else {
         render_flat_list();
     }
@@ -250,11 +614,61 @@ void FileBrowser::render() {
     ImGui::EndChild();
 }
 
-void FileBrowser::render_tree_node(const TreeNode& node) {
-    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick;
+void FileBrowser::rebuild_visible_rows() {
+    visible_rows_.clear();
+    rows_dirty_ = false;
+    if (nodes_.empty()) return;
+
+    // Pre-order walk that only descends into open directories
+    std::vector<int32_t> stack;
+    stack.push_back(0);
+    while (!stack.empty()) {
+        int32_t index = stack.back();
+        stack.pop_back();
+        visible_rows_.push_back(index);
+
+        const TreeNode& node = nodes_[index];
+        if (node.is_file || !node.open) continue;
+
+        // Push children in reverse so they come off the stack in order
+        size_t first = stack.size();
+        for (int32_t child = node.first_child; child >= 0; child = nodes_[child].next_sibling) {
+            stack.push_back(child);
+        }
+        std::reverse(stack.begin() + first, stack.end());
+    }
+}
+
+void FileBrowser::render_tree() {
+    if (rows_dirty_) {
+        rebuild_visible_rows();
+    }
+
+    // Only rows on screen are submitted; toggles mark the list dirty for next frame
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(visible_rows_.size()));
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            ImGui::PushID(row);
+            render_tree_row(visible_rows_[row]);
+            ImGui::PopID();
+        }
+    }
+    clipper.End();
+}
+
+void FileBrowser::render_tree_row(int32_t index) {
+    TreeNode& node = nodes_[index];
+    const std::string& name = names_[node.name];
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick |
+                               ImGuiTreeNodeFlags_NoTreePushOnOpen;
+
+    // Rows are flat, so indent by depth instead of nesting TreePush
+    float indent = node.depth * ImGui::GetStyle().IndentSpacing;
+    if (indent > 0.0f) ImGui::Indent(indent);
 
     if (node.is_file) {
-        flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+        flags |= ImGuiTreeNodeFlags_Leaf;
 
         // Get icon based on type
         const char* icon = get_type_icon(node.entry ? node.entry->type : FileType::Other);
@@ -262,7 +676,8 @@ void FileBrowser::render_tree_node(const TreeNode& node) {
         bool selected = (selected_entry_ == node.entry);
         if (selected) flags |= ImGuiTreeNodeFlags_Selected;
 
-        ImGui::TreeNodeEx(node.name.c_str(), flags, "%s %s", icon, node.name.c_str());
+        const char* marker = (node.entry && node.entry->providers > 1) ? " *" : "";
+        ImGui::TreeNodeEx(name.c_str(), flags, "%s %s%s", icon, name.c_str(), marker);
 
         if (ImGui::IsItemClicked()) {
             selected_entry_ = node.entry;
@@ -272,59 +687,264 @@ void FileBrowser::render_tree_node(const TreeNode& node) {
             }
         }
 
-        // Tooltip with size
         if (ImGui::IsItemHovered() && node.entry) {
-            ImGui::BeginTooltip();
-            ImGui::Text("%s", node.entry->path.c_str());
-            ImGui::TextDisabled("Size: %s", format_size(node.entry->size).c_str());
-            ImGui::EndTooltip();
+            render_entry_tooltip(*node.entry);
         }
     } else {
         // Directory
-        if (ImGui::TreeNodeEx(node.name.c_str(), flags, "[D] %s", node.name.c_str())) {
-            for (const auto& child : node.children) {
-                render_tree_node(child);
-            }
-            ImGui::TreePop();
+        ImGui::SetNextItemOpen(node.open);
+        bool open = ImGui::TreeNodeEx(name.c_str(), flags, "[D] %s", name.c_str());
+        if (open != node.open) {
+            node.open = open;
+            rows_dirty_ = true;
         }
     }
+
+    if (indent > 0.0f) ImGui::Unindent(indent);
 }
 
 void FileBrowser::render_flat_list() {
-    ImGui::Text("%zu files", filtered_entries_.size());
+    if (filter_job_) {
+        ImGui::Text("%zu files (filtering...)", filtered_entries_.size());
+    } else {
+        ImGui::Text("%zu files", filtered_entries_.size());
+    }
     ImGui::Separator();
 
-    for (const auto* entry : filtered_entries_) {
-        const char* icon = get_type_icon(entry->type);
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(filtered_entries_.size()));
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            const FileEntry* entry = filtered_entries_[row];
+            ImGui::PushID(row);
+            const char* icon = get_type_icon(entry->type);
 
-        bool selected = (selected_entry_ == entry);
+            bool selected = (selected_entry_ == entry);
 
-        if (ImGui::Selectable((std::string(icon) + " " + entry->name).c_str(), selected)) {
-            selected_entry_ = entry;
-            if (on_file_selected) {
-                on_file_selected(entry->path);
+            if (ImGui::Selectable((std::string(icon) + " " + entry->name).c_str(), selected)) {
+                selected_entry_ = entry;
+                if (on_file_selected) {
+                    on_file_selected(entry->path);
+                }
             }
-        }
 
-        // Context menu
-        if (ImGui::BeginPopupContextItem()) {
-            if (ImGui::MenuItem("Export...")) {
-                // TODO: Export dialog
+            // Context menu
+            if (ImGui::BeginPopupContextItem()) {
+                if (ImGui::MenuItem("Export...")) {
+                    // TODO: Export dialog
+                }
+                if (ImGui::MenuItem("Copy Path")) {
+                    ImGui::SetClipboardText(entry->path.c_str());
+                }
+                ImGui::EndPopup();
             }
-            if (ImGui::MenuItem("Copy Path")) {
-                ImGui::SetClipboardText(entry->path.c_str());
+
+            if (ImGui::IsItemHovered()) {
+                render_entry_tooltip(*entry);
             }
-            ImGui::EndPopup();
+
+            ImGui::PopID();
         }
+    }
+    clipper.End();
+}
 
-        // Show size on hover
-        if (ImGui::IsItemHovered()) {
-            ImGui::BeginTooltip();
-            ImGui::Text("%s", entry->path.c_str());
-            ImGui::TextDisabled("Size: %s", format_size(entry->size).c_str());
-            ImGui::EndTooltip();
+void FileBrowser::render_grid() {
+    if (filter_job_) {
+        ImGui::Text("%zu files (filtering...)", filtered_entries_.size());
+    } else {
+        ImGui::Text("%zu files", filtered_entries_.size());
+    }
+    ImGui::Separator();
+
+    const ImGuiStyle& style = ImGui::GetStyle();
+    const float tile = 96.0f;
+    const ImVec2 cell(tile, tile + style.ItemInnerSpacing.y + ImGui::GetTextLineHeight());
+    float avail = ImGui::GetContentRegionAvail().x;
+    int columns = std::max(1, static_cast<int>((avail + style.ItemSpacing.x) / (cell.x + style.ItemSpacing.x)));
+    int rows = static_cast<int>((filtered_entries_.size() + columns - 1) / columns);
+
+    // Thumbnails are only requested for rows the clipper actually submits
+    ImGuiListClipper clipper;
+    clipper.Begin(rows, cell.y + style.ItemSpacing.y);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                size_t index = static_cast<size_t>(row) * columns + column;
+                if (index >= filtered_entries_.size()) break;
+                const FileEntry* entry = filtered_entries_[index];
+
+                if (column > 0) ImGui::SameLine();
+                ImGui::PushID(static_cast<int>(index));
+
+                bool selected = (selected_entry_ == entry);
+                if (ImGui::Selectable("##tile", selected, 0, cell)) {
+                    selected_entry_ = entry;
+                    if (on_file_selected) {
+                        on_file_selected(entry->path);
+                    }
+                }
+
+                if (ImGui::BeginPopupContextItem()) {
+                    if (ImGui::MenuItem("Copy Path")) {
+                        ImGui::SetClipboardText(entry->path.c_str());
+                    }
+                    ImGui::EndPopup();
+                }
+
+                if (ImGui::IsItemHovered()) {
+                    render_entry_tooltip(*entry);
+                }
+
+                uint32_t texture = 0;
+                if (entry->type == FileType::Mesh) {
+                    auto it = thumbnails_.find(entry->path);
+                    if (it == thumbnails_.end()) {
+                        request_thumbnail(*entry);
+                    } else {
+                        texture = it->second.texture;
+                    }
+                }
+
+                ImVec2 min = ImGui::GetItemRectMin();
+                ImDrawList* draw = ImGui::GetWindowDrawList();
+                if (texture != 0) {
+                    draw->AddImage(static_cast<ImTextureID>(static_cast<uintptr_t>(texture)),
+                                   min, ImVec2(min.x + tile, min.y + tile));
+                } else {
+                    const char* icon = get_type_icon(entry->type);
+                    ImVec2 size = ImGui::CalcTextSize(icon);
+                    draw->AddText(ImVec2(min.x + (tile - size.x) * 0.5f, min.y + (tile - size.y) * 0.5f),
+                                  ImGui::GetColorU32(ImGuiCol_TextDisabled), icon);
+                }
+
+                // Name under the tile, cut off at its edge
+                float label_y = min.y + tile + style.ItemInnerSpacing.y;
+                draw->PushClipRect(ImVec2(min.x, label_y), ImVec2(min.x + cell.x, min.y + cell.y), true);
+                draw->AddText(ImVec2(min.x, label_y), ImGui::GetColorU32(ImGuiCol_Text), entry->name.c_str());
+                draw->PopClipRect();
+
+                ImGui::PopID();
+            }
         }
     }
+    clipper.End();
+}
+
+void FileBrowser::request_thumbnail(const FileEntry& entry) {
+    thumbnails_.emplace(entry.path, Thumbnail{});
+    thumbnail_queue_.push_back(entry.path);
+}
+
+void FileBrowser::poll_thumbnails() {
+    std::erase_if(abandoned_thumbnails_, [](const Task<void>& task) { return task.ready(); });
+
+    if (thumbnail_job_) {
+        // Checked before taking results, so nothing finishing in between is lost
+        bool complete = thumbnail_task_.ready();
+
+        std::vector<std::pair<std::string, TextureData>> finished;
+        {
+            std::lock_guard<std::mutex> lock(thumbnail_job_->mutex);
+            finished.swap(thumbnail_job_->finished);
+        }
+
+        for (auto& [path, image] : finished) {
+            if (thumbnail_job_->generation != thumbnail_generation_) break;
+            auto it = thumbnails_.find(path);
+            if (it == thumbnails_.end() || image.width == 0) continue;
+
+            GLuint texture = 0;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+            glBindTexture(GL_TEXTURE_2D, 0);
+            it->second.texture = texture;
+        }
+
+        if (complete) {
+            thumbnail_task_ = {};
+            thumbnail_job_.reset();
+        }
+    }
+
+    if (!thumbnail_job_ && !thumbnail_queue_.empty()) {
+        auto job = std::make_shared<ThumbnailJob>();
+        job->generation = thumbnail_generation_;
+
+        // Newest first: whatever was scrolled into view last is what the user is looking at
+        while (!thumbnail_queue_.empty() && job->requests.size() < THUMBNAIL_BATCH) {
+            ThumbnailRequest request;
+            request.path = std::move(thumbnail_queue_.back());
+            thumbnail_queue_.pop_back();
+            job->requests.push_back(std::move(request));
+        }
+
+        // Same extractor rules as the model viewer's texture loader
+        bool install_view = install_view_;
+        auto extractor = extractor_;
+        CancellationToken cancel = job->cancel;
+        thumbnail_task_ = TaskScheduler::instance().async(TaskPriority::Bulk, [this, job, install_view, extractor]() {
+            for (auto& request : job->requests) {
+                if (job->cancel.cancelled()) return;
+                auto source = install_view ? install_extractor_for(request.path) : extractor;
+                if (!source) continue;
+                request.key = source->content_key(request.path);
+                request.read = [source, path = request.path]() { return source->read_file(path).value_or({}); };
+            }
+
+            RasterOptions options;
+            options.size = THUMBNAIL_SIZE;
+            ThumbnailCache::instance().render_all(job->requests, options, TaskPriority::Bulk, job->cancel,
+                [job](size_t i, TextureData image) {
+                    std::lock_guard<std::mutex> lock(job->mutex);
+                    job->finished.emplace_back(job->requests[i].path, std::move(image));
+                });
+        }, cancel);
+        thumbnail_job_ = std::move(job);
+    }
+
+    if (thumbnail_job_) App::instance().request_redraw(0.1);
+}
+
+void FileBrowser::reset_thumbnails() {
+    // The batch may be reading a PAK or rasterizing; let it wind down on its
+    // own and ignore whatever it still produces
+    thumbnail_generation_++;
+    if (thumbnail_job_) {
+        thumbnail_job_->cancel.cancel();
+        if (thumbnail_task_.valid()) abandoned_thumbnails_.push_back(std::move(thumbnail_task_));
+        thumbnail_task_ = {};
+        thumbnail_job_.reset();
+    }
+
+    for (auto& [path, thumbnail] : thumbnails_) {
+        if (thumbnail.texture != 0) glDeleteTextures(1, &thumbnail.texture);
+    }
+    thumbnails_.clear();
+    thumbnail_queue_.clear();
+}
+
+void FileBrowser::render_entry_tooltip(const FileEntry& entry) const {
+    ImGui::BeginTooltip();
+    ImGui::Text("%s", entry.path.c_str());
+    if (entry.source >= 0 && static_cast<size_t>(entry.source) < install_paks_.size()) {
+        // Index has no per-file sizes; show where the file comes from instead
+        const auto& pak = install_paks_[entry.source];
+        ImGui::TextDisabled("From: %s/%s", pak.parent_path().filename().string().c_str(),
+                            pak.filename().string().c_str());
+        if (entry.providers > 1) {
+            ImGui::TextDisabled("Overrides %d other PAK(s)", entry.providers - 1);
+        }
+    } else {
+        ImGui::TextDisabled("Size: %s", format_size(entry.size).c_str());
+    }
+    ImGui::EndTooltip();
 }
 
 const char* FileBrowser::get_type_icon(FileType type) const {
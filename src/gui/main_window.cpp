@@ -7,6 +7,8 @@
 #include "gui/theme.hpp"
 #include "gui/text_viewer.hpp"
 #include "enfusion/addon_extractor.hpp"
+#include "enfusion/mesh_cache.hpp"
+#include "enfusion/trace.hpp"
 
 #include <imgui.h>
 #include <imgui_internal.h>
@@ -27,9 +29,29 @@ MainWindow::MainWindow() {
     file_browser_ = std::make_unique<FileBrowser>();
     texture_viewer_ = std::make_unique<TextureViewer>();
     model_viewer_ = std::make_unique<ModelViewer>();
+    scene_viewer_ = std::make_unique<SceneViewer>();
     text_viewer_ = std::make_unique<TextViewer>();
     export_dialog_ = std::make_unique<ExportDialog>();
     settings_dialog_ = std::make_unique<SettingsDialog>();
+    performance_panel_ = std::make_unique<PerformancePanel>();
+    content_search_ = std::make_unique<ContentSearchPanel>();
+
+    content_search_->on_hit_selected = [this](const ContentSearchHit& hit) {
+        auto job = std::make_shared<OpenJob>();
+        job->path = hit.path;
+        job->line = hit.line;
+        // Reuse the addon the browser has open, or the cached one from an earlier hit
+        auto current = file_browser_->extractor();
+        std::error_code ec;
+        if (current && std::filesystem::equivalent(current->addon_dir(), hit.addon_dir, ec)) {
+            job->extractor = current;
+        } else {
+            job->resolve = [browser = file_browser_.get(), addon_dir = hit.addon_dir]() {
+                return browser->extractor_for_addon(addon_dir);
+            };
+        }
+        start_open_job(std::move(job));
+    };
 
     addon_browser_->on_addon_selected = [this](const std::filesystem::path& path) {
         current_addon_path_ = path;
@@ -38,47 +60,163 @@ MainWindow::MainWindow() {
     };
 
     file_browser_->on_file_selected = [this](const std::string& file_path) {
-        selected_file_path_ = file_path;
+        auto job = std::make_shared<OpenJob>();
+        job->path = file_path;
+        if (file_browser_->is_install_view()) {
+            // The owning addon is opened on the worker the first time one of its files is read
+            job->resolve = [browser = file_browser_.get(), file_path]() { return browser->install_extractor_for(file_path); };
+        } else {
+            job->extractor = file_browser_->extractor();
+        }
+        start_open_job(std::move(job));
+    };
+}
 
-        auto ext = std::filesystem::path(file_path).extension().string();
-        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+MainWindow::~MainWindow() {
+    // The read may still be using the file browser
+    if (open_job_) open_job_->cancel.cancel();
+    if (open_read_.valid()) open_read_.wait();
+}
 
-        auto extractor = file_browser_->extractor();
-        if (!extractor) {
-            App::instance().set_status("Error: No extractor available");
-            return;
-        }
+void MainWindow::start_open_job(std::shared_ptr<OpenJob> job) {
+    // A newer selection replaces one still reading; its continuation won't run
+    if (open_job_ && !open_job_->finished) {
+        open_job_->cancel.cancel();
+        if (open_job_->trace_capture) trace::end_capture();
+    }
+
+    selected_file_path_ = job->path;
+    job->ext = std::filesystem::path(job->path).extension().string();
+    std::transform(job->ext.begin(), job->ext.end(), job->ext.begin(), ::tolower);
+
+    // An armed trace capture records this model open from the read to the last texture
+    job->trace_capture = job->ext == ".xob" && trace::begin_capture();
 
-        auto data = extractor->read_file(file_path);
-        if (data.empty()) {
-            App::instance().set_status("Error: Could not read file: " + file_path);
+    App::instance().set_status("Reading: " + job->path);
+
+    auto& scheduler = TaskScheduler::instance();
+    TaskOptions options;
+    options.priority = TaskPriority::Interactive;
+    options.token = job->cancel;
+    options.name = "file.open";
+    open_read_ = scheduler.submit([job]() { read_open_job(*job); }, std::move(options));
+    scheduler.run_on_main([this, job]() { finish_open_job(*job); }, {open_read_}, job->cancel);
+    open_job_ = std::move(job);
+}
+
+void MainWindow::read_open_job(OpenJob& job) {
+    if (job.cancel.cancelled()) return;
+
+    if (job.resolve) job.extractor = job.resolve();
+    if (!job.extractor) {
+        job.error = "No extractor available";
+        return;
+    }
+
+    // A model seen before comes from the mesh cache without reading or inflating the XOB
+    if (job.ext == ".xob") {
+        job.mesh_key = job.extractor->content_key(job.path);
+        if (!job.mesh_key.empty() && MeshCache::instance().contains(job.mesh_key)) {
+            job.cached_mesh = true;
             return;
         }
+    }
 
-        App::instance().set_status("Loaded: " + file_path + " (" + std::to_string(data.size()) + " bytes)");
-
-        if (ext == ".edds" || ext == ".dds") {
-            texture_viewer_->load_texture_data(data, file_path);
-            show_texture_viewer_ = true;
-        } else if (ext == ".xob") {
-            // Set up texture loader for the model viewer
-            model_viewer_->set_texture_loader([extractor](const std::string& path) -> std::vector<uint8_t> {
-                return extractor->read_file(path);
-            });
-            // Provide list of available textures for texture browser
-            model_viewer_->set_available_textures(file_browser_->get_texture_paths());
-            model_viewer_->load_model_data(data, file_path);
-            show_model_viewer_ = true;
-        } else if (ext == ".c" || ext == ".et" || ext == ".conf" || ext == ".layout" ||
-                   ext == ".xml" || ext == ".json" || ext == ".txt" || ext == ".cfg" ||
-                   ext == ".meta" || ext == ".script") {
-            text_viewer_->load_text_data(data, file_path);
-            show_text_viewer_ = true;
-        }
-    };
+    // Waits for the addon's PAK index if it is still being built
+    auto result = job.extractor->read_file(job.path);
+    if (!result) {
+        job.error = "Could not read file: " + result.error().full_message();
+        return;
+    }
+    job.data = std::move(result).value_or({});
+    if (job.data.empty()) {
+        job.error = "File is empty: " + job.path;
+    }
+}
+
+void MainWindow::finish_open_job(OpenJob& job) {
+    job.finished = true;
+    const auto& file_path = job.path;
+    const auto& ext = job.ext;
+    auto extractor = job.extractor;
+
+    if (!job.error.empty()) {
+        if (job.trace_capture) trace::end_capture();
+        App::instance().set_status("Error: " + job.error);
+        return;
+    }
+
+    if (job.cached_mesh) {
+        App::instance().set_status("Loaded: " + file_path + " (cached mesh)");
+        prepare_model_viewer(extractor);
+        model_viewer_->load_cached_model(job.mesh_key, file_path);
+        if (job.trace_capture) model_viewer_->finish_trace_capture_when_loaded();
+        show_model_viewer_ = true;
+        return;
+    }
+
+    const auto& data = job.data;
+    App::instance().set_status("Loaded: " + file_path + " (" + std::to_string(data.size()) + " bytes)");
+
+    if (job.line > 0) {
+        text_viewer_->load_text_data(data, file_path);
+        text_viewer_->goto_line(job.line - 1);
+        show_text_viewer_ = true;
+        return;
+    }
+
+    if (ext == ".edds" || ext == ".dds") {
+        texture_viewer_->load_texture_data(data, file_path);
+        show_texture_viewer_ = true;
+    } else if (ext == ".xob") {
+        prepare_model_viewer(extractor);
+        model_viewer_->load_model_data(data, file_path, job.mesh_key);
+        if (job.trace_capture) model_viewer_->finish_trace_capture_when_loaded();
+        show_model_viewer_ = true;
+    } else if (ext == ".et" || ext == ".ent" || ext == ".layer") {
+        // Base prefabs and meshes are read from scene workers, same rules as textures
+        bool install_view = file_browser_->is_install_view();
+        scene_viewer_->load_scene_data(data, file_path, [this, extractor, install_view](const std::string& path) {
+            auto source = install_view ? file_browser_->install_extractor_for(path) : extractor;
+            if (!source) return std::vector<uint8_t>{};
+            return source->read_file(path).value_or({});
+        });
+        show_scene_viewer_ = true;
+        // The entity text stays readable alongside the scene
+        text_viewer_->load_text_data(data, file_path);
+        show_text_viewer_ = true;
+    } else if (ext == ".c" || ext == ".conf" || ext == ".layout" ||
+               ext == ".xml" || ext == ".json" || ext == ".txt" || ext == ".cfg" ||
+               ext == ".meta" || ext == ".script") {
+        text_viewer_->load_text_data(data, file_path);
+        show_text_viewer_ = true;
+    }
 }
 
-MainWindow::~MainWindow() = default;
+void MainWindow::prepare_model_viewer(const std::shared_ptr<AddonExtractor>& extractor) {
+    // Set up texture loader for the model viewer
+    // Runs on a model load worker. Textures may live in another addon
+    // when browsing the whole install; otherwise stick to the extractor
+    // captured here rather than touching the browser from that thread
+    bool install_view = file_browser_->is_install_view();
+    model_viewer_->set_texture_loader([this, extractor, install_view](const std::string& path) -> std::vector<uint8_t> {
+        auto source = install_view ? file_browser_->install_extractor_for(path) : extractor;
+        if (!source) return {};
+        return source->read_file(path).value_or({});
+    });
+    // Candidates are checked against the path index before any read
+    if (install_view) {
+        model_viewer_->set_texture_lookup("install", [](const std::string& path) {
+            return !PakIndex::instance().find_pak_for_file(path).empty();
+        });
+    } else {
+        model_viewer_->set_texture_lookup(extractor->addon_dir().string(), [extractor](const std::string& path) {
+            return extractor->contains(path);
+        });
+    }
+    // Provide list of available textures for texture browser
+    model_viewer_->set_available_textures(file_browser_->get_texture_paths());
+}
 
 void MainWindow::render() {
     render_title_bar();
@@ -119,6 +257,14 @@ void MainWindow::render_title_bar() {
         if (ImGui::BeginMenu("File")) {
             if (ImGui::MenuItem("Open Addon...", "Ctrl+O")) open_addon_dialog();
             if (ImGui::MenuItem("Open Addons Folder...", "Ctrl+Shift+O")) open_addons_folder_dialog();
+            const auto& addons_path = App::instance().settings().arma_addons_path;
+            const auto& mods_path = App::instance().settings().arma_mods_path;
+            if (ImGui::MenuItem("Browse Whole Install", nullptr, false, !addons_path.empty() || !mods_path.empty())) {
+                current_addon_path_.clear();
+                file_browser_->load_install(addons_path, mods_path);
+                show_file_browser_ = true;
+                App::instance().set_status("Indexing install: " + (addons_path.empty() ? mods_path : addons_path).string());
+            }
             ImGui::Separator();
             if (ImGui::MenuItem("Export Selected...", "Ctrl+E", false, !selected_file_path_.empty())) show_export_dialog_ = true;
             if (ImGui::MenuItem("Export All...", "Ctrl+Shift+E", false, !current_addon_path_.empty())) {
@@ -134,7 +280,10 @@ void MainWindow::render_title_bar() {
             ImGui::MenuItem("File Browser", nullptr, &show_file_browser_);
             ImGui::MenuItem("Texture Viewer", nullptr, &show_texture_viewer_);
             ImGui::MenuItem("Model Viewer", nullptr, &show_model_viewer_);
+            ImGui::MenuItem("Scene Viewer", nullptr, &show_scene_viewer_);
             ImGui::MenuItem("Text Viewer", nullptr, &show_text_viewer_);
+            ImGui::MenuItem("Search in Files", nullptr, &show_content_search_);
+            ImGui::MenuItem("Performance", nullptr, &show_performance_);
             ImGui::Separator();
             if (ImGui::MenuItem("Reset Layout")) reset_layout_ = true;
             ImGui::EndMenu();
@@ -142,8 +291,10 @@ void MainWindow::render_title_bar() {
         if (ImGui::BeginMenu("Tools")) {
             if (ImGui::MenuItem("Batch Extract...")) {}
             if (ImGui::MenuItem("Convert Textures...")) {}
+            if (ImGui::MenuItem("Search in Files...", "Ctrl+Shift+F")) show_content_search_ = true;
             ImGui::Separator();
             if (ImGui::MenuItem("Settings...", "Ctrl+,")) show_settings_ = true;
+            if (ImGui::MenuItem("Performance...")) show_performance_ = true;
             ImGui::EndMenu();
         }
         if (ImGui::BeginMenu("Help")) {
@@ -283,7 +434,9 @@ void MainWindow::setup_default_layout() {
     ImGui::DockBuilderDockWindow("File Browser", dock_left_bottom);
     ImGui::DockBuilderDockWindow("Texture Viewer", dock_right);
     ImGui::DockBuilderDockWindow("Model Viewer", dock_right);
+    ImGui::DockBuilderDockWindow("Scene Viewer", dock_right);
     ImGui::DockBuilderDockWindow("Text Viewer", dock_right);
+    ImGui::DockBuilderDockWindow("Performance", dock_right);
 
     ImGui::DockBuilderFinish(dockspace_id_);
 }
@@ -317,12 +470,35 @@ void MainWindow::render_panels() {
         ImGui::End();
     }
 
+    if (show_scene_viewer_) {
+        if (ImGui::Begin("Scene Viewer", &show_scene_viewer_)) {
+            scene_viewer_->render();
+        }
+        ImGui::End();
+    }
+
     if (show_text_viewer_) {
         if (ImGui::Begin("Text Viewer", &show_text_viewer_)) {
             text_viewer_->render();
         }
         ImGui::End();
     }
+
+    if (show_content_search_) {
+        if (ImGui::Begin("Search in Files", &show_content_search_)) {
+            content_search_->set_current_addon(current_addon_path_);
+            content_search_->set_addons_root(App::instance().settings().arma_addons_path);
+            content_search_->render();
+        }
+        ImGui::End();
+    }
+
+    if (show_performance_) {
+        if (ImGui::Begin("Performance", &show_performance_)) {
+            performance_panel_->render();
+        }
+        ImGui::End();
+    }
 }
 
 void MainWindow::render_dialogs() {
@@ -3,10 +3,13 @@
  */
 
 #include "gui/model_viewer.hpp"
+#include "gui/app.hpp"
+#include "gui/widgets.hpp"
 #include "enfusion/xob_parser.hpp"
-#include "enfusion/edds_converter.hpp"
-#include "enfusion/dds_loader.hpp"
 #include "enfusion/files.hpp"
+#include "enfusion/arena.hpp"
+#include "enfusion/logging.hpp"
+#include "enfusion/trace.hpp"
 #include "renderer/mesh_renderer.hpp"
 #include "renderer/camera.hpp"
 
@@ -14,7 +17,6 @@
 #include <glad/glad.h>
 #include <cfloat>
 #include <algorithm>
-#include <iostream>
 
 namespace enfusion {
 
@@ -26,10 +28,16 @@ ModelViewer::ModelViewer()
     camera_->set_angles(45.0f, 30.0f);
 
     renderer_->init();
+
+    mesh_enforcer_ = memory::Registry::instance().add_enforcer(memory::Subsystem::Meshes,
+        [this](size_t, size_t) { release_cpu_geometry(); });
 }
 
 ModelViewer::~ModelViewer() {
+    memory::Registry::instance().remove_enforcer(mesh_enforcer_);
+    cancel_load_job();
     destroy_textures();
+    texture_uploader_.cleanup();
     if (fbo_ != 0) {
         glDeleteFramebuffers(1, &fbo_);
         glDeleteTextures(1, &fb_texture_);
@@ -38,22 +46,38 @@ ModelViewer::~ModelViewer() {
 }
 
 void ModelViewer::destroy_textures() {
+    texture_uploader_.discard();
+    material_uploads_.clear();
+    picked_upload_ = 0;
     if (diffuse_texture_ != 0) {
         glDeleteTextures(1, &diffuse_texture_);
         diffuse_texture_ = 0;
     }
+    for (uint32_t& texture : material_textures_) {
+        if (texture != 0) glDeleteTextures(1, &texture);
+    }
+    material_textures_.clear();
     renderer_->set_texture(0);
+    renderer_->set_material_textures({});
 }
 
 void ModelViewer::clear() {
+    // Whatever a pending capture recorded so far is still worth keeping
+    if (trace_capture_) finish_trace_capture();
+
+    cancel_load_job();
+    texture_resolver_.cancel();
+
     // Clear mesh data
     current_mesh_.reset();
+    mesh_account_.set(0);
     renderer_->set_mesh(nullptr);
     destroy_textures();
     
     // Reset state
     model_loaded_ = false;
     loading_ = false;
+    loading_textures_ = false;
     error_message_.clear();
     model_name_.clear();
     vertex_count_ = 0;
@@ -70,97 +94,279 @@ void ModelViewer::clear() {
     camera_->set_target(glm::vec3(0.0f));
 }
 
-void ModelViewer::load_model_data(const std::vector<uint8_t>& data, const std::string& name) {
-    // ALWAYS clear previous model first
+void ModelViewer::load_model_data(const std::vector<uint8_t>& data, const std::string& name,
+                                  std::string cache_key) {
+    // ALWAYS clear previous model first (also cancels a load in flight)
     clear();
     
     model_name_ = name;
-    loading_ = true;
     error_message_.clear();
 
-    try {
-        if (data.empty()) {
-            error_message_ = "Empty data";
-            loading_ = false;
+    if (data.empty()) {
+        error_message_ = "Empty data";
+        return;
+    }
+
+    auto job = std::make_shared<LoadJob>();
+    job->name = name;
+    job->data = data;
+    job->cache_key = std::move(cache_key);
+    start_load_job(std::move(job));
+}
+
+void ModelViewer::load_cached_model(const std::string& cache_key, const std::string& name) {
+    clear();
+
+    model_name_ = name;
+    error_message_.clear();
+
+    auto job = std::make_shared<LoadJob>();
+    job->name = name;
+    job->cache_key = cache_key;
+    start_load_job(std::move(job));
+}
+
+void ModelViewer::start_load_job(std::shared_ptr<LoadJob> job) {
+    loading_ = true;
+
+    // Parse on a worker, then upload on the UI thread; cancelling the job skips whatever hasn't run
+    auto& scheduler = TaskScheduler::instance();
+    TaskOptions options;
+    options.priority = TaskPriority::Interactive;
+    options.token = job->cancel;
+    options.name = "model.load";
+    TaskHandle parse = scheduler.submit([job]() { parse_model(*job); }, std::move(options));
+    scheduler.run_on_main([this, job]() { finish_load_job(*job); }, {parse}, job->cancel);
+    job_ = std::move(job);
+}
+
+void ModelViewer::parse_model(LoadJob& job) {
+    if (job.cancel.cancelled()) return;
+
+    TRACE_SPAN(span, "model.parse");
+    TRACE_ARG(span, "path", job.name);
+    TRACE_ARG(span, "bytes", job.data.size());
+
+    // A mesh seen before is mapped from the cache; the upload reads straight from the mapping
+    auto& cache = MeshCache::instance();
+    if (job.cache_key.empty()) {
+        job.cache_key = MeshCache::key_for(job.data);
+    }
+    if (auto cached = cache.open(job.cache_key)) {
+        if (!cached->vertices.empty() && !cached->mesh.lods.empty() && cached->mesh.lods[0].index_count > 0) {
+            TRACE_ARG(span, "cached", 1);
+            cached->file.will_need();
+            job.bounds_min = cached->mesh.bounds_min;
+            job.bounds_max = cached->mesh.bounds_max;
+            job.cached = std::move(cached);
+            std::vector<uint8_t>().swap(job.data);
             return;
         }
+    }
+    if (job.data.empty()) {
+        job.error = "Cached mesh is no longer available, open the model again";
+        return;
+    }
 
-        XobParser parser(std::span<const uint8_t>(data.data(), data.size()));
+    try {
+        // Parser temporaries share one arena reset for this model
+        ArenaScope scope;
+        XobParser parser(std::span<const uint8_t>(job.data.data(), job.data.size()));
         auto mesh = parser.parse(0);
 
         if (!mesh) {
-            error_message_ = "Failed to parse XOB file";
-            loading_ = false;
+            job.error = "Failed to parse XOB file";
             return;
         }
 
         // Validate mesh data
         if (mesh->vertices.empty()) {
-            error_message_ = "XOB file has no vertices";
-            loading_ = false;
+            job.error = "XOB file has no vertices";
             return;
         }
 
         if (mesh->lods.empty() || mesh->lods[0].indices.empty()) {
-            error_message_ = "XOB file has no indices";
-            loading_ = false;
+            job.error = "XOB file has no indices";
             return;
         }
 
-        current_mesh_ = std::make_unique<XobMesh>(std::move(*mesh));
-        renderer_->set_mesh(current_mesh_.get());
+        glm::vec3 bounds_min(FLT_MAX);
+        glm::vec3 bounds_max(-FLT_MAX);
+        for (const auto& v : mesh->vertices) {
+            bounds_min = glm::min(bounds_min, v.position);
+            bounds_max = glm::max(bounds_max, v.position);
+        }
 
-        vertex_count_ = current_mesh_->vertices.size();
-        face_count_ = current_mesh_->lods[0].indices.size() / 3;
-        lod_count_ = static_cast<int>(current_mesh_->lods.size());
-        if (lod_count_ == 0) lod_count_ = 1;
+        mesh->bounds_min = bounds_min;
+        mesh->bounds_max = bounds_max;
+        cache.store(job.cache_key, *mesh);
 
-        calculate_bounds();
-        
-        // Load material textures
-        load_material_textures();
+        job.mesh = std::make_unique<XobMesh>(std::move(*mesh));
+        job.bounds_min = bounds_min;
+        job.bounds_max = bounds_max;
+    } catch (const std::exception& e) {
+        job.error = std::string("Error: ") + e.what();
+    }
 
-        // Center camera on model
-        glm::vec3 center = (bounds_min_ + bounds_max_) * 0.5f;
-        camera_->set_target(center);
+    // Source bytes are no longer needed
+    std::vector<uint8_t>().swap(job.data);
+}
 
-        float model_size = glm::length(bounds_max_ - bounds_min_);
-        if (model_size < 0.001f) model_size = 1.0f;
-        camera_->set_distance(model_size * 1.5f);
+void ModelViewer::finish_load_job(LoadJob& job) {
+    job_.reset();
 
-        model_loaded_ = true;
+    if (!job.mesh && !job.cached) {
+        error_message_ = job.error.empty() ? "Failed to load model" : job.error;
         loading_ = false;
+        return;
+    }
 
-    } catch (const std::exception& e) {
-        error_message_ = std::string("Error: ") + e.what();
-        loading_ = false;
+    install_mesh(job);
+
+    if (!texture_loader_) {
+        LOG_WARN("ModelViewer", "No texture loader set");
+        return;
     }
+
+    // Every material is resolved at once; textures stream in over the next frames
+    std::vector<std::string> materials;
+    for (const auto& material : current_mesh_->materials) {
+        materials.push_back(material.diffuse_texture);
+    }
+    material_textures_.assign(materials.size(), 0);
+    texture_resolver_.resolve(texture_scope_, std::move(materials), texture_exists_, texture_loader_);
 }
 
-void ModelViewer::load_model(const std::filesystem::path& path) {
-    current_path_ = path;
-    auto data = read_file(path);
-    load_model_data(data, path.filename().string());
+void ModelViewer::poll_textures() {
+    for (auto& resolved : texture_resolver_.take_resolved()) {
+        if (resolved.material >= material_textures_.size()) continue;
+
+        LOG_DEBUG("ModelViewer", "Texture resolved: " << resolved.path << " ("
+                  << resolved.texture.width << "x" << resolved.texture.height << ")");
+        auto ticket = texture_uploader_.enqueue(std::move(resolved.texture));
+        material_uploads_[ticket] = resolved.material;
+    }
+
+    texture_uploader_.pump();
+
+    bool arrived = false;
+    for (const auto& finished : texture_uploader_.take_finished()) {
+        if (finished.ticket == picked_upload_) {
+            picked_upload_ = 0;
+            if (finished.failed) continue;  // Keep whatever was showing
+            if (diffuse_texture_ != 0) glDeleteTextures(1, &diffuse_texture_);
+            diffuse_texture_ = finished.texture;
+            renderer_->set_texture(diffuse_texture_);
+            continue;
+        }
+
+        auto it = material_uploads_.find(finished.ticket);
+        if (it == material_uploads_.end() || it->second >= material_textures_.size()) {
+            uint32_t stale = finished.texture;
+            glDeleteTextures(1, &stale);
+            continue;
+        }
+
+        if (finished.failed) {
+            material_uploads_.erase(it);
+            continue;
+        }
+
+        uint32_t& slot = material_textures_[it->second];
+        if (slot != 0) glDeleteTextures(1, &slot);
+        slot = finished.texture;
+        material_uploads_.erase(it);
+        arrived = true;
+    }
+
+    // Each material range draws with its own texture; a hand-picked one overrides them all
+    if (arrived) {
+        renderer_->set_material_textures(material_textures_);
+    }
+
+    loading_textures_ = texture_resolver_.is_busy() || texture_uploader_.is_busy();
+    if (loading_textures_) App::instance().request_redraw(0.05);
+
+    if (trace_capture_ && !loading_ && !loading_textures_) {
+        finish_trace_capture();
+    }
 }
 
-void ModelViewer::calculate_bounds() {
-    if (!current_mesh_ || current_mesh_->vertices.empty()) {
-        bounds_min_ = glm::vec3(0.0f);
-        bounds_max_ = glm::vec3(0.0f);
-        return;
+void ModelViewer::release_cpu_geometry() {
+    if (!current_mesh_ || mesh_account_.bytes() == 0) return;
+
+    // Drawing only needs the GPU buffers plus LOD offsets and material ranges,
+    // and the counts shown in the info bar were taken at install time
+    current_mesh_->vertices = {};
+    current_mesh_->indices = {};
+    for (auto& lod : current_mesh_->lods) lod.indices = {};
+    mesh_account_.set(0);
+}
+
+void ModelViewer::finish_trace_capture() {
+    trace_capture_ = false;
+    auto path = trace::capture_path();
+    if (trace::end_capture()) {
+        App::instance().set_status("Trace written to " + path.string());
+    } else {
+        App::instance().set_status("Error: Could not write trace to " + path.string());
     }
+}
 
-    bounds_min_ = glm::vec3(FLT_MAX);
-    bounds_max_ = glm::vec3(-FLT_MAX);
+void ModelViewer::cancel_load_job() {
+    if (!job_) return;
 
-    for (const auto& v : current_mesh_->vertices) {
-        bounds_min_.x = (std::min)(bounds_min_.x, v.position.x);
-        bounds_min_.y = (std::min)(bounds_min_.y, v.position.y);
-        bounds_min_.z = (std::min)(bounds_min_.z, v.position.z);
-        bounds_max_.x = (std::max)(bounds_max_.x, v.position.x);
-        bounds_max_.y = (std::max)(bounds_max_.y, v.position.y);
-        bounds_max_.z = (std::max)(bounds_max_.z, v.position.z);
+    job_->cancel.cancel();
+    job_.reset();
+    loading_ = false;
+    loading_textures_ = false;
+}
+
+void ModelViewer::install_mesh(LoadJob& job) {
+    // GL upload of the vertex/index buffers happens here, on the UI thread
+    TRACE_SCOPE("model.install_mesh");
+    if (job.cached) {
+        // Only the GPU gets a copy of cached geometry; the mapping goes once it's uploaded
+        current_mesh_ = std::make_unique<XobMesh>(std::move(job.cached->mesh));
+        renderer_->set_mesh(current_mesh_.get(), job.cached->vertices, job.cached->indices);
+        vertex_count_ = job.cached->vertices.size();
+        job.cached.reset();
+    } else {
+        current_mesh_ = std::move(job.mesh);
+        renderer_->set_mesh(current_mesh_.get());
+        vertex_count_ = current_mesh_->vertices.size();
+    }
+    face_count_ = current_mesh_->lods.empty() ? current_mesh_->indices.size() / 3
+                                              : current_mesh_->lods[0].index_count / 3;
+    lod_count_ = static_cast<int>(current_mesh_->lods.size());
+    if (lod_count_ == 0) lod_count_ = 1;
+
+    bounds_min_ = job.bounds_min;
+    bounds_max_ = job.bounds_max;
+
+    size_t bytes = memory::heap_bytes(current_mesh_->vertices) + memory::heap_bytes(current_mesh_->indices);
+    for (const auto& lod : current_mesh_->lods) bytes += memory::heap_bytes(lod.indices);
+    mesh_account_.set(bytes);
+    if (memory::Registry::instance().over_budget(memory::Subsystem::Meshes)) {
+        release_cpu_geometry();
     }
+
+    // Center camera on model
+    glm::vec3 center = (bounds_min_ + bounds_max_) * 0.5f;
+    camera_->set_target(center);
+
+    float model_size = glm::length(bounds_max_ - bounds_min_);
+    if (model_size < 0.001f) model_size = 1.0f;
+    camera_->set_distance(model_size * 1.5f);
+
+    model_loaded_ = true;
+    loading_ = false;
+}
+
+void ModelViewer::load_model(const std::filesystem::path& path) {
+    current_path_ = path;
+    auto data = read_file(path);
+    load_model_data(data, path.filename().string());
 }
 
 void ModelViewer::reset_camera() {
@@ -223,8 +429,14 @@ void ModelViewer::render() {
     int view_width = static_cast<int>(content_region.x);
     int view_height = static_cast<int>(content_region.y - 30);
 
+    poll_textures();
+
     if (loading_) {
-        ImGui::Text("Loading model...");
+        // Placeholder until the mesh is parsed and uploaded
+        ImGui::Spacing();
+        widgets::Spinner("##ModelLoading", 10.0f, 3.0f, IM_COL32(100, 180, 255, 255));
+        ImGui::SameLine();
+        ImGui::Text("Loading %s...", model_name_.c_str());
         return;
     }
 
@@ -315,101 +527,10 @@ void ModelViewer::render_toolbar() {
 
 void ModelViewer::render_info_bar() {
     if (model_loaded_) {
-        ImGui::Text("Vertices: %zu | Faces: %zu | LODs: %d | File: %s",
+        ImGui::Text("Vertices: %zu | Faces: %zu | LODs: %d | File: %s%s",
                     vertex_count_, face_count_, lod_count_,
-                    model_name_.c_str());
-    }
-}
-
-void ModelViewer::load_material_textures() {
-    if (!current_mesh_ || current_mesh_->materials.empty()) {
-        std::cerr << "[ModelViewer] No materials to load\n";
-        return;
-    }
-    
-    if (!texture_loader_) {
-        std::cerr << "[ModelViewer] No texture loader set\n";
-        return;
-    }
-    
-    // Try to load diffuse texture from first material
-    const auto& mat = current_mesh_->materials[0];
-    std::cerr << "[ModelViewer] Loading texture for material: " << mat.name << "\n";
-    
-    // The material path is usually an .emat file, we need to find the corresponding .edds
-    // Try various patterns
-    std::string tex_path = mat.diffuse_texture;
-    
-    // Convert .emat/.gamemat to potential .edds paths
-    std::vector<std::string> paths_to_try;
-    
-    // Remove material extension and try common texture suffixes
-    std::string base_path = tex_path;
-    size_t ext_pos = base_path.rfind('.');
-    if (ext_pos != std::string::npos) {
-        base_path = base_path.substr(0, ext_pos);
+                    model_name_.c_str(), loading_textures_ ? " | Loading textures..." : "");
     }
-    
-    // Try different texture naming conventions
-    paths_to_try.push_back(base_path + "_co.edds");  // color/diffuse
-    paths_to_try.push_back(base_path + "_diff.edds");
-    paths_to_try.push_back(base_path + "_d.edds");
-    paths_to_try.push_back(base_path + ".edds");
-    
-    // Also try in Textures folder with same name
-    size_t last_slash = base_path.rfind('/');
-    if (last_slash != std::string::npos) {
-        std::string filename = base_path.substr(last_slash + 1);
-        paths_to_try.push_back("Assets/Textures/" + filename + "_co.edds");
-        paths_to_try.push_back("Assets/Textures/" + filename + ".edds");
-    }
-    
-    for (const auto& path : paths_to_try) {
-        std::cerr << "[ModelViewer] Trying texture: " << path << "\n";
-        auto data = texture_loader_(path);
-        if (!data.empty()) {
-            std::cerr << "[ModelViewer] Found texture: " << path << " (" << data.size() << " bytes)\n";
-            
-            // Convert EDDS to DDS
-            EddsConverter converter(std::span<const uint8_t>(data.data(), data.size()));
-            auto dds_data = converter.convert();
-            if (dds_data.empty()) {
-                std::cerr << "[ModelViewer] EDDS conversion failed\n";
-                continue;
-            }
-            
-            // Load DDS
-            auto texture = DdsLoader::load(std::span<const uint8_t>(dds_data.data(), dds_data.size()));
-            if (!texture) {
-                std::cerr << "[ModelViewer] DDS loading failed\n";
-                continue;
-            }
-            
-            if (texture->pixels.empty()) {
-                std::cerr << "[ModelViewer] DDS decode failed - no pixels\n";
-                continue;
-            }
-            
-            // Create GL texture
-            glGenTextures(1, &diffuse_texture_);
-            glBindTexture(GL_TEXTURE_2D, diffuse_texture_);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture->width, texture->height, 
-                         0, GL_RGBA, GL_UNSIGNED_BYTE, texture->pixels.data());
-            glGenerateMipmap(GL_TEXTURE_2D);
-            glBindTexture(GL_TEXTURE_2D, 0);
-            
-            renderer_->set_texture(diffuse_texture_);
-            std::cerr << "[ModelViewer] Texture loaded successfully: " << texture->width 
-                      << "x" << texture->height << "\n";
-            return;
-        }
-    }
-    
-    std::cerr << "[ModelViewer] Could not find any texture\n";
 }
 
 void ModelViewer::filter_textures() {
@@ -437,51 +558,27 @@ void ModelViewer::filter_textures() {
 
 void ModelViewer::apply_texture(const std::string& path) {
     if (!texture_loader_) {
-        std::cerr << "[ModelViewer] No texture loader\n";
+        LOG_WARN("ModelViewer", "No texture loader");
         return;
     }
     
-    std::cerr << "[ModelViewer] Applying texture: " << path << "\n";
-    
-    // Destroy old texture
-    destroy_textures();
+    LOG_DEBUG("ModelViewer", "Applying texture: " << path);
     
     auto data = texture_loader_(path);
     if (data.empty()) {
-        std::cerr << "[ModelViewer] Failed to load texture data\n";
+        LOG_WARN("ModelViewer", "Failed to load texture data: " << path);
         return;
     }
     
-    // Convert EDDS to DDS
-    EddsConverter converter(std::span<const uint8_t>(data.data(), data.size()));
-    auto dds_data = converter.convert();
-    if (dds_data.empty()) {
-        std::cerr << "[ModelViewer] EDDS conversion failed\n";
+    auto texture = TextureResolver::decode(data);
+    if (!texture) {
         return;
     }
     
-    // Load DDS
-    auto texture = DdsLoader::load(std::span<const uint8_t>(dds_data.data(), dds_data.size()));
-    if (!texture || texture->pixels.empty()) {
-        std::cerr << "[ModelViewer] DDS loading failed\n";
-        return;
-    }
-    
-    // Create GL texture
-    glGenTextures(1, &diffuse_texture_);
-    glBindTexture(GL_TEXTURE_2D, diffuse_texture_);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture->width, texture->height, 
-                 0, GL_RGBA, GL_UNSIGNED_BYTE, texture->pixels.data());
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    
-    renderer_->set_texture(diffuse_texture_);
+    // Replaces the previous hand-picked texture once the upload lands; material textures stay
+    LOG_DEBUG("ModelViewer", "Texture applied: " << texture->width << "x" << texture->height);
+    picked_upload_ = texture_uploader_.enqueue(std::move(*texture));
     current_texture_path_ = path;
-    std::cerr << "[ModelViewer] Texture applied: " << texture->width << "x" << texture->height << "\n";
 }
 
 void ModelViewer::render_texture_browser() {
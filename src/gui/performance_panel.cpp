@@ -0,0 +1,279 @@
+﻿/**
+ * Enfusion Unpacker - Performance Panel Implementation
+ */
+
+#include "gui/performance_panel.hpp"
+#include "gui/app.hpp"
+
+#include <imgui.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace enfusion {
+
+namespace {
+
+constexpr double NS_PER_MS = 1e6;
+
+} // namespace
+
+void PerformancePanel::render() {
+    // Numbers move while work runs; a couple of refreshes a second is plenty
+    App::instance().request_redraw(0.5);
+
+    auto& registry = metrics::Registry::instance();
+
+    if (ImGui::Button("Reset")) {
+        registry.reset();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export JSON")) {
+        if (registry.write_json(export_path_)) {
+            App::instance().set_status(std::string("Metrics written to ") + export_path_);
+        } else {
+            App::instance().set_status(std::string("Error: Could not write ") + export_path_);
+        }
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(-1);
+    ImGui::InputText("##MetricsPath", export_path_, sizeof(export_path_));
+
+    ImGui::Separator();
+
+    auto snap = registry.snapshot();
+
+    ImGui::BeginChild("PerformanceContent", ImVec2(0, 0), false);
+
+    if (ImGui::CollapsingHeader("Memory", ImGuiTreeNodeFlags_DefaultOpen)) {
+        render_memory();
+    }
+    if (ImGui::CollapsingHeader("Latency", ImGuiTreeNodeFlags_DefaultOpen)) {
+        render_latencies(snap);
+    }
+    if (ImGui::CollapsingHeader("Cache Hit Rates", ImGuiTreeNodeFlags_DefaultOpen)) {
+        render_hit_rates(snap);
+    }
+    if (ImGui::CollapsingHeader("Counters", ImGuiTreeNodeFlags_DefaultOpen)) {
+        render_counters(snap);
+    }
+    if (ImGui::CollapsingHeader("Tracing")) {
+        render_tracing();
+    }
+
+    ImGui::EndChild();
+}
+
+void PerformancePanel::render_latencies(const metrics::Snapshot& snap) {
+    if (snap.histograms.empty()) {
+        ImGui::TextDisabled("Nothing timed yet.");
+        return;
+    }
+
+    if (!ImGui::BeginTable("Latency", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable)) {
+        return;
+    }
+
+    ImGui::TableSetupColumn("Stage", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Count", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("Mean ms", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("p50 ms", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("p90 ms", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("p99 ms", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("Max ms", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableHeadersRow();
+
+    for (const auto& h : snap.histograms) {
+        if (h.count == 0) continue;
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(h.name.c_str());
+        ImGui::TableNextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(h.count));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", h.mean / NS_PER_MS);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", h.p50 / NS_PER_MS);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", h.p90 / NS_PER_MS);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", h.p99 / NS_PER_MS);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", h.max / NS_PER_MS);
+    }
+
+    ImGui::EndTable();
+}
+
+void PerformancePanel::render_hit_rates(const metrics::Snapshot& snap) {
+    if (snap.hit_rates.empty()) {
+        ImGui::TextDisabled("No cache lookups yet.");
+        return;
+    }
+
+    for (const auto& r : snap.hit_rates) {
+        uint64_t total = r.hits + r.misses;
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%.1f%% of %llu", r.rate() * 100.0,
+                 static_cast<unsigned long long>(total));
+        ImGui::ProgressBar(static_cast<float>(r.rate()), ImVec2(200.0f, 0), overlay);
+        ImGui::SameLine();
+        ImGui::TextUnformatted(r.name.c_str());
+    }
+}
+
+void PerformancePanel::render_counters(const metrics::Snapshot& snap) {
+    if (snap.counters.empty()) {
+        ImGui::TextDisabled("No counters yet.");
+        return;
+    }
+
+    if (!ImGui::BeginTable("Counters", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        return;
+    }
+
+    ImGui::TableSetupColumn("Counter", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Value", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableHeadersRow();
+
+    for (const auto& c : snap.counters) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(c.name.c_str());
+        ImGui::TableNextColumn();
+        if (c.name.find("bytes") != std::string::npos) {
+            ImGui::TextUnformatted(format_size(c.value).c_str());
+        } else {
+            ImGui::Text("%llu", static_cast<unsigned long long>(c.value));
+        }
+    }
+
+    ImGui::EndTable();
+}
+
+void PerformancePanel::render_memory() {
+    auto usage = memory::Registry::instance().snapshot();
+
+    size_t total = 0;
+    for (const auto& entry : usage) total += entry.bytes;
+    ImGui::Text("Accounted: %s", format_size(total).c_str());
+    ImGui::TextDisabled("Budgets in MB, 0 = unlimited. Over budget, addons are evicted and CPU copies dropped.");
+
+    if (!ImGui::BeginTable("Memory", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable)) {
+        return;
+    }
+
+    ImGui::TableSetupColumn("Subsystem", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Used", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("Peak", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("Budget MB", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+    ImGui::TableHeadersRow();
+
+    auto& budgets = App::instance().settings().memory_budgets_mb;
+
+    for (const auto& entry : usage) {
+        const char* key = memory::subsystem_key(entry.subsystem);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth;
+        if (entry.objects.empty()) flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+        bool open = ImGui::TreeNodeEx(memory::subsystem_name(entry.subsystem), flags);
+
+        ImGui::TableNextColumn();
+        if (entry.budget != 0 && entry.bytes > entry.budget) {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", format_size(entry.bytes).c_str());
+        } else {
+            ImGui::TextUnformatted(format_size(entry.bytes).c_str());
+        }
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(format_size(entry.peak).c_str());
+
+        ImGui::TableNextColumn();
+        auto it = budgets.find(key);
+        int mb = it != budgets.end() ? static_cast<int>(it->second) : 0;
+        ImGui::PushID(key);
+        ImGui::SetNextItemWidth(-1);
+        if (ImGui::InputInt("##Budget", &mb, 0, 0)) {
+            budgets[key] = static_cast<uint32_t>(std::max(0, mb));
+        }
+        // Applied once editing ends, so typing "4096" doesn't pass through a 4 MB budget
+        if (ImGui::IsItemDeactivatedAfterEdit()) {
+            App::instance().apply_memory_budgets();
+        }
+        ImGui::PopID();
+
+        if (open && !entry.objects.empty()) {
+            for (const auto& object : entry.objects) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Indent();
+                ImGui::TextUnformatted(object.label.c_str());
+                ImGui::Unindent();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(format_size(object.bytes).c_str());
+            }
+            ImGui::TreePop();
+        }
+    }
+
+    ImGui::EndTable();
+}
+
+void PerformancePanel::render_tracing() {
+#if ENFUSION_TRACE
+    ImGui::TextWrapped("Records spans from every thread. Open the file in chrome://tracing or ui.perfetto.dev.");
+
+    ImGui::SetNextItemWidth(-1);
+    ImGui::InputText("##TracePath", trace_path_, sizeof(trace_path_));
+
+    if (trace::enabled()) {
+        if (ImGui::Button("Stop")) trace::stop();
+    } else {
+        if (ImGui::Button("Start")) trace::start();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save")) {
+        if (trace::write_json(trace_path_)) {
+            App::instance().set_status(std::string("Trace written to ") + trace_path_);
+        } else {
+            App::instance().set_status(std::string("Error: Could not write ") + trace_path_);
+        }
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Capture Next Model Open")) {
+        trace::arm_capture(trace_path_);
+    }
+
+    if (trace::capture_armed()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "Waiting for the next model to open...");
+    } else if (trace::enabled()) {
+        ImGui::TextColored(ImVec4(0.4f, 1.0f, 0.4f, 1.0f), "Recording");
+    }
+
+    ImGui::Text("%zu spans", trace::event_count());
+    if (uint64_t dropped = trace::dropped()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%llu dropped)", static_cast<unsigned long long>(dropped));
+    }
+#else
+    ImGui::TextDisabled("Tracing was compiled out (ENFUSION_TRACE=0).");
+#endif
+}
+
+std::string PerformancePanel::format_size(uint64_t bytes) const {
+    const char* units[] = {"B", "KB", "MB", "GB"};
+    int unit = 0;
+    double size = static_cast<double>(bytes);
+
+    while (size >= 1024.0 && unit < 3) {
+        size /= 1024.0;
+        unit++;
+    }
+
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.1f %s", size, units[unit]);
+    return buffer;
+}
+
+} // namespace enfusion
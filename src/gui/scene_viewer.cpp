@@ -0,0 +1,379 @@
+﻿/**
+ * Enfusion Unpacker - Scene Viewer Implementation
+ */
+
+#include "gui/scene_viewer.hpp"
+#include "gui/widgets.hpp"
+#include "enfusion/prefab_parser.hpp"
+#include "enfusion/xob_parser.hpp"
+#include "enfusion/path_utils.hpp"
+#include "enfusion/arena.hpp"
+#include "renderer/mesh_renderer.hpp"
+#include "renderer/camera.hpp"
+
+#include <imgui.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+#include <unordered_map>
+
+namespace enfusion {
+
+SceneViewer::SceneViewer()
+    : camera_(std::make_unique<Camera>())
+    , renderer_(std::make_unique<SceneRenderer>())
+    , grid_(std::make_unique<MeshRenderer>()) {
+
+    camera_->set_distance(20.0f);
+    camera_->set_angles(45.0f, 30.0f);
+
+    renderer_->init();
+    grid_->init();
+}
+
+SceneViewer::~SceneViewer() {
+    cancel_load_job();
+    // The file loader may reference state owned elsewhere
+    for (const auto& job : retired_jobs_) job->future.wait();
+    if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+        glDeleteTextures(1, &fb_texture_);
+        glDeleteRenderbuffers(1, &fb_depth_);
+    }
+}
+
+void SceneViewer::clear() {
+    cancel_load_job();
+    renderer_->clear();
+
+    scene_loaded_ = false;
+    loading_ = false;
+    error_message_.clear();
+    scene_name_.clear();
+    mesh_count_ = 0;
+    prefab_count_ = 0;
+    missing_prefabs_ = 0;
+    missing_meshes_ = 0;
+}
+
+void SceneViewer::load_scene_data(const std::vector<uint8_t>& data, const std::string& name, FileLoader loader) {
+    clear();
+
+    scene_name_ = name;
+    if (data.empty()) {
+        error_message_ = "Empty data";
+        return;
+    }
+
+    auto job = std::make_shared<LoadJob>();
+    job->text.assign(reinterpret_cast<const char*>(data.data()), data.size());
+    job->loader = std::move(loader);
+
+    loading_ = true;
+    job->future = TaskScheduler::instance().async(TaskPriority::Interactive, [job]() { build_scene(*job); });
+    job_ = std::move(job);
+}
+
+void SceneViewer::build_scene(LoadJob& job) {
+    SceneBuilder builder(job.loader);
+    auto placed = builder.build(job.text);
+    if (!placed) {
+        job.error = placed.error().full_message();
+        return;
+    }
+    job.prefab_count = builder.prefab_count();
+    job.missing_prefabs = builder.missing().size();
+
+    // One mesh entry per distinct XOB, however often it is placed
+    std::unordered_map<std::string, uint32_t> mesh_ids;
+    std::vector<std::string> paths;
+    job.instances.reserve(placed->size());
+    for (auto& instance : *placed) {
+        auto [it, inserted] = mesh_ids.try_emplace(normalize_path(instance.mesh),
+                                                   static_cast<uint32_t>(paths.size()));
+        if (inserted) paths.push_back(instance.mesh);
+        job.instances.push_back({it->second, instance.transform});
+    }
+
+    job.meshes.resize(paths.size());
+    job.meshes_total = paths.size();
+    std::vector<uint8_t> loaded(paths.size(), 0);
+
+    // Meshes are independent, so a few workers pull them off a shared cursor
+    std::atomic<size_t> cursor{0};
+    auto worker = [&]() {
+        for (size_t i = cursor++; i < paths.size(); i = cursor++) {
+            if (job.cancel) return;
+            auto data = job.loader ? job.loader(paths[i]) : std::vector<uint8_t>{};
+            job.meshes[i].path = paths[i];
+            loaded[i] = !data.empty() && load_mesh(data, job.meshes[i]);
+            ++job.meshes_done;
+        }
+    };
+
+    auto& scheduler = TaskScheduler::instance();
+    scheduler.parallel(std::min<size_t>(scheduler.worker_count(), paths.size()), worker, TaskPriority::Interactive);
+    if (job.cancel) return;
+
+    // Drop meshes that failed to load along with their instances
+    std::vector<uint32_t> remap(paths.size(), UINT32_MAX);
+    std::vector<SceneMesh> meshes;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!loaded[i]) {
+            ++job.missing_meshes;
+            continue;
+        }
+        remap[i] = static_cast<uint32_t>(meshes.size());
+        meshes.push_back(std::move(job.meshes[i]));
+    }
+    job.meshes = std::move(meshes);
+
+    std::erase_if(job.instances, [&](MeshInstance& instance) {
+        instance.mesh = remap[instance.mesh];
+        return instance.mesh == UINT32_MAX;
+    });
+}
+
+bool SceneViewer::load_mesh(const std::vector<uint8_t>& data, SceneMesh& mesh) {
+    try {
+        ArenaScope scope;
+        XobParser parser(std::span<const uint8_t>(data.data(), data.size()));
+
+        auto append = [&](XobMesh& lod) {
+            if (lod.vertices.empty() || lod.indices.empty()) return false;
+            SceneMesh::Lod span;
+            span.first_index = static_cast<uint32_t>(mesh.indices.size());
+            span.index_count = static_cast<uint32_t>(lod.indices.size());
+            span.base_vertex = static_cast<int32_t>(mesh.vertices.size());
+            mesh.vertices.insert(mesh.vertices.end(), lod.vertices.begin(), lod.vertices.end());
+            mesh.indices.insert(mesh.indices.end(), lod.indices.begin(), lod.indices.end());
+            mesh.lods.push_back(span);
+            return true;
+        };
+
+        auto lod0 = parser.parse(0);
+        if (!lod0 || !append(*lod0)) return false;
+
+        mesh.center = (lod0->bounds_min + lod0->bounds_max) * 0.5f;
+        mesh.radius = std::max(glm::length(lod0->bounds_max - lod0->bounds_min) * 0.5f, 0.01f);
+
+        // Coarser LODs let distant instances draw far fewer triangles
+        uint32_t lods = std::min<uint32_t>(parser.lod_count(), SceneRenderer::MAX_LODS);
+        for (uint32_t l = 1; l < lods; ++l) {
+            auto lod = parser.parse(l);
+            if (!lod || !append(*lod)) break;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "[SceneViewer] Failed to load " << mesh.path << ": " << e.what() << "\n";
+        return false;
+    }
+}
+
+void SceneViewer::poll_load_job() {
+    // Drop cancelled jobs whose workers have returned
+    retired_jobs_.erase(std::remove_if(retired_jobs_.begin(), retired_jobs_.end(), [](const auto& job) {
+        return !job->future.valid() || job->future.ready();
+    }), retired_jobs_.end());
+
+    if (!job_ || !job_->future.valid()) return;
+    if (!job_->future.ready()) return;
+    job_->future.get();
+
+    auto job = std::move(job_);
+    loading_ = false;
+
+    if (!job->error.empty()) {
+        error_message_ = job->error;
+        return;
+    }
+    if (job->instances.empty()) {
+        error_message_ = "No meshes found in " + scene_name_;
+        if (job->missing_prefabs > 0 || job->missing_meshes > 0) {
+            error_message_ += " (" + std::to_string(job->missing_prefabs) + " prefabs and " +
+                              std::to_string(job->missing_meshes) + " meshes could not be loaded)";
+        }
+        return;
+    }
+
+    mesh_count_ = job->meshes.size();
+    prefab_count_ = job->prefab_count;
+    missing_prefabs_ = job->missing_prefabs;
+    missing_meshes_ = job->missing_meshes;
+
+    renderer_->set_scene(std::move(job->meshes), std::move(job->instances));
+    scene_loaded_ = true;
+    reset_camera();
+}
+
+void SceneViewer::cancel_load_job() {
+    if (!job_) return;
+
+    job_->cancel = true;
+    if (job_->future.valid()) {
+        // Dropped outright if no worker has started it
+        job_->future.cancel();
+        retired_jobs_.push_back(std::move(job_));
+    }
+    job_.reset();
+    loading_ = false;
+}
+
+void SceneViewer::reset_camera() {
+    camera_->reset();
+    camera_->set_angles(45.0f, 30.0f);
+    if (!renderer_->empty()) {
+        glm::vec3 bounds_min = renderer_->bounds_min();
+        glm::vec3 bounds_max = renderer_->bounds_max();
+        camera_->set_target((bounds_min + bounds_max) * 0.5f);
+
+        float size = glm::length(bounds_max - bounds_min);
+        if (size < 0.001f) size = 1.0f;
+        camera_->set_distance(size * 1.2f);
+        camera_->set_clip(std::max(0.05f, size * 0.0005f), std::max(1000.0f, size * 4.0f));
+    }
+}
+
+void SceneViewer::ensure_framebuffer(int width, int height) {
+    if (width <= 0 || height <= 0) return;
+    if (fbo_ != 0 && fb_width_ == width && fb_height_ == height) return;
+
+    if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+        glDeleteTextures(1, &fb_texture_);
+        glDeleteRenderbuffers(1, &fb_depth_);
+    }
+
+    fb_width_ = width;
+    fb_height_ = height;
+
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+
+    glGenTextures(1, &fb_texture_);
+    glBindTexture(GL_TEXTURE_2D, fb_texture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fb_texture_, 0);
+
+    glGenRenderbuffers(1, &fb_depth_);
+    glBindRenderbuffer(GL_RENDERBUFFER, fb_depth_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, fb_depth_);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void SceneViewer::render() {
+    render_toolbar();
+    ImGui::Separator();
+
+    auto content_region = ImGui::GetContentRegionAvail();
+    int view_width = static_cast<int>(content_region.x);
+    int view_height = static_cast<int>(content_region.y - 30);
+
+    poll_load_job();
+
+    if (loading_) {
+        ImGui::Spacing();
+        widgets::Spinner("##SceneLoading", 10.0f, 3.0f, IM_COL32(100, 180, 255, 255));
+        ImGui::SameLine();
+        size_t total = job_ ? job_->meshes_total.load() : 0;
+        if (total > 0) {
+            ImGui::Text("Loading %s... %zu / %zu meshes", scene_name_.c_str(), job_->meshes_done.load(), total);
+        } else {
+            ImGui::Text("Loading %s...", scene_name_.c_str());
+        }
+        return;
+    }
+
+    if (!error_message_.empty()) {
+        ImGui::TextColored(ImVec4(1, 0.4f, 0.4f, 1), "%s", error_message_.c_str());
+        return;
+    }
+
+    if (!scene_loaded_) {
+        ImGui::TextDisabled("No scene loaded.");
+        ImGui::TextDisabled("Select a .et, .ent or .layer file to view.");
+        return;
+    }
+
+    if (view_width > 0 && view_height > 0) {
+        ensure_framebuffer(view_width, view_height);
+
+        if (fbo_ != 0) {
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+            glViewport(0, 0, view_width, view_height);
+            glClearColor(bg_color_.r, bg_color_.g, bg_color_.b, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glEnable(GL_DEPTH_TEST);
+
+            camera_->set_aspect(static_cast<float>(view_width) / static_cast<float>(view_height));
+            glm::mat4 view = camera_->view_matrix();
+            glm::mat4 projection = camera_->projection_matrix();
+
+            if (show_grid_) {
+                grid_->set_show_grid(true);
+                grid_->render(view, projection);
+            }
+
+            renderer_->set_wireframe(show_wireframe_);
+            renderer_->set_lod_bias(lod_bias_);
+            renderer_->render(view, projection, camera_->position());
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        if (fb_texture_ != 0) {
+            ImGui::Image(static_cast<ImTextureID>(static_cast<uintptr_t>(fb_texture_)),
+                         ImVec2(static_cast<float>(view_width), static_cast<float>(view_height)),
+                         ImVec2(0, 1), ImVec2(1, 0));
+
+            if (ImGui::IsItemHovered()) {
+                auto& io = ImGui::GetIO();
+                if (io.MouseWheel != 0) {
+                    camera_->zoom(io.MouseWheel * 0.5f);
+                }
+                if (ImGui::IsMouseDragging(ImGuiMouseButton_Left)) {
+                    camera_->orbit(io.MouseDelta.x * 0.5f, io.MouseDelta.y * 0.5f);
+                }
+                if (ImGui::IsMouseDragging(ImGuiMouseButton_Right)) {
+                    camera_->pan(io.MouseDelta.x * 0.01f, io.MouseDelta.y * 0.01f);
+                }
+            }
+        }
+    }
+
+    render_info_bar();
+}
+
+void SceneViewer::render_toolbar() {
+    if (ImGui::Button("Reset View")) reset_camera();
+    ImGui::SameLine();
+    ImGui::Text("|");
+    ImGui::SameLine();
+    ImGui::Checkbox("Wireframe", &show_wireframe_);
+    ImGui::SameLine();
+    ImGui::Checkbox("Grid", &show_grid_);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::SliderFloat("LOD Bias", &lod_bias_, 0.25f, 4.0f, "%.2f");
+    ImGui::SameLine();
+    ImGui::ColorEdit3("BG", &bg_color_.x, ImGuiColorEditFlags_NoInputs);
+}
+
+void SceneViewer::render_info_bar() {
+    const auto& stats = renderer_->stats();
+    ImGui::Text("Instances: %zu (%zu visible) | Meshes: %zu | Draws: %zu | Triangles: %zu | Prefabs: %zu",
+                stats.instances, stats.visible, mesh_count_, stats.draw_calls, stats.triangles,
+                prefab_count_);
+    if (missing_prefabs_ > 0 || missing_meshes_ > 0) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.3f, 1.0f), "| Missing: %zu prefabs, %zu meshes",
+                           missing_prefabs_, missing_meshes_);
+    }
+}
+
+} // namespace enfusion
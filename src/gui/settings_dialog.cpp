@@ -6,8 +6,12 @@
 #include "gui/app.hpp"
 #include "gui/theme.hpp"
 #include "gui/widgets.hpp"
+#include "enfusion/task_scheduler.hpp"
+#include "enfusion/mesh_cache.hpp"
+#include "enfusion/mesh_thumbnails.hpp"
 
 #include <imgui.h>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -55,6 +59,11 @@ void SettingsDialog::render_content() {
             ImGui::EndTabItem();
         }
         
+        if (ImGui::BeginTabItem("Performance")) {
+            render_performance_tab(settings);
+            ImGui::EndTabItem();
+        }
+        
         ImGui::EndTabBar();
     }
     
@@ -92,6 +101,23 @@ void SettingsDialog::render_general_tab(AppSettings& settings) {
         browse_folder(settings.arma_addons_path);
     }
     
+    ImGui::Spacing();
+    
+    ImGui::Text("Mods Path:");
+    char mods_path_buffer[512] = {0};
+    std::string mods_str = settings.arma_mods_path.string();
+    strncpy(mods_path_buffer, mods_str.c_str(), sizeof(mods_path_buffer) - 1);
+    
+    ImGui::SetNextItemWidth(-80);
+    if (ImGui::InputText("##ModsPath", mods_path_buffer, sizeof(mods_path_buffer))) {
+        settings.arma_mods_path = mods_path_buffer;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Browse##Mods")) {
+        browse_folder(settings.arma_mods_path);
+    }
+    ImGui::TextDisabled("Addons here override the base game in Browse Whole Install");
+    
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Spacing();
@@ -222,6 +248,60 @@ void SettingsDialog::render_paths_tab(AppSettings& settings) {
     }
 }
 
+void SettingsDialog::render_performance_tab(AppSettings& settings) {
+    ImGui::Spacing();
+    
+    ImGui::Text("Background Work:");
+    ImGui::Spacing();
+    
+    auto& scheduler = TaskScheduler::instance();
+    int max_workers = static_cast<int>(std::min(TaskScheduler::MAX_WORKERS,
+                                                TaskScheduler::default_worker_count() * 2 + 2));
+    
+    int workers = static_cast<int>(settings.worker_threads);
+    if (ImGui::SliderInt("Worker threads", &workers, 0, max_workers, workers == 0 ? "Auto" : "%d")) {
+        settings.worker_threads = static_cast<uint32_t>(workers);
+        App::instance().apply_worker_settings();
+    }
+    widgets::HelpMarker("Threads shared by model loading, texture decoding, indexing, search and export. "
+                        "Auto leaves one core for the interface.");
+    
+    int background = static_cast<int>(settings.background_workers);
+    if (ImGui::SliderInt("Background workers", &background, 0, static_cast<int>(scheduler.worker_count()),
+                         background == 0 ? "Auto" : "%d")) {
+        settings.background_workers = static_cast<uint32_t>(background);
+        App::instance().apply_worker_settings();
+    }
+    widgets::HelpMarker("How many workers indexing, export, search and prefetching may occupy at once. "
+                        "Auto keeps one free so opening a file never waits behind them.");
+    
+    ImGui::Spacing();
+    ImGui::TextDisabled("Running with %u workers, %u for background work",
+                        scheduler.worker_count(), scheduler.background_limit());
+    
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+    
+    ImGui::Text("Caches:");
+    ImGui::Spacing();
+    
+    if (ImGui::Button("Clear mesh cache")) {
+        MeshCache::instance().clear();
+        App::instance().set_status("Mesh cache cleared");
+    }
+    widgets::HelpMarker("Parsed models are kept on disk so they open without being parsed again. "
+                        "Clearing forces every model to be parsed on its next open.");
+    ImGui::TextDisabled("%s", MeshCache::instance().directory().string().c_str());
+    
+    if (ImGui::Button("Clear thumbnail cache")) {
+        ThumbnailCache::instance().clear();
+        App::instance().set_status("Thumbnail cache cleared");
+    }
+    widgets::HelpMarker("Mesh thumbnails shown in the file browser's grid view.");
+    ImGui::TextDisabled("%s", ThumbnailCache::instance().directory().string().c_str());
+}
+
 void SettingsDialog::apply_settings() {
     auto& settings = App::instance().settings();
     apply_theme(static_cast<Theme>(settings.theme));
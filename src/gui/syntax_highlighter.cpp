@@ -0,0 +1,205 @@
+/**
+ * Enfusion Unpacker - Syntax Highlighter Implementation
+ */
+
+#include "gui/syntax_highlighter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <unordered_set>
+
+namespace enfusion {
+
+namespace {
+
+const std::unordered_set<std::string_view>& script_keywords() {
+    static const std::unordered_set<std::string_view> keywords = {
+        "class", "extends", "modded", "sealed", "override", "static", "const",
+        "private", "protected", "proto", "native", "external", "owned", "ref",
+        "out", "inout", "notnull", "autoptr", "return", "if", "else", "for",
+        "foreach", "while", "switch", "case", "default", "break", "continue",
+        "new", "delete", "this", "super", "null", "true", "false", "typedef",
+        "enum", "volatile", "thread", "event", "local", "reference"
+    };
+    return keywords;
+}
+
+const std::unordered_set<std::string_view>& script_types() {
+    static const std::unordered_set<std::string_view> types = {
+        "void", "int", "float", "bool", "string", "vector", "array", "map",
+        "set", "typename", "auto", "Class", "Managed", "func"
+    };
+    return types;
+}
+
+bool is_ident_start(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool is_ident_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+void emit(std::vector<Token>* out, size_t start, size_t end, TokenKind kind) {
+    if (!out || end <= start) return;
+
+    // Merge runs of the same kind so plain text doesn't fragment into many spans
+    if (!out->empty() && out->back().kind == kind &&
+        out->back().start + out->back().length == start) {
+        out->back().length += static_cast<uint32_t>(end - start);
+        return;
+    }
+    out->push_back({static_cast<uint32_t>(start), static_cast<uint32_t>(end - start), kind});
+}
+
+} // namespace
+
+SyntaxHighlighter::Language SyntaxHighlighter::language_for(const std::string& filename) {
+    auto ext = std::filesystem::path(filename).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    if (ext == ".c") return Language::EnforceScript;
+    if (ext == ".et" || ext == ".conf" || ext == ".layout" || ext == ".meta") return Language::Config;
+    return Language::None;
+}
+
+void SyntaxHighlighter::reset(Language language, size_t line_count, LineSource source) {
+    language_ = language;
+    source_ = std::move(source);
+    lines_.clear();
+    lines_.resize(language_ == Language::None ? 0 : line_count);
+    states_known_ = lines_.empty() ? 0 : 1;  // First line always starts in Normal
+}
+
+const std::vector<Token>& SyntaxHighlighter::tokens(size_t line) {
+    static const std::vector<Token> empty;
+    if (line >= lines_.size()) return empty;
+
+    ensure_entry_state(line);
+
+    CachedLine& cached = lines_[line];
+    if (!cached.tokens_valid) {
+        cached.tokens.clear();
+        lex_line(source_(line), cached.entry, &cached.tokens);
+        cached.tokens_valid = true;
+    }
+    return cached.tokens;
+}
+
+void SyntaxHighlighter::invalidate_from(size_t line) {
+    if (line >= lines_.size()) return;
+
+    lines_[line].tokens_valid = false;
+    states_known_ = std::min(states_known_, line + 1);
+}
+
+void SyntaxHighlighter::ensure_entry_state(size_t line) {
+    // Carry the exit state of each earlier line forward; this only scans for
+    // comment delimiters and stores one byte per line
+    while (states_known_ <= line) {
+        size_t prev = states_known_ - 1;
+        LexState entry = lex_line(source_(prev), lines_[prev].entry, nullptr);
+
+        CachedLine& next = lines_[states_known_];
+        if (next.entry != entry) {
+            next.entry = entry;
+            next.tokens_valid = false;
+        }
+        states_known_++;
+    }
+}
+
+SyntaxHighlighter::LexState SyntaxHighlighter::lex_line(std::string_view text, LexState state,
+                                                        std::vector<Token>* out) const {
+    size_t i = 0;
+    size_t n = text.size();
+    bool first_word = true;
+
+    while (i < n) {
+        if (state == LexState::BlockComment) {
+            size_t close = text.find("*/", i);
+            size_t end = close == std::string_view::npos ? n : close + 2;
+            emit(out, i, end, TokenKind::Comment);
+            i = end;
+            if (close != std::string_view::npos) state = LexState::Normal;
+            continue;
+        }
+
+        char c = text[i];
+
+        if (c == '/' && i + 1 < n && text[i + 1] == '/') {
+            emit(out, i, n, TokenKind::Comment);
+            break;
+        }
+        if (c == '/' && i + 1 < n && text[i + 1] == '*') {
+            emit(out, i, i + 2, TokenKind::Comment);
+            i += 2;
+            state = LexState::BlockComment;
+            continue;
+        }
+
+        if (c == '#' && language_ == Language::EnforceScript && first_word) {
+            emit(out, i, n, TokenKind::Preprocessor);
+            break;
+        }
+
+        // Without an output only block comments matter, which strings can hide
+        if (c == '"' || c == '\'') {
+            size_t end = i + 1;
+            while (end < n && text[end] != c) {
+                end += (text[end] == '\\' && end + 1 < n) ? 2 : 1;
+            }
+            end = std::min(end + 1, n);
+            emit(out, i, end, TokenKind::String);
+            i = end;
+            first_word = false;
+            continue;
+        }
+
+        if (!out) {
+            if (!std::isspace(static_cast<unsigned char>(c))) first_word = false;
+            ++i;
+            continue;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(c)) ||
+            ((c == '-' || c == '.') && i + 1 < n && std::isdigit(static_cast<unsigned char>(text[i + 1])))) {
+            size_t end = i + 1;
+            while (end < n && (is_ident_char(text[end]) || text[end] == '.')) ++end;
+            emit(out, i, end, TokenKind::Number);
+            i = end;
+            first_word = false;
+            continue;
+        }
+
+        if (is_ident_start(c)) {
+            size_t end = i + 1;
+            while (end < n && is_ident_char(text[end])) ++end;
+            std::string_view word = text.substr(i, end - i);
+
+            TokenKind kind = TokenKind::Text;
+            if (language_ == Language::EnforceScript) {
+                if (script_keywords().count(word)) kind = TokenKind::Keyword;
+                else if (script_types().count(word)) kind = TokenKind::Type;
+            } else if (word == "true" || word == "false") {
+                kind = TokenKind::Keyword;
+            } else if (first_word) {
+                // Config lines lead with a class or property name
+                kind = TokenKind::Type;
+            }
+
+            emit(out, i, end, kind);
+            i = end;
+            first_word = false;
+            continue;
+        }
+
+        if (!std::isspace(static_cast<unsigned char>(c))) first_word = false;
+        emit(out, i, i + 1, TokenKind::Text);
+        ++i;
+    }
+
+    return state;
+}
+
+} // namespace enfusion
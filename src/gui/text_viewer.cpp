@@ -3,11 +3,58 @@
  */
 
 #include "gui/text_viewer.hpp"
+#include "gui/widgets.hpp"
 #include <imgui.h>
 #include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <functional>
 
 namespace enfusion {
 
+namespace {
+
+enum ByteClass : uint8_t { Drop = 0, Keep = 1, CarriageReturn = 2 };
+
+// Newline, tab and printable ASCII are kept; '\r' needs a look at the next byte
+constexpr std::array<uint8_t, 256> make_byte_classes() {
+    std::array<uint8_t, 256> table{};
+    for (int c = 32; c < 127; ++c) table[c] = Keep;
+    table['\n'] = Keep;
+    table['\t'] = Keep;
+    table['\r'] = CarriageReturn;
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> BYTE_CLASSES = make_byte_classes();
+
+ImVec4 token_color(TokenKind kind) {
+    switch (kind) {
+        case TokenKind::Keyword:      return ImVec4(0.8f, 0.55f, 0.9f, 1.0f);
+        case TokenKind::Type:         return ImVec4(0.45f, 0.75f, 1.0f, 1.0f);
+        case TokenKind::Comment:      return ImVec4(0.4f, 0.6f, 0.4f, 1.0f);
+        case TokenKind::String:       return ImVec4(0.9f, 0.7f, 0.5f, 1.0f);
+        case TokenKind::Number:       return ImVec4(0.7f, 0.9f, 0.6f, 1.0f);
+        case TokenKind::Preprocessor: return ImVec4(0.75f, 0.75f, 0.5f, 1.0f);
+        default:                      return ImGui::GetStyleColorVec4(ImGuiCol_Text);
+    }
+}
+
+struct CaseInsensitiveHash {
+    size_t operator()(char c) const {
+        return std::hash<int>()(std::tolower(static_cast<unsigned char>(c)));
+    }
+};
+
+struct CaseInsensitiveEqual {
+    bool operator()(char a, char b) const {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    }
+};
+
+} // namespace
+
 TextViewer::TextViewer() {
 }
 
@@ -17,29 +64,96 @@ void TextViewer::load_text_data(const std::vector<uint8_t>& data, const std::str
     
     filename_ = filename;
     
-    // Convert binary data to string, handling different line endings
-    text_.clear();
-    text_.reserve(data.size());
+    // Output never exceeds the input, so write straight into a presized buffer
+    text_.resize(data.size());
+    char* out = text_.data();
+    const uint8_t* src = data.data();
+    const uint8_t* end = src + data.size();
     
-    for (size_t i = 0; i < data.size(); i++) {
-        char c = static_cast<char>(data[i]);
+    while (src < end) {
+        // Copy the run of bytes that pass through unchanged in one go
+        const uint8_t* run = src;
+        while (run < end && BYTE_CLASSES[*run] == Keep) ++run;
+        size_t length = static_cast<size_t>(run - src);
+        std::memcpy(out, src, length);
+        out += length;
+        src = run;
+        if (src == end) break;
         
-        // Handle CRLF -> LF
-        if (c == '\r') {
-            if (i + 1 < data.size() && data[i + 1] == '\n') {
-                continue; // Skip \r, next iteration will add \n
+        // CRLF -> LF, lone CR -> LF, anything else non-printable is dropped
+        if (BYTE_CLASSES[*src] == CarriageReturn) {
+            if (src + 1 == end || src[1] != '\n') {
+                *out++ = '\n';
             }
-            c = '\n'; // Treat lone \r as \n
-        }
-        
-        // Filter out non-printable characters except newline and tab
-        if (c == '\n' || c == '\t' || (c >= 32 && c < 127)) {
-            text_ += c;
         }
+        ++src;
     }
+    text_.resize(static_cast<size_t>(out - text_.data()));
+    
+    build_line_index();
+    highlighter_.reset(SyntaxHighlighter::language_for(filename), line_starts_.size(),
+                       [this](size_t line) { return line_text(line); });
     
     // Reset scroll position for new file
     scroll_to_top_ = true;
+    
+    // The query outlives the file; find it in this one
+    if (!search_query_.empty()) {
+        run_search();
+    }
+}
+
+void TextViewer::build_line_index() {
+    line_starts_.clear();
+    line_starts_.push_back(0);
+    
+    const char* begin = text_.data();
+    const char* end = begin + text_.size();
+    const char* p = begin;
+    while (p < end) {
+        const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        if (!nl) break;
+        p = static_cast<const char*>(nl) + 1;
+        line_starts_.push_back(static_cast<size_t>(p - begin));
+    }
+}
+
+std::string_view TextViewer::line_text(size_t line) const {
+    size_t start = line_starts_[line];
+    size_t stop = line + 1 < line_starts_.size() ? line_starts_[line + 1] - 1 : text_.size();
+    return std::string_view(text_).substr(start, stop - start);
+}
+
+size_t TextViewer::line_for_offset(size_t offset) const {
+    auto it = std::upper_bound(line_starts_.begin(), line_starts_.end(), offset);
+    return static_cast<size_t>(it - line_starts_.begin()) - 1;
+}
+
+void TextViewer::run_search() {
+    matches_.clear();
+    current_match_ = -1;
+    if (search_query_.empty() || text_.empty()) return;
+    
+    std::boyer_moore_horspool_searcher searcher(search_query_.begin(), search_query_.end(),
+                                                CaseInsensitiveHash(), CaseInsensitiveEqual());
+    auto it = text_.cbegin();
+    while (matches_.size() < MAX_SEARCH_MATCHES) {
+        it = std::search(it, text_.cend(), searcher);
+        if (it == text_.cend()) break;
+        matches_.push_back(static_cast<size_t>(it - text_.cbegin()));
+        ++it;
+    }
+    
+    if (!matches_.empty()) {
+        goto_match(0);
+    }
+}
+
+void TextViewer::goto_match(int index) {
+    if (matches_.empty()) return;
+    int count = static_cast<int>(matches_.size());
+    current_match_ = ((index % count) + count) % count;
+    scroll_to_line_ = static_cast<int>(line_for_offset(matches_[current_match_]));
 }
 
 void TextViewer::render() {
@@ -67,52 +181,37 @@ void TextViewer::render() {
             scroll_to_top_ = false;
         }
         
-        if (show_line_numbers_) {
-            // Split into lines and display with line numbers
-            size_t line = 1;
-            size_t start = 0;
-            
-            for (size_t i = 0; i <= text_.size(); i++) {
-                if (i == text_.size() || text_[i] == '\n') {
-                    // Line number
-                    ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "%4zu ", line);
-                    ImGui::SameLine();
-                    
-                    // Line content
-                    std::string line_text = text_.substr(start, i - start);
-                    
-                    // Syntax highlighting for common patterns
-                    bool has_keyword = false;
-                    const char* keywords[] = {"void", "int", "float", "bool", "string", "class",
-                                              "return", "if", "else", "for", "while", "switch",
-                                              "case", "break", "continue", "true", "false", "null"};
-                    
-                    for (const char* kw : keywords) {
-                        if (line_text.find(kw) != std::string::npos) {
-                            has_keyword = true;
-                            break;
-                        }
-                    }
-                    
-                    if (line_text.find("//") != std::string::npos) {
-                        ImGui::TextColored(ImVec4(0.4f, 0.6f, 0.4f, 1.0f), "%s", line_text.c_str());
-                    } else if (has_keyword) {
-                        ImGui::TextColored(ImVec4(0.7f, 0.8f, 1.0f, 1.0f), "%s", line_text.c_str());
-                    } else {
-                        ImGui::TextUnformatted(line_text.c_str());
-                    }
-                    
-                    start = i + 1;
-                    line++;
+        bool wrap = word_wrap_ && line_starts_.size() <= WRAP_LINE_LIMIT;
+        
+        if (wrap) {
+            // Small file: every line is submitted so wrapped heights stay exact
+            ImGui::PushTextWrapPos(0.0f);
+            for (size_t line = 0; line < line_starts_.size(); ++line) {
+                render_line(line, true);
+                if (scroll_to_line_ == static_cast<int>(line)) {
+                    ImGui::SetScrollHereY(0.5f);
+                    scroll_to_line_ = -1;
                 }
             }
+            ImGui::PopTextWrapPos();
         } else {
-            // Simple text display
-            if (word_wrap_) {
-                ImGui::TextWrapped("%s", text_.c_str());
-            } else {
-                ImGui::TextUnformatted(text_.c_str());
+            // Rows are uniform, so jump straight to a search hit
+            float line_height = ImGui::GetTextLineHeightWithSpacing();
+            if (scroll_to_line_ >= 0) {
+                float target = scroll_to_line_ * line_height - ImGui::GetWindowHeight() * 0.5f;
+                ImGui::SetScrollY(std::max(0.0f, target));
+                scroll_to_line_ = -1;
             }
+            
+            // Only the lines on screen are submitted
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(line_starts_.size()), line_height);
+            while (clipper.Step()) {
+                for (int line = clipper.DisplayStart; line < clipper.DisplayEnd; ++line) {
+                    render_line(static_cast<size_t>(line), false);
+                }
+            }
+            clipper.End();
         }
     }
     ImGui::EndChild();
@@ -120,20 +219,99 @@ void TextViewer::render() {
     ImGui::PopStyleColor();
     
     // Status bar
-    size_t line_count = std::count(text_.begin(), text_.end(), '\n') + 1;
     ImGui::Text("File: %s | Lines: %zu | Size: %zu bytes", 
-                filename_.c_str(), line_count, text_.size());
+                filename_.c_str(), line_starts_.size(), text_.size());
+}
+
+void TextViewer::render_line(size_t line, bool wrap) {
+    std::string_view line_text = this->line_text(line);
+    const char* begin = line_text.data();
+    const char* end = begin + line_text.size();
+    
+    if (show_line_numbers_) {
+        ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "%4zu ", line + 1);
+        ImGui::SameLine();
+    }
+    
+    // Highlight the current search hit behind the text
+    if (current_match_ >= 0) {
+        size_t match = matches_[current_match_];
+        size_t line_start = line_starts_[line];
+        if (match >= line_start && match < line_start + line_text.size()) {
+            ImVec2 pos = ImGui::GetCursorScreenPos();
+            const char* match_begin = text_.data() + match;
+            const char* match_end = std::min(match_begin + search_query_.size(), end);
+            float x0 = ImGui::CalcTextSize(begin, match_begin).x;
+            float x1 = ImGui::CalcTextSize(begin, match_end).x;
+            ImGui::GetWindowDrawList()->AddRectFilled(
+                ImVec2(pos.x + x0, pos.y), ImVec2(pos.x + x1, pos.y + ImGui::GetTextLineHeight()),
+                IM_COL32(200, 160, 40, 110));
+        }
+    }
+    
+    // Wrapped text has to go out as one item, so it stays unhighlighted
+    const std::vector<Token>* tokens = wrap ? nullptr : &highlighter_.tokens(line);
+    if (!tokens || tokens->empty()) {
+        ImGui::TextUnformatted(begin, end);
+        return;
+    }
+    
+    for (size_t i = 0; i < tokens->size(); ++i) {
+        const Token& token = (*tokens)[i];
+        if (i > 0) ImGui::SameLine(0.0f, 0.0f);
+        ImGui::PushStyleColor(ImGuiCol_Text, token_color(token.kind));
+        ImGui::TextUnformatted(begin + token.start, begin + token.start + token.length);
+        ImGui::PopStyleColor();
+    }
 }
 
 void TextViewer::render_toolbar() {
     ImGui::Checkbox("Line Numbers", &show_line_numbers_);
     ImGui::SameLine();
+    
+    bool can_wrap = line_starts_.size() <= WRAP_LINE_LIMIT;
+    if (!can_wrap) ImGui::BeginDisabled();
     ImGui::Checkbox("Word Wrap", &word_wrap_);
+    if (!can_wrap) ImGui::EndDisabled();
+    if (!can_wrap && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+        ImGui::SetTooltip("Word wrap is off for files over %zu lines", WRAP_LINE_LIMIT);
+    }
+    
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(220.0f);
+    if (widgets::SearchInput("##TextSearch", search_query_, 256)) {
+        run_search();
+    }
+    
+    ImGui::SameLine();
+    if (ImGui::SmallButton("<")) goto_match(current_match_ - 1);
+    ImGui::SameLine();
+    if (ImGui::SmallButton(">")) goto_match(current_match_ + 1);
+    ImGui::SameLine();
+    if (!search_query_.empty()) {
+        if (matches_.empty()) {
+            ImGui::TextDisabled("No matches");
+        } else {
+            ImGui::TextDisabled("%d / %zu%s", current_match_ + 1, matches_.size(),
+                                matches_.size() >= MAX_SEARCH_MATCHES ? "+" : "");
+        }
+    }
+}
+
+void TextViewer::goto_line(size_t line) {
+    if (line_starts_.empty()) return;
+    scroll_to_line_ = static_cast<int>(std::min(line, line_starts_.size() - 1));
+    scroll_to_top_ = false;
 }
 
 void TextViewer::clear() {
     text_.clear();
     filename_.clear();
+    line_starts_.clear();
+    highlighter_.reset(SyntaxHighlighter::Language::None, 0, nullptr);
+    matches_.clear();
+    current_match_ = -1;
+    scroll_to_line_ = -1;
     scroll_to_top_ = true;
 }
 
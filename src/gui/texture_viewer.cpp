@@ -3,9 +3,11 @@
  */
 
 #include "gui/texture_viewer.hpp"
+#include "gui/widgets.hpp"
 #include "enfusion/dds_loader.hpp"
 #include "enfusion/edds_converter.hpp"
 #include "enfusion/files.hpp"
+#include "enfusion/arena.hpp"
 
 #include <imgui.h>
 #include <glad/glad.h>
@@ -17,69 +19,104 @@ namespace enfusion {
 TextureViewer::TextureViewer() = default;
 
 TextureViewer::~TextureViewer() {
+    cancel_decode();
+    uploader_.cleanup();
     if (texture_id_ != 0) {
         glDeleteTextures(1, &texture_id_);
     }
 }
 
 void TextureViewer::load_texture_data(const std::vector<uint8_t>& data, const std::string& name) {
-    // ALWAYS clear previous texture first
+    // ALWAYS clear previous texture first (also cancels a decode in flight)
     clear();
     
     texture_name_ = name;
-    loading_ = true;
     error_message_.clear();
 
-    try {
-        if (data.empty()) {
-            error_message_ = "Empty data";
-            loading_ = false;
-            return;
-        }
+    if (data.empty()) {
+        error_message_ = "Empty data";
+        return;
+    }
 
-        std::vector<uint8_t> dds_data;
+    loading_ = true;
+
+    // Decode on a worker, then upload from the UI thread; cancelling skips whatever hasn't run
+    auto job = std::make_shared<DecodeJob>();
+    job->data = data;
+
+    auto& scheduler = TaskScheduler::instance();
+    TaskOptions options;
+    options.priority = TaskPriority::Interactive;
+    options.token = job->cancel;
+    options.name = "texture.decode";
+    TaskHandle decode = scheduler.submit([job]() { decode_texture(*job); }, std::move(options));
+    scheduler.run_on_main([this, job]() { finish_decode(*job); }, {decode}, job->cancel);
+    decode_job_ = std::move(job);
+}
+
+void TextureViewer::decode_texture(DecodeJob& job) {
+    if (job.cancel.cancelled()) return;
+
+    try {
+        // Intermediate DDS lives in the scratch arena, released when this decode returns
+        ArenaScope scope;
+        std::pmr::vector<uint8_t> converted(scope.resource());
+        std::span<const uint8_t> dds_data(job.data.data(), job.data.size());
 
         // Check if EDDS (starts with "DDS " but has COPY/LZ4 mip table)
-        EddsConverter converter(std::span<const uint8_t>(data.data(), data.size()));
+        EddsConverter converter(dds_data);
         if (converter.is_edds()) {
-            dds_data = converter.convert();
-            if (dds_data.empty()) {
-                // Conversion failed, try original data
-                dds_data = data;
+            converted = converter.convert(scope.resource());
+            // If conversion failed, fall back to the original data
+            if (!converted.empty()) {
+                dds_data = std::span<const uint8_t>(converted.data(), converted.size());
             }
-        } else {
-            dds_data = data;
         }
 
-        auto result = DdsLoader::load(std::span<const uint8_t>(dds_data.data(), dds_data.size()));
-        if (!result) {
-            error_message_ = "Failed to parse DDS data";
-            loading_ = false;
-            return;
+        job.texture = DdsLoader::load(dds_data);
+        if (!job.texture) {
+            job.error = "Failed to parse DDS data";
         }
+    } catch (const std::exception& e) {
+        job.error = std::string("Error: ") + e.what();
+    }
+    std::vector<uint8_t>().swap(job.data);
+}
+
+void TextureViewer::finish_decode(DecodeJob& job) {
+    decode_job_.reset();
+    loading_ = false;
 
-        pixel_data_ = std::move(result->pixels);
-        width_ = result->width;
-        height_ = result->height;
-        channels_ = result->channels;
-        format_ = result->format;
-        mip_levels_ = result->mip_count;
+    if (!job.error.empty()) {
+        error_message_ = job.error;
+        return;
+    }
 
-        // Create OpenGL texture
-        create_gl_texture();
+    TextureData& result = *job.texture;
+    pixel_data_ = std::move(result.pixels);
+    width_ = result.width;
+    height_ = result.height;
+    channels_ = result.channels;
+    format_ = result.format;
+    mip_levels_ = result.mip_count;
 
-        texture_loaded_ = true;
-        loading_ = false;
+    // Create OpenGL texture
+    create_gl_texture();
 
-        // Reset view for new texture
-        zoom_ = 1.0f;
-        pan_x_ = 0.0f;
-        pan_y_ = 0.0f;
+    texture_loaded_ = true;
 
-    } catch (const std::exception& e) {
-        error_message_ = std::string("Error: ") + e.what();
-        loading_ = false;
-    }
+    // Reset view for new texture
+    zoom_ = 1.0f;
+    pan_x_ = 0.0f;
+    pan_y_ = 0.0f;
+}
+
+void TextureViewer::cancel_decode() {
+    if (!decode_job_) return;
+
+    decode_job_->cancel.cancel();
+    decode_job_.reset();
+    loading_ = false;
 }
 
 void TextureViewer::load_texture(const std::filesystem::path& path) {
@@ -89,11 +126,15 @@ void TextureViewer::load_texture(const std::filesystem::path& path) {
 }
 
 void TextureViewer::clear() {
-    // Delete existing OpenGL texture
+    cancel_decode();
+
+    // Delete existing OpenGL texture and forget any upload still in flight
     if (texture_id_ != 0) {
         glDeleteTextures(1, &texture_id_);
         texture_id_ = 0;
     }
+    uploader_.discard();
+    upload_ticket_ = 0;
     
     // Clear all state
     texture_loaded_ = false;
@@ -115,29 +156,42 @@ void TextureViewer::clear() {
 
 void TextureViewer::create_gl_texture() {
     // Delete any existing texture
-    if (texture_id_ != 0) {
-        glDeleteTextures(1, &texture_id_);
-        texture_id_ = 0;
-    }
+    destroy_gl_texture();
+    uploader_.discard();
+    upload_ticket_ = 0;
 
     if (pixel_data_.empty() || width_ == 0 || height_ == 0) {
         return;
     }
 
-    glGenTextures(1, &texture_id_);
-    glBindTexture(GL_TEXTURE_2D, texture_id_);
+    // Pixels go through the PBO ring; the texture shows up a frame or two later
+    TextureData texture;
+    texture.pixels = std::move(pixel_data_);
+    texture.width = width_;
+    texture.height = height_;
+    texture.channels = channels_;
+    upload_ticket_ = uploader_.enqueue(std::move(texture));
+}
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+void TextureViewer::poll_upload() {
+    uploader_.pump();
 
-    GLenum gl_format = (channels_ == 4) ? GL_RGBA : GL_RGB;
-    glTexImage2D(GL_TEXTURE_2D, 0, gl_format, width_, height_, 0, gl_format,
-                 GL_UNSIGNED_BYTE, pixel_data_.data());
-    glGenerateMipmap(GL_TEXTURE_2D);
-    
-    glBindTexture(GL_TEXTURE_2D, 0);
+    for (const auto& finished : uploader_.take_finished()) {
+        uint32_t texture = finished.texture;
+        if (finished.ticket != upload_ticket_) {
+            glDeleteTextures(1, &texture);
+            continue;
+        }
+        if (finished.failed) {
+            upload_ticket_ = 0;
+            texture_loaded_ = false;
+            error_message_ = "Failed to upload texture to the GPU";
+            continue;
+        }
+        destroy_gl_texture();
+        texture_id_ = texture;
+        upload_ticket_ = 0;
+    }
 }
 
 void TextureViewer::destroy_gl_texture() {
@@ -153,6 +207,7 @@ bool TextureViewer::parse_dds(const std::vector<uint8_t>& data) {
 }
 
 void TextureViewer::render() {
+    poll_upload();
     render_toolbar();
 
     ImGui::Separator();
@@ -169,6 +224,13 @@ void TextureViewer::render() {
         return;
     }
 
+    if (texture_loaded_ && upload_ticket_ != 0) {
+        widgets::Spinner("##TextureUpload", 10.0f, 3.0f, IM_COL32(100, 180, 255, 255));
+        ImGui::SameLine();
+        ImGui::Text("Uploading %ux%u...", width_, height_);
+        return;
+    }
+
     if (!texture_loaded_ || texture_id_ == 0) {
         ImGui::TextDisabled("No texture loaded.");
         ImGui::TextDisabled("Select a .edds or .dds file.");
@@ -3,6 +3,7 @@
  */
 
 #include "gui/widgets.hpp"
+#include "gui/app.hpp"
 #include <filesystem>
 #include <imgui.h>
 #include <imgui_internal.h>
@@ -108,6 +109,9 @@ void Spinner(const char* label, float radius, float thickness, ImU32 color) {
     ImGui::ItemSize(bb);
     if (!ImGui::ItemAdd(bb, 0)) return;
     
+    // Keep the loop drawing while a spinner is on screen
+    App::instance().request_redraw(1.0 / 30.0);
+    
     float time = static_cast<float>(ImGui::GetTime());
     int num_segments = 30;
     float start = fabsf(sinf(time * 1.8f) * (num_segments - 5));
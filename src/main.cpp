@@ -3,65 +3,165 @@
  */
 
 #include "gui/app.hpp"
+#include "enfusion/addon_extractor.hpp"
+#include "enfusion/image_io.hpp"
+#include "enfusion/logging.hpp"
+#include "enfusion/mesh_thumbnails.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/task_scheduler.hpp"
 
 #ifdef _WIN32
 #include <Windows.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <ctime>
+#include <string>
+#include <vector>
 
-// Global log file stream
-static std::ofstream g_log_file;
-
-// Custom stream buffer that writes to file
+// Forwards std::cerr to the logger a whole line at a time. Each thread builds
+// its own line, so concurrent writers neither interleave nor take a lock, and
+// nothing touches the file on the calling thread.
 class LogStreamBuf : public std::streambuf {
-public:
-    LogStreamBuf(std::ofstream& file) : file_(file) {}
 protected:
     int overflow(int c) override {
         if (c != EOF) {
-            file_.put(static_cast<char>(c));
-            file_.flush();
+            append(static_cast<char>(c));
         }
         return c;
     }
     std::streamsize xsputn(const char* s, std::streamsize n) override {
-        file_.write(s, n);
-        file_.flush();
+        for (std::streamsize i = 0; i < n; i++) {
+            append(s[i]);
+        }
         return n;
     }
 private:
-    std::ofstream& file_;
+    static void append(char c) {
+        thread_local std::string line;
+        if (c == '\n') {
+            enfusion::Logger::instance().write_line(std::move(line));
+            line.clear();
+        } else {
+            line += c;
+        }
+    }
 };
 
 static LogStreamBuf* g_log_buf = nullptr;
+static std::streambuf* g_cerr_buf = nullptr;
 
 void init_logging() {
-    // Open log file with timestamp
-    g_log_file.open("enfusion_unpacker.log", std::ios::out | std::ios::trunc);
-    if (g_log_file.is_open()) {
-        // Write header
-        std::time_t now = std::time(nullptr);
-        char time_buf[64];
-        std::strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
-        g_log_file << "=== Enfusion Unpacker Log - " << time_buf << " ===\n\n";
-        g_log_file.flush();
-        
-        // Redirect cerr to log file
-        g_log_buf = new LogStreamBuf(g_log_file);
-        std::cerr.rdbuf(g_log_buf);
-    }
+    // The logger opens enfusion_unpacker.log and writes it from its own thread
+    enfusion::Logger::instance();
+
+    g_log_buf = new LogStreamBuf();
+    g_cerr_buf = std::cerr.rdbuf(g_log_buf);
 }
 
 void shutdown_logging() {
-    if (g_log_file.is_open()) {
-        g_log_file << "\n=== Log End ===\n";
-        g_log_file.close();
+    if (g_log_buf) {
+        std::cerr.rdbuf(g_cerr_buf);
+        delete g_log_buf;
+        g_log_buf = nullptr;
+    }
+    enfusion::Logger::instance().shutdown();
+}
+
+// Release builds have no console of their own (WIN32 subsystem); borrow the
+// one the command was run from so headless output is visible
+static void attach_parent_console() {
+#ifdef _WIN32
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        FILE* stream = nullptr;
+        freopen_s(&stream, "CONOUT$", "w", stdout);
+        std::cout.clear();
+    }
+#endif
+}
+
+// Thumbnails every mesh in an addon into PNG contact sheets of SHEET_TILES
+// each, plus a .txt per sheet naming the mesh in every cell. No window or
+// GL context is created.
+static int run_contact_sheets(const std::filesystem::path& addon_dir, const std::filesystem::path& output,
+                              uint32_t tile_size) {
+    constexpr uint32_t SHEET_COLUMNS = 16;
+    constexpr size_t SHEET_TILES = SHEET_COLUMNS * SHEET_COLUMNS;
+
+    enfusion::AddonExtractor extractor;
+    auto loaded = extractor.load(addon_dir);
+    if (!loaded) {
+        std::cout << "Could not open addon: " << loaded.error().full_message() << std::endl;
+        return 1;
+    }
+
+    std::vector<enfusion::ThumbnailRequest> requests;
+    for (const auto& file : extractor.files()) {
+        std::string lower = file.path;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        if (!lower.ends_with(".xob")) continue;
+
+        enfusion::ThumbnailRequest request;
+        request.path = file.path;
+        request.key = extractor.content_key(file.path);
+        request.read = [&extractor, path = file.path]() { return extractor.read_file(path).value_or({}); };
+        requests.push_back(std::move(request));
+    }
+    std::sort(requests.begin(), requests.end(),
+              [](const auto& a, const auto& b) { return a.path < b.path; });
+
+    if (requests.empty()) {
+        std::cout << "No meshes in " << addon_dir.string() << std::endl;
+        return 1;
+    }
+
+    enfusion::RasterOptions options;
+    options.size = tile_size;
+    size_t sheets = (requests.size() + SHEET_TILES - 1) / SHEET_TILES;
+    size_t failed = 0;
+
+    // One sheet at a time keeps only SHEET_TILES thumbnails in memory
+    for (size_t sheet = 0; sheet < sheets; sheet++) {
+        size_t first = sheet * SHEET_TILES;
+        std::vector<enfusion::ThumbnailRequest> batch(
+            requests.begin() + first, requests.begin() + std::min(first + SHEET_TILES, requests.size()));
+
+        std::vector<enfusion::TextureData> tiles(batch.size());
+        std::atomic<size_t> empty{0};
+        enfusion::ThumbnailCache::instance().render_all(batch, options, enfusion::TaskPriority::Interactive, {},
+            [&](size_t i, enfusion::TextureData image) {
+                if (image.width == 0) empty++;
+                tiles[i] = std::move(image);
+            });
+        failed += empty;
+
+        auto path = output;
+        if (sheets > 1) {
+            path.replace_filename(output.stem().string() + "_" + std::to_string(sheet + 1) + output.extension().string());
+        }
+        if (!enfusion::write_png(path, enfusion::make_contact_sheet(tiles, SHEET_COLUMNS, tile_size))) {
+            std::cout << "Could not write " << path.string() << std::endl;
+            return 1;
+        }
+
+        auto listing_path = path;
+        listing_path.replace_extension(".txt");
+        std::ofstream listing(listing_path, std::ios::trunc);
+        for (size_t i = 0; i < batch.size(); i++) {
+            listing << i / SHEET_COLUMNS << "\t" << i % SHEET_COLUMNS << "\t" << batch[i].path
+                    << (tiles[i].width == 0 ? "\t(failed)" : "") << "\n";
+        }
+
+        std::cout << "Wrote " << path.string() << " (" << batch.size() << " meshes)" << std::endl;
     }
-    delete g_log_buf;
-    g_log_buf = nullptr;
+
+    std::cout << requests.size() << " meshes, " << failed << " could not be rendered" << std::endl;
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
@@ -72,6 +172,33 @@ int main(int argc, char* argv[]) {
     
     // Initialize file logging
     init_logging();
+
+    // --metrics-json <path>: dump counters and latency percentiles on exit
+    std::string metrics_path;
+    // --contact-sheet <addon dir> <out.png> [--thumbnail-size N]: render mesh thumbnails headless and exit
+    std::string sheet_addon;
+    std::string sheet_output;
+    uint32_t thumbnail_size = 128;
+    for (int i = 1; i + 1 < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--metrics-json") {
+            metrics_path = argv[++i];
+        } else if (arg == "--contact-sheet" && i + 2 < argc) {
+            sheet_addon = argv[++i];
+            sheet_output = argv[++i];
+        } else if (arg == "--thumbnail-size") {
+            thumbnail_size = static_cast<uint32_t>(std::clamp(std::atoi(argv[++i]), 16, 1024));
+        }
+    }
+
+    if (!sheet_addon.empty()) {
+        attach_parent_console();
+        int result = run_contact_sheets(sheet_addon, sheet_output, thumbnail_size);
+        enfusion::TaskScheduler::instance().shutdown();
+        if (!metrics_path.empty()) enfusion::metrics::Registry::instance().write_json(metrics_path);
+        shutdown_logging();
+        return result;
+    }
     
     auto& app = enfusion::App::instance();
     
@@ -82,6 +209,10 @@ int main(int argc, char* argv[]) {
     
     app.run();
     app.shutdown();
+
+    if (!metrics_path.empty() && !enfusion::metrics::Registry::instance().write_json(metrics_path)) {
+        std::cerr << "[Metrics] Could not write " << metrics_path << std::endl;
+    }
     
     shutdown_logging();
     return 0;
@@ -0,0 +1,54 @@
+/**
+ * Enfusion Unpacker - Reusable GPU buffer implementation
+ */
+
+#include "renderer/gpu_buffer.hpp"
+#include <glad/glad.h>
+#include <algorithm>
+
+namespace enfusion {
+
+GpuBuffer::GpuBuffer(uint32_t target) : target_(target) {}
+
+GpuBuffer::~GpuBuffer() {
+    release();
+}
+
+void GpuBuffer::upload(const void* data, size_t bytes) {
+    if (id_ == 0) {
+        glGenBuffers(1, &id_);
+    }
+    glBindBuffer(target_, id_);
+
+    if (bytes > capacity_) {
+        // Grow by half again so a run of slightly larger meshes settles quickly
+        size_t grown = std::max(bytes, capacity_ + capacity_ / 2);
+        grown = (grown + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+        glBufferData(target_, static_cast<GLsizeiptr>(grown), nullptr, GL_DYNAMIC_DRAW);
+        capacity_ = grown;
+        ++reallocations_;
+    } else {
+        // Orphan the old contents so the write never waits on a draw still using them
+        glBufferData(target_, static_cast<GLsizeiptr>(capacity_), nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    if (bytes > 0) {
+        glBufferSubData(target_, 0, static_cast<GLsizeiptr>(bytes), data);
+    }
+    size_ = bytes;
+}
+
+void GpuBuffer::bind() const {
+    glBindBuffer(target_, id_);
+}
+
+void GpuBuffer::release() {
+    if (id_ != 0) {
+        glDeleteBuffers(1, &id_);
+        id_ = 0;
+    }
+    size_ = 0;
+    capacity_ = 0;
+}
+
+} // namespace enfusion
@@ -4,12 +4,17 @@
 
 #include "renderer/mesh_renderer.hpp"
 #include "renderer/shader.hpp"
+#include "enfusion/logging.hpp"
+#include "enfusion/trace.hpp"
 #include <glad/glad.h>
-#include <iostream>
+#include <algorithm>
 
 namespace enfusion {
 
-MeshRenderer::MeshRenderer() = default;
+MeshRenderer::MeshRenderer()
+    : vertex_buffer_(GL_ARRAY_BUFFER)
+    , index_buffer_(GL_ELEMENT_ARRAY_BUFFER) {
+}
 
 MeshRenderer::~MeshRenderer() {
     cleanup();
@@ -30,10 +35,12 @@ void MeshRenderer::init() {
 void MeshRenderer::cleanup() {
     if (vao_ != 0) {
         glDeleteVertexArrays(1, &vao_);
-        glDeleteBuffers(1, &vbo_);
-        glDeleteBuffers(1, &ebo_);
-        vao_ = vbo_ = ebo_ = 0;
+        vao_ = 0;
     }
+    vertex_buffer_.release();
+    index_buffer_.release();
+    batches_.clear();
+    batches_dirty_ = true;
     
     if (grid_vao_ != 0) {
         glDeleteVertexArrays(1, &grid_vao_);
@@ -43,54 +50,53 @@ void MeshRenderer::cleanup() {
 }
 
 void MeshRenderer::set_mesh(const XobMesh* mesh) {
+    if (!mesh) {
+        set_mesh(nullptr, {}, {});
+        return;
+    }
+    set_mesh(mesh, mesh->vertices, mesh->indices);
+}
+
+void MeshRenderer::set_mesh(const XobMesh* mesh, std::span<const XobVertex> vertices,
+                            std::span<const uint32_t> indices) {
     mesh_ = mesh;
+    batches_dirty_ = true;
     if (mesh_) {
-        upload_mesh();
+        upload_mesh(vertices, indices);
     }
 }
 
-void MeshRenderer::upload_mesh() {
-    if (!mesh_) return;
-    
-    std::cerr << "[Renderer] Uploading mesh: verts=" << mesh_->vertices.size() 
-              << " indices=" << mesh_->indices.size() << "\n";
-    
-    // Debug: Print first few vertices
-    for (size_t i = 0; i < std::min(size_t(3), mesh_->vertices.size()); i++) {
-        const auto& v = mesh_->vertices[i];
-        std::cerr << "[Renderer]   Vert " << i << ": pos=(" << v.position.x << ", " 
-                  << v.position.y << ", " << v.position.z << ")\n";
-    }
-    
-    // Clean up old buffers
-    if (vao_ != 0) {
-        glDeleteVertexArrays(1, &vao_);
-        glDeleteBuffers(1, &vbo_);
-        glDeleteBuffers(1, &ebo_);
+void MeshRenderer::upload_mesh(std::span<const XobVertex> vertices, std::span<const uint32_t> indices) {
+    TRACE_SPAN(span, "gl.upload_mesh");
+    TRACE_ARG(span, "vertices", vertices.size());
+    TRACE_ARG(span, "indices", indices.size());
+    
+    // The VAO and its buffers live as long as the renderer; only the contents change
+    bool fresh = vao_ == 0;
+    if (fresh) {
+        glGenVertexArrays(1, &vao_);
     }
+    glBindVertexArray(vao_);
     
-    // Create VAO
-    glGenVertexArrays(1, &vao_);
-    glGenBuffers(1, &vbo_);
-    glGenBuffers(1, &ebo_);
+    size_t vertex_reallocs = vertex_buffer_.reallocations();
+    size_t index_reallocs = index_buffer_.reallocations();
     
-    glBindVertexArray(vao_);
+    vertex_buffer_.upload(vertices.data(), vertices.size_bytes());
+    index_buffer_.upload(indices.data(), indices.size_bytes());
     
-    // Upload vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, 
-                 mesh_->vertices.size() * sizeof(XobVertex),
-                 mesh_->vertices.data(),
-                 GL_STATIC_DRAW);
+    if (vertex_buffer_.reallocations() != vertex_reallocs ||
+        index_buffer_.reallocations() != index_reallocs) {
+        LOG_DEBUG("Renderer", "Grew mesh buffers: vertex=" << vertex_buffer_.capacity()
+                              << " index=" << index_buffer_.capacity() << " bytes");
+    }
     
-    // Upload index data
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 mesh_->indices.size() * sizeof(uint32_t),
-                 mesh_->indices.data(),
-                 GL_STATIC_DRAW);
+    vertex_count_ = vertices.size();
+    index_count_ = indices.size();
     
-    std::cerr << "[Renderer] VAO=" << vao_ << " VBO=" << vbo_ << " EBO=" << ebo_ << "\n";
+    if (!fresh) {
+        glBindVertexArray(0);
+        return;
+    }
     
     // Set vertex attributes
     // Position
@@ -109,9 +115,67 @@ void MeshRenderer::upload_mesh() {
                           reinterpret_cast<void*>(offsetof(XobVertex, uv)));
     
     glBindVertexArray(0);
+}
+
+void MeshRenderer::set_material_textures(std::vector<uint32_t> textures) {
+    if (textures == material_textures_) return;
+    material_textures_ = std::move(textures);
+    batches_dirty_ = true;
+}
+
+void MeshRenderer::lod_span(size_t& offset, size_t& count) const {
+    offset = 0;
+    count = index_count_;
+    
+    if (!mesh_->lods.empty() && current_lod_ < static_cast<int>(mesh_->lods.size())) {
+        offset = mesh_->lods[current_lod_].index_offset;
+        count = mesh_->lods[current_lod_].index_count;
+    }
+}
+
+void MeshRenderer::build_batches() {
+    batches_.clear();
+    batches_dirty_ = false;
+    batched_lod_ = current_lod_;
+    if (!mesh_) return;
+    
+    size_t lod_offset = 0;
+    size_t lod_count = 0;
+    lod_span(lod_offset, lod_count);
+    
+    auto texture_for = [&](uint32_t material) {
+        return material < material_textures_.size() ? material_textures_[material] : 0u;
+    };
     
-    vertex_count_ = mesh_->vertices.size();
-    index_count_ = mesh_->indices.size();
+    // Group ranges by texture so each texture is bound once per frame
+    auto add = [&](uint32_t texture, size_t start, size_t count) {
+        auto it = std::find_if(batches_.begin(), batches_.end(),
+                               [&](const DrawBatch& b) { return b.texture == texture; });
+        if (it == batches_.end()) {
+            it = batches_.emplace(batches_.end());
+            it->texture = texture;
+        }
+        
+        if (!it->counts.empty() && it->end_index == start) {
+            it->counts.back() += static_cast<int32_t>(count);
+        } else {
+            it->counts.push_back(static_cast<int32_t>(count));
+            it->offsets.push_back(reinterpret_cast<const void*>(start * sizeof(uint32_t)));
+        }
+        it->end_index = start + count;
+    };
+    
+    if (mesh_->material_ranges.empty()) {
+        add(texture_for(0), lod_offset, lod_count);
+        return;
+    }
+    
+    for (const auto& range : mesh_->material_ranges) {
+        if (range.start_index >= lod_count) continue;
+        size_t count = std::min<size_t>(range.index_count, lod_count - range.start_index);
+        if (count == 0) continue;
+        add(texture_for(range.material_index), lod_offset + range.start_index, count);
+    }
 }
 
 void MeshRenderer::create_grid() {
@@ -164,15 +228,8 @@ void MeshRenderer::render_mesh(const glm::mat4& view, const glm::mat4& projectio
     mesh_shader_->set_vec3("lightColor", glm::vec3(1.0f));
     mesh_shader_->set_vec3("objectColor", glm::vec3(0.8f, 0.8f, 0.85f));
     
-    // Bind diffuse texture if available
-    if (diffuse_texture_ != 0) {
-        mesh_shader_->set_bool("useTexture", true);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuse_texture_);
-        mesh_shader_->set_int("diffuseMap", 0);
-    } else {
-        mesh_shader_->set_bool("useTexture", false);
-    }
+    mesh_shader_->set_int("diffuseMap", 0);
+    glActiveTexture(GL_TEXTURE0);
     
     glBindVertexArray(vao_);
     
@@ -180,19 +237,36 @@ void MeshRenderer::render_mesh(const glm::mat4& view, const glm::mat4& projectio
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
     
-    // Determine index range based on LOD
-    size_t index_offset = 0;
-    size_t index_count = index_count_;
-    
-    if (!mesh_->lods.empty() && current_lod_ < static_cast<int>(mesh_->lods.size())) {
-        index_offset = mesh_->lods[current_lod_].index_offset;
-        index_count = mesh_->lods[current_lod_].index_count;
+    if (diffuse_texture_ != 0) {
+        // Hand-picked texture covers the whole LOD in one draw
+        size_t index_offset = 0;
+        size_t index_count = 0;
+        lod_span(index_offset, index_count);
+        
+        mesh_shader_->set_bool("useTexture", true);
+        glBindTexture(GL_TEXTURE_2D, diffuse_texture_);
+        glDrawElements(GL_TRIANGLES, 
+                       static_cast<GLsizei>(index_count),
+                       GL_UNSIGNED_INT,
+                       reinterpret_cast<void*>(index_offset * sizeof(uint32_t)));
+    } else {
+        if (batches_dirty_ || batched_lod_ != current_lod_) {
+            build_batches();
+        }
+        
+        // One submission per texture, covering every range that uses it
+        for (const auto& batch : batches_) {
+            mesh_shader_->set_bool("useTexture", batch.texture != 0);
+            glBindTexture(GL_TEXTURE_2D, batch.texture);
+            glMultiDrawElements(GL_TRIANGLES,
+                                batch.counts.data(),
+                                GL_UNSIGNED_INT,
+                                batch.offsets.data(),
+                                static_cast<GLsizei>(batch.counts.size()));
+        }
     }
     
-    glDrawElements(GL_TRIANGLES, 
-                   static_cast<GLsizei>(index_count),
-                   GL_UNSIGNED_INT,
-                   reinterpret_cast<void*>(index_offset * sizeof(uint32_t)));
+    glBindTexture(GL_TEXTURE_2D, 0);
     
     if (wireframe_) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
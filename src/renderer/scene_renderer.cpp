@@ -0,0 +1,255 @@
+/**
+ * Enfusion Unpacker - Instanced scene renderer implementation
+ */
+
+#include "renderer/scene_renderer.hpp"
+#include "renderer/shader.hpp"
+#include "enfusion/logging.hpp"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cfloat>
+
+namespace enfusion {
+
+SceneRenderer::SceneRenderer()
+    : vertex_buffer_(GL_ARRAY_BUFFER)
+    , index_buffer_(GL_ELEMENT_ARRAY_BUFFER)
+    , instance_buffer_(GL_ARRAY_BUFFER) {
+}
+
+SceneRenderer::~SceneRenderer() {
+    cleanup();
+}
+
+void SceneRenderer::init() {
+    shader_ = std::make_unique<Shader>();
+    shader_->load(Shader::INSTANCED_VERTEX_SHADER, Shader::MESH_FRAGMENT_SHADER);
+}
+
+void SceneRenderer::cleanup() {
+    if (vao_ != 0) {
+        glDeleteVertexArrays(1, &vao_);
+        vao_ = 0;
+    }
+    vertex_buffer_.release();
+    index_buffer_.release();
+    instance_buffer_.release();
+    meshes_.clear();
+    instances_.clear();
+}
+
+void SceneRenderer::clear() {
+    meshes_.clear();
+    instances_.clear();
+    stats_ = {};
+}
+
+void SceneRenderer::set_scene(std::vector<SceneMesh> meshes, std::vector<MeshInstance> instances) {
+    clear();
+
+    // Pack every mesh into one vertex and one index array
+    size_t total_vertices = 0;
+    size_t total_indices = 0;
+    for (const auto& mesh : meshes) {
+        total_vertices += mesh.vertices.size();
+        total_indices += mesh.indices.size();
+    }
+
+    std::vector<XobVertex> vertices;
+    std::vector<uint32_t> indices;
+    vertices.reserve(total_vertices);
+    indices.reserve(total_indices);
+
+    meshes_.reserve(meshes.size());
+    for (auto& mesh : meshes) {
+        MeshRecord record;
+        record.radius = mesh.radius;
+        for (auto lod : mesh.lods) {
+            lod.first_index += static_cast<uint32_t>(indices.size());
+            lod.base_vertex += static_cast<int32_t>(vertices.size());
+            record.lods.push_back(lod);
+        }
+        if (record.lods.size() > MAX_LODS) record.lods.resize(MAX_LODS);
+
+        vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+        indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+        mesh.vertices = {};
+        mesh.indices = {};
+        meshes_.push_back(std::move(record));
+    }
+
+    // Bounding spheres move with their instance; scale takes the largest axis
+    bounds_min_ = glm::vec3(FLT_MAX);
+    bounds_max_ = glm::vec3(-FLT_MAX);
+    instances_.reserve(instances.size());
+    for (const auto& instance : instances) {
+        if (instance.mesh >= meshes.size() || meshes_[instance.mesh].lods.empty()) continue;
+
+        const auto& mesh = meshes[instance.mesh];
+        const glm::mat4& m = instance.transform;
+        float scale = std::max({glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])),
+                                glm::length(glm::vec3(m[2]))});
+
+        InstanceRecord record;
+        record.mesh = instance.mesh;
+        record.transform = m;
+        record.center = glm::vec3(m * glm::vec4(mesh.center, 1.0f));
+        record.radius = mesh.radius * scale;
+        bounds_min_ = glm::min(bounds_min_, record.center - glm::vec3(record.radius));
+        bounds_max_ = glm::max(bounds_max_, record.center + glm::vec3(record.radius));
+        instances_.push_back(record);
+    }
+    if (instances_.empty()) {
+        bounds_min_ = bounds_max_ = glm::vec3(0.0f);
+    }
+
+    bool fresh = vao_ == 0;
+    if (fresh) {
+        glGenVertexArrays(1, &vao_);
+    }
+    glBindVertexArray(vao_);
+
+    vertex_buffer_.upload(vertices.data(), vertices.size() * sizeof(XobVertex));
+    index_buffer_.upload(indices.data(), indices.size() * sizeof(uint32_t));
+
+    if (fresh) {
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(XobVertex),
+                              reinterpret_cast<void*>(offsetof(XobVertex, position)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(XobVertex),
+                              reinterpret_cast<void*>(offsetof(XobVertex, normal)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(XobVertex),
+                              reinterpret_cast<void*>(offsetof(XobVertex, uv)));
+
+        // One mat4 per instance, as four vec4 columns
+        for (int column = 0; column < 4; ++column) {
+            glEnableVertexAttribArray(3 + column);
+            glVertexAttribDivisor(3 + column, 1);
+        }
+    }
+
+    glBindVertexArray(0);
+
+    LOG_DEBUG("SceneRenderer", "Uploaded " << meshes_.size() << " meshes ("
+              << vertices.size() << " verts, " << indices.size() << " indices) for "
+              << instances_.size() << " instances");
+}
+
+int SceneRenderer::choose_lod(const MeshRecord& mesh, float radius, float distance) const {
+    float size = radius / std::max(distance, 0.001f) * lod_bias_;
+    int lod = 0;
+    while (lod < static_cast<int>(LOD_THRESHOLDS.size()) && size < LOD_THRESHOLDS[lod]) {
+        ++lod;
+    }
+    return std::min(lod, static_cast<int>(mesh.lods.size()) - 1);
+}
+
+void SceneRenderer::point_instance_attributes(size_t first_instance) {
+    // GL 3.3 has no base instance, so the attributes are re-pointed per bucket
+    instance_buffer_.bind();
+    size_t base = first_instance * sizeof(glm::mat4);
+    for (int column = 0; column < 4; ++column) {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              reinterpret_cast<void*>(base + column * sizeof(glm::vec4)));
+    }
+}
+
+void SceneRenderer::render(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& eye) {
+    stats_ = {};
+    stats_.instances = instances_.size();
+    if (instances_.empty() || vao_ == 0 || !shader_) return;
+
+    // Frustum planes (Gribb/Hartmann), normalised so sphere tests use true distances
+    glm::mat4 vp = projection * view;
+    std::array<glm::vec4, 6> planes;
+    for (int i = 0; i < 3; ++i) {
+        glm::vec4 row(vp[0][i], vp[1][i], vp[2][i], vp[3][i]);
+        glm::vec4 w(vp[0][3], vp[1][3], vp[2][3], vp[3][3]);
+        planes[i * 2] = w + row;
+        planes[i * 2 + 1] = w - row;
+    }
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    // Cull and pick a LOD, then counting-sort survivors into (mesh, LOD) buckets
+    size_t bucket_count = meshes_.size() * MAX_LODS;
+    bucket_offsets_.assign(bucket_count + 1, 0);
+    instance_keys_.resize(instances_.size());
+
+    for (size_t i = 0; i < instances_.size(); ++i) {
+        const auto& instance = instances_[i];
+        bool inside = true;
+        for (const auto& plane : planes) {
+            if (glm::dot(glm::vec3(plane), instance.center) + plane.w < -instance.radius) {
+                inside = false;
+                break;
+            }
+        }
+        if (!inside) {
+            instance_keys_[i] = CULLED;
+            continue;
+        }
+
+        float distance = glm::length(instance.center - eye);
+        int lod = choose_lod(meshes_[instance.mesh], instance.radius, distance);
+        uint32_t key = instance.mesh * MAX_LODS + lod;
+        instance_keys_[i] = key;
+        ++bucket_offsets_[key + 1];
+    }
+
+    for (size_t b = 1; b <= bucket_count; ++b) {
+        bucket_offsets_[b] += bucket_offsets_[b - 1];
+    }
+    stats_.visible = bucket_offsets_[bucket_count];
+
+    instance_data_.resize(stats_.visible);
+    std::vector<uint32_t> cursor(bucket_offsets_.begin(), bucket_offsets_.end() - 1);
+    for (size_t i = 0; i < instances_.size(); ++i) {
+        uint32_t key = instance_keys_[i];
+        if (key == CULLED) continue;
+        instance_data_[cursor[key]++] = instances_[i].transform;
+    }
+    if (stats_.visible == 0) return;
+
+    instance_buffer_.upload(instance_data_.data(), instance_data_.size() * sizeof(glm::mat4));
+
+    shader_->use();
+    shader_->set_mat4("view", view);
+    shader_->set_mat4("projection", projection);
+    shader_->set_vec3("lightDir", glm::normalize(glm::vec3(0.5f, -1.0f, 0.3f)));
+    shader_->set_vec3("lightColor", glm::vec3(1.0f));
+    shader_->set_vec3("objectColor", glm::vec3(0.8f, 0.8f, 0.85f));
+    shader_->set_bool("useTexture", false);
+
+    glBindVertexArray(vao_);
+    if (wireframe_) {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+
+    for (size_t key = 0; key < bucket_count; ++key) {
+        uint32_t first = bucket_offsets_[key];
+        uint32_t count = bucket_offsets_[key + 1] - first;
+        if (count == 0) continue;
+
+        const auto& lod = meshes_[key / MAX_LODS].lods[key % MAX_LODS];
+        point_instance_attributes(first);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES,
+                                          static_cast<GLsizei>(lod.index_count),
+                                          GL_UNSIGNED_INT,
+                                          reinterpret_cast<void*>(lod.first_index * sizeof(uint32_t)),
+                                          static_cast<GLsizei>(count),
+                                          lod.base_vertex);
+        ++stats_.draw_calls;
+        stats_.triangles += static_cast<size_t>(lod.index_count / 3) * count;
+    }
+
+    if (wireframe_) {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+    glBindVertexArray(0);
+}
+
+} // namespace enfusion
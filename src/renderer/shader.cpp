@@ -179,6 +179,30 @@ void main() {
 }
 )";
 
+const char* Shader::INSTANCED_VERTEX_SHADER = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aModel;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    vec4 world = aModel * vec4(aPos, 1.0);
+    FragPos = world.xyz;
+    // Scene instances are uniformly scaled, so the model matrix works for normals
+    Normal = mat3(aModel) * aNormal;
+    TexCoord = aTexCoord;
+    gl_Position = projection * view * world;
+}
+)";
+
 const char* Shader::MESH_FRAGMENT_SHADER = R"(
 #version 330 core
 out vec4 FragColor;
@@ -0,0 +1,232 @@
+/**
+ * Enfusion Unpacker - Asynchronous texture upload implementation
+ */
+
+#include "renderer/texture_uploader.hpp"
+#include "enfusion/logging.hpp"
+#include "enfusion/trace.hpp"
+#include <glad/glad.h>
+#include <cstring>
+#include <utility>
+
+namespace enfusion {
+
+TextureUploader::~TextureUploader() {
+    cleanup();
+}
+
+TextureUploader::Ticket TextureUploader::enqueue(TextureData texture) {
+    account_.add(texture.pixels.capacity());
+    std::lock_guard lock(mutex_);
+    Ticket ticket = next_ticket_++;
+    pending_.push_back({ticket, std::move(texture)});
+    return ticket;
+}
+
+void TextureUploader::pump() {
+    for (auto& slot : ring_) {
+        if (slot.state == SlotState::Filling &&
+            slot.fill.ready()) {
+            finish_fill(slot);
+        }
+
+        if (slot.state == SlotState::Fenced) {
+            GLsync fence = static_cast<GLsync>(slot.fence);
+            GLenum status = glClientWaitSync(fence, 0, 0);
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+                release_slot(slot);
+            }
+        }
+    }
+
+    // Hand queued textures to free slots
+    for (auto& slot : ring_) {
+        if (slot.state != SlotState::Free) continue;
+
+        Pending pending;
+        {
+            std::lock_guard lock(mutex_);
+            if (pending_.empty()) break;
+            pending = std::move(pending_.front());
+            pending_.pop_front();
+        }
+
+        size_t held = pending.texture.pixels.capacity();
+        bool started = start_fill(slot, pending);
+        if (started && slot.fill.valid()) {
+            slot.staged_bytes = held;
+        } else {
+            account_.sub(held);
+        }
+
+        if (started && !slot.fill.valid()) {
+            // Copied inline, so the upload can go out this frame
+            finish_fill(slot);
+        }
+    }
+}
+
+bool TextureUploader::start_fill(Slot& slot, Pending& pending) {
+    const TextureData& texture = pending.texture;
+    size_t bytes = static_cast<size_t>(texture.width) * texture.height * texture.channels;
+    if (bytes == 0 || texture.pixels.size() < bytes) {
+        LOG_WARN("TextureUploader", "Skipping texture with no pixel data");
+        finished_.push_back({pending.ticket, 0, texture.width, texture.height, true});
+        return false;
+    }
+
+    if (slot.pbo == 0) {
+        glGenBuffers(1, &slot.pbo);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+    if (bytes > slot.capacity) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_DRAW);
+        slot.capacity = bytes;
+    }
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!mapped) {
+        LOG_WARN("TextureUploader", "Failed to map staging buffer (" << bytes << " bytes)");
+        finished_.push_back({pending.ticket, 0, texture.width, texture.height, true});
+        return false;
+    }
+
+    slot.state = SlotState::Filling;
+    slot.ticket = pending.ticket;
+    slot.width = texture.width;
+    slot.height = texture.height;
+    slot.channels = texture.channels;
+    slot.discarded = false;
+
+    if (bytes <= INLINE_COPY_LIMIT) {
+        TRACE_SPAN(span, "gl.fill_pbo");
+        TRACE_ARG(span, "bytes", bytes);
+        std::memcpy(mapped, texture.pixels.data(), bytes);
+        slot.fill = {};
+    } else {
+        slot.fill = TaskScheduler::instance().async(TaskPriority::Interactive,
+            [mapped, bytes, pixels = std::move(pending.texture.pixels)]() {
+                TRACE_SPAN(span, "gl.fill_pbo");
+                TRACE_ARG(span, "bytes", bytes);
+                std::memcpy(mapped, pixels.data(), bytes);
+            });
+    }
+    return true;
+}
+
+void TextureUploader::finish_fill(Slot& slot) {
+    if (slot.fill.valid()) {
+        slot.fill.get();
+    }
+    account_.sub(std::exchange(slot.staged_bytes, 0));
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    if (slot.discarded) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        release_slot(slot);
+        return;
+    }
+
+    TRACE_SPAN(span, "gl.upload_texture");
+    TRACE_ARG(span, "width", slot.width);
+    TRACE_ARG(span, "height", slot.height);
+
+    uint32_t texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // Source is the bound PBO, so this returns as soon as the transfer is queued
+    GLenum format = (slot.channels == 4) ? GL_RGBA : GL_RGB;
+    GLint internal = (slot.channels == 4) ? GL_RGBA8 : GL_RGB8;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal, slot.width, slot.height, 0, format,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.state = SlotState::Fenced;
+    finished_.push_back({slot.ticket, texture, slot.width, slot.height});
+}
+
+void TextureUploader::release_slot(Slot& slot) {
+    if (slot.fence) {
+        glDeleteSync(static_cast<GLsync>(slot.fence));
+        slot.fence = nullptr;
+    }
+
+    // Don't sit on staging memory sized for one huge texture
+    if (slot.capacity > KEEP_CAPACITY) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        slot.capacity = 0;
+    }
+
+    slot.state = SlotState::Free;
+    slot.ticket = 0;
+    slot.discarded = false;
+}
+
+std::vector<TextureUploader::Finished> TextureUploader::take_finished() {
+    return std::exchange(finished_, {});
+}
+
+void TextureUploader::discard() {
+    {
+        std::lock_guard lock(mutex_);
+        for (const auto& pending : pending_) {
+            account_.sub(pending.texture.pixels.capacity());
+        }
+        pending_.clear();
+    }
+    for (auto& slot : ring_) {
+        if (slot.state == SlotState::Filling) {
+            slot.discarded = true;
+        }
+    }
+    for (const auto& finished : finished_) {
+        glDeleteTextures(1, &finished.texture);
+    }
+    finished_.clear();
+}
+
+void TextureUploader::cleanup() {
+    discard();
+    for (auto& slot : ring_) {
+        if (slot.state == SlotState::Filling) {
+            finish_fill(slot);
+        }
+        if (slot.state == SlotState::Fenced) {
+            release_slot(slot);
+        }
+        if (slot.pbo != 0) {
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+            slot.capacity = 0;
+        }
+    }
+}
+
+bool TextureUploader::is_busy() const {
+    {
+        std::lock_guard lock(mutex_);
+        if (!pending_.empty()) return true;
+    }
+    for (const auto& slot : ring_) {
+        if (slot.state == SlotState::Filling) return true;
+    }
+    return !finished_.empty();
+}
+
+} // namespace enfusion
@@ -0,0 +1,56 @@
+/**
+ * Enfusion Unpacker - Scratch arena implementation
+ */
+
+#include "enfusion/arena.hpp"
+#include <algorithm>
+#include <new>
+
+namespace enfusion {
+
+void* ScratchArena::CountingResource::do_allocate(size_t bytes, size_t align) {
+    allocated_ += bytes;
+    return ::operator new(bytes, std::align_val_t(align));
+}
+
+void ScratchArena::CountingResource::do_deallocate(void* p, size_t bytes, size_t align) {
+    ::operator delete(p, bytes, std::align_val_t(align));
+}
+
+ScratchArena& ScratchArena::current() {
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+ScratchArena::ScratchArena()
+    : buffer_(new std::byte[INITIAL_CAPACITY])
+    , capacity_(INITIAL_CAPACITY) {
+    rebuild();
+}
+
+ScratchArena::~ScratchArena() {
+    monotonic_.reset();
+}
+
+void ScratchArena::reset() {
+    size_t overflow = upstream_.allocated();
+
+    // Drop the monotonic resource first: it hands spilled chunks back upstream
+    monotonic_.reset();
+
+    // Grow the backing block so the next asset of this size fits without spilling
+    if (overflow > 0 && capacity_ < MAX_CAPACITY) {
+        size_t wanted = std::min(MAX_CAPACITY, capacity_ + overflow);
+        buffer_.reset(new std::byte[wanted]);
+        capacity_ = wanted;
+    }
+
+    rebuild();
+}
+
+void ScratchArena::rebuild() {
+    upstream_.clear();
+    monotonic_.emplace(buffer_.get(), capacity_, &upstream_);
+}
+
+} // namespace enfusion
@@ -3,64 +3,133 @@
  */
 
 #include "enfusion/compression.hpp"
+#include "enfusion/trace.hpp"
 #include <zlib.h>
 #include <lz4.h>
-#include <stdexcept>
+#include <array>
 
 namespace enfusion {
 
-std::vector<uint8_t> decompress_zlib(const uint8_t* data, size_t size, size_t expected_size) {
-    std::vector<uint8_t> result(expected_size);
-    
+// Inflate into a caller-provided buffer of expected_size bytes, returns bytes written
+static Result<size_t> inflate_into(const uint8_t* data, size_t size, uint8_t* out, size_t expected_size) {
+    TRACE_SPAN(span, "zlib.inflate");
+    TRACE_ARG(span, "compressed", size);
+    TRACE_ARG(span, "bytes", expected_size);
+
     z_stream strm = {};
     strm.next_in = const_cast<Bytef*>(data);
     strm.avail_in = static_cast<uInt>(size);
-    strm.next_out = result.data();
+    strm.next_out = out;
     strm.avail_out = static_cast<uInt>(expected_size);
     
     int ret = inflateInit(&strm);
     if (ret != Z_OK) {
-        throw std::runtime_error("Failed to initialize zlib decompression");
+        return Error::compression_error("Failed to initialize zlib decompression");
     }
     
     ret = inflate(&strm, Z_FINISH);
     inflateEnd(&strm);
     
     if (ret != Z_STREAM_END) {
-        throw std::runtime_error("Zlib decompression failed");
+        return Error::compression_error("Zlib decompression failed");
     }
     
-    result.resize(strm.total_out);
+    return static_cast<size_t>(strm.total_out);
+}
+
+Result<std::vector<uint8_t>> decompress_zlib(const uint8_t* data, size_t size, size_t expected_size) {
+    std::vector<uint8_t> result(expected_size);
+    auto written = inflate_into(data, size, result.data(), expected_size);
+    if (!written) return written.error();
+    result.resize(*written);
     return result;
 }
 
-std::vector<uint8_t> decompress_zlib(const std::vector<uint8_t>& data, size_t expected_size) {
+Result<std::vector<uint8_t>> decompress_zlib(const std::vector<uint8_t>& data, size_t expected_size) {
     return decompress_zlib(data.data(), data.size(), expected_size);
 }
 
-std::vector<uint8_t> decompress_lz4(const uint8_t* data, size_t size, size_t expected_size) {
-    std::vector<uint8_t> result(expected_size);
+Result<std::pmr::vector<uint8_t>> decompress_zlib(const uint8_t* data, size_t size, size_t expected_size,
+                                                  std::pmr::memory_resource* resource) {
+    std::pmr::vector<uint8_t> result(expected_size, resource);
+    auto written = inflate_into(data, size, result.data(), expected_size);
+    if (!written) return written.error();
+    result.resize(*written);
+    return result;
+}
+
+Result<size_t> measure_zlib(const uint8_t* data, size_t size, size_t max_size) {
+    z_stream strm = {};
+    strm.next_in = const_cast<Bytef*>(data);
+    strm.avail_in = static_cast<uInt>(size);
+    
+    if (inflateInit(&strm) != Z_OK) {
+        return Error::compression_error("Failed to initialize zlib decompression");
+    }
+    
+    // Inflate through a fixed window; only the byte count matters
+    std::array<uint8_t, 32768> window;
+    int ret = Z_OK;
+    while (ret == Z_OK) {
+        strm.next_out = window.data();
+        strm.avail_out = static_cast<uInt>(window.size());
+        ret = inflate(&strm, Z_NO_FLUSH);
+        if (strm.total_out > max_size) {
+            ret = Z_BUF_ERROR;
+        }
+    }
+    
+    size_t total = strm.total_out;
+    inflateEnd(&strm);
     
+    if (ret != Z_STREAM_END) {
+        return Error::compression_error("Zlib decompression failed");
+    }
+    
+    return total;
+}
+
+static Result<size_t> lz4_into(const uint8_t* data, size_t size, uint8_t* out, size_t expected_size) {
+    TRACE_SPAN(span, "lz4.decompress");
+    TRACE_ARG(span, "compressed", size);
+    TRACE_ARG(span, "bytes", expected_size);
+
     int decompressed_size = LZ4_decompress_safe(
         reinterpret_cast<const char*>(data),
-        reinterpret_cast<char*>(result.data()),
+        reinterpret_cast<char*>(out),
         static_cast<int>(size),
         static_cast<int>(expected_size)
     );
     
     if (decompressed_size < 0) {
-        throw std::runtime_error("LZ4 decompression failed");
+        return Error::compression_error("LZ4 decompression failed");
     }
     
-    result.resize(static_cast<size_t>(decompressed_size));
+    return static_cast<size_t>(decompressed_size);
+}
+
+Result<std::vector<uint8_t>> decompress_lz4(const uint8_t* data, size_t size, size_t expected_size) {
+    std::vector<uint8_t> result(expected_size);
+    auto written = lz4_into(data, size, result.data(), expected_size);
+    if (!written) return written.error();
+    result.resize(*written);
     return result;
 }
 
-std::vector<uint8_t> decompress_lz4(const std::vector<uint8_t>& data, size_t expected_size) {
+Result<std::vector<uint8_t>> decompress_lz4(const std::vector<uint8_t>& data, size_t expected_size) {
     return decompress_lz4(data.data(), data.size(), expected_size);
 }
 
-std::vector<uint8_t> decompress_auto(const uint8_t* data, size_t size, size_t expected_size, CompressionType type) {
+Result<std::pmr::vector<uint8_t>> decompress_lz4(const uint8_t* data, size_t size, size_t expected_size,
+                                                 std::pmr::memory_resource* resource) {
+    std::pmr::vector<uint8_t> result(expected_size, resource);
+    auto written = lz4_into(data, size, result.data(), expected_size);
+    if (!written) return written.error();
+    result.resize(*written);
+    return result;
+}
+
+Result<std::vector<uint8_t>> decompress_auto(const uint8_t* data, size_t size, size_t expected_size, CompressionType type) {
     switch (type) {
         case CompressionType::None:
             return std::vector<uint8_t>(data, data + size);
@@ -72,7 +141,7 @@ std::vector<uint8_t> decompress_auto(const uint8_t* data, size_t size, size_t ex
             return decompress_lz4(data, size, expected_size);
             
         default:
-            throw std::runtime_error("Unknown compression type");
+            return Error::compression_error("Unknown compression type");
     }
 }
 
@@ -94,7 +163,7 @@ CompressionType detect_compression(const uint8_t* data, size_t size) {
     return CompressionType::None;
 }
 
-std::vector<uint8_t> compress_zlib(const uint8_t* data, size_t size, int level) {
+Result<std::vector<uint8_t>> compress_zlib(const uint8_t* data, size_t size, int level) {
     uLongf bound = compressBound(static_cast<uLong>(size));
     std::vector<uint8_t> result(bound);
     
@@ -105,14 +174,18 @@ std::vector<uint8_t> compress_zlib(const uint8_t* data, size_t size, int level)
     );
     
     if (ret != Z_OK) {
-        throw std::runtime_error("Zlib compression failed");
+        return Error::compression_error("Zlib compression failed");
     }
     
     result.resize(bound);
     return result;
 }
 
-std::vector<uint8_t> compress_lz4(const uint8_t* data, size_t size) {
+Result<std::vector<uint8_t>> compress_zlib(const std::vector<uint8_t>& data, int level) {
+    return compress_zlib(data.data(), data.size(), level);
+}
+
+Result<std::vector<uint8_t>> compress_lz4(const uint8_t* data, size_t size) {
     int bound = LZ4_compressBound(static_cast<int>(size));
     std::vector<uint8_t> result(static_cast<size_t>(bound));
     
@@ -124,11 +197,15 @@ std::vector<uint8_t> compress_lz4(const uint8_t* data, size_t size) {
     );
     
     if (compressed_size <= 0) {
-        throw std::runtime_error("LZ4 compression failed");
+        return Error::compression_error("LZ4 compression failed");
     }
     
     result.resize(static_cast<size_t>(compressed_size));
     return result;
 }
 
+Result<std::vector<uint8_t>> compress_lz4(const std::vector<uint8_t>& data) {
+    return compress_lz4(data.data(), data.size());
+}
+
 } // namespace enfusion
@@ -6,6 +6,16 @@
 #include <fstream>
 #include <algorithm>
 #include <cctype>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace enfusion {
 
@@ -22,6 +32,127 @@ std::vector<uint8_t> read_file(const std::filesystem::path& path) {
     return data;
 }
 
+std::vector<uint8_t> read_file(const std::filesystem::path& path, const std::atomic<bool>& cancel) {
+    constexpr size_t CHUNK_SIZE = 16 * 1024 * 1024;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return {};
+    
+    file.seekg(0, std::ios::end);
+    size_t size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    
+    std::vector<uint8_t> data(size);
+    for (size_t offset = 0; offset < size; offset += CHUNK_SIZE) {
+        if (cancel.load(std::memory_order_relaxed)) return {};
+        size_t count = std::min(CHUNK_SIZE, size - offset);
+        if (!file.read(reinterpret_cast<char*>(data.data() + offset), count)) return {};
+    }
+    return data;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+        mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The mapping keeps the file open; the handle isn't needed past this point
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return false;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(size.QuadPart);
+    mapping_ = mapping;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    data_ = nullptr;
+    size_ = 0;
+    mapping_ = nullptr;
+}
+
+void MappedFile::will_need() const {
+    if (!data_) return;
+    WIN32_MEMORY_RANGE_ENTRY range{const_cast<uint8_t*>(data_), size_};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping keeps its own reference to the file
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::will_need() const {
+    if (data_) madvise(const_cast<uint8_t*>(data_), size_, MADV_WILLNEED);
+}
+
+#endif
+
 bool write_file(const std::filesystem::path& path, const uint8_t* data, size_t size) {
     std::filesystem::create_directories(path.parent_path());
     std::ofstream file(path, std::ios::binary);
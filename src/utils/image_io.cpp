@@ -0,0 +1,64 @@
+/**
+ * Enfusion Unpacker - Image I/O Implementation
+ */
+
+#include "enfusion/image_io.hpp"
+#include "enfusion/files.hpp"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#include <stb_image.h>
+
+namespace enfusion {
+
+std::vector<uint8_t> encode_png(const TextureData& image) {
+    if (image.width == 0 || image.height == 0 ||
+        image.pixels.size() < static_cast<size_t>(image.width) * image.height * 4) {
+        return {};
+    }
+
+    std::vector<uint8_t> out;
+    auto append = [](void* context, void* data, int size) {
+        auto* buffer = static_cast<std::vector<uint8_t>*>(context);
+        auto* bytes = static_cast<const uint8_t*>(data);
+        buffer->insert(buffer->end(), bytes, bytes + size);
+    };
+    int ok = stbi_write_png_to_func(append, &out, static_cast<int>(image.width), static_cast<int>(image.height),
+                                    4, image.pixels.data(), static_cast<int>(image.width * 4));
+    if (!ok) return {};
+    return out;
+}
+
+std::optional<TextureData> decode_png(std::span<const uint8_t> data) {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    stbi_uc* pixels = stbi_load_from_memory(data.data(), static_cast<int>(data.size()),
+                                            &width, &height, &channels, 4);
+    if (!pixels) return std::nullopt;
+
+    TextureData image;
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.channels = 4;
+    image.format = "RGBA8";
+    image.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+    return image;
+}
+
+bool write_png(const std::filesystem::path& path, const TextureData& image) {
+    auto png = encode_png(image);
+    return !png.empty() && write_file(path, png);
+}
+
+std::optional<TextureData> read_png(const std::filesystem::path& path) {
+    auto data = read_file(path);
+    if (data.empty()) return std::nullopt;
+    return decode_png(data);
+}
+
+} // namespace enfusion
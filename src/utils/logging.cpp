@@ -0,0 +1,278 @@
+/**
+ * Enfusion Unpacker - Logging Implementation
+ */
+
+#include "enfusion/logging.hpp"
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+namespace enfusion {
+
+namespace {
+
+std::tm local_time(std::time_t time) {
+    std::tm tm_buf{};
+#ifdef _WIN32
+    localtime_s(&tm_buf, &time);
+#else
+    localtime_r(&time, &tm_buf);
+#endif
+    return tm_buf;
+}
+
+} // namespace
+
+// ============================================================================
+// LogRing
+// ============================================================================
+
+LogRing::LogRing(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+
+    slots_ = std::make_unique<Slot[]>(size);
+    mask_ = size - 1;
+    for (size_t i = 0; i < size; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool LogRing::push(LogRecord&& record) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &slots_[pos & mask_];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            // Slot is free for this lap; claim it
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // Consumer hasn't freed it yet: the queue is full
+            return false;
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->record = std::move(record);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRing::pop(LogRecord& out) {
+    Slot& slot = slots_[head_ & mask_];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != head_ + 1) return false;  // Not published yet
+
+    out = std::move(slot.record);
+    // Hand the slot back to producers for the next lap
+    slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+    head_++;
+    return true;
+}
+
+// ============================================================================
+// Logger
+// ============================================================================
+
+Logger::Logger()
+    : callback_window_(std::chrono::steady_clock::now()) {
+    // Auto-open log file
+    file_.open("enfusion_unpacker.log", std::ios::out | std::ios::trunc);
+    if (file_.is_open()) {
+        std::tm tm_buf = local_time(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+        file_ << "=== Enfusion Unpacker Log - "
+              << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S") << " ===\n\n";
+        file_.flush();
+    }
+
+    running_ = true;
+    thread_ = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+    shutdown();
+}
+
+bool Logger::set_file(const std::filesystem::path& path) {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+
+    if (file_.is_open()) {
+        file_.close();
+    }
+
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    file_.open(path, std::ios::app);
+    return file_.is_open();
+}
+
+void Logger::close_file() {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+void Logger::set_callback(Callback callback) {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    callback_ = std::move(callback);
+}
+
+void Logger::write(LogLevel level, std::string_view tag, std::string message) {
+    if (!running_.load(std::memory_order_relaxed)) return;
+
+    LogRecord record;
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+    record.tag = tag;
+    record.message = std::move(message);
+
+    // Debug/info bursts that overflow the queue are counted rather than waited
+    // for; warnings and errors wait for the logging thread to make room
+    while (!queue_.push(std::move(record))) {
+        if (level < LogLevel::Warning || !running_.load(std::memory_order_relaxed)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            dropped_total_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::this_thread::yield();
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+}
+
+void Logger::write_line(std::string line) {
+    if (!is_enabled(LogLevel::Info)) return;
+    write(LogLevel::Info, {}, std::move(line));
+}
+
+void Logger::flush() {
+    uint64_t target = queued_.load(std::memory_order_acquire);
+    while (running_.load(std::memory_order_acquire) && written_.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void Logger::shutdown() {
+    if (!running_.exchange(false)) return;
+
+    // run() writes out whatever is still queued before returning
+    thread_.join();
+
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    if (file_.is_open()) {
+        file_ << "\n=== Log End ===\n";
+        file_.close();
+    }
+}
+
+void Logger::run() {
+    while (running_.load(std::memory_order_acquire)) {
+        // Sleeping when idle lets messages pile up into one write
+        if (drain() == 0) {
+            std::this_thread::sleep_for(IDLE_INTERVAL);
+        }
+    }
+    while (drain() > 0) {}
+}
+
+size_t Logger::drain() {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    roll_callback_window();
+
+    batch_.clear();
+    size_t count = 0;
+    LogRecord record;
+    while (count < MAX_BATCH && queue_.pop(record)) {
+        size_t start = batch_.size();
+        append_line(record, batch_);
+        deliver(record, std::string_view(batch_).substr(start, batch_.size() - start - 1));
+        count++;
+    }
+
+    uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        LogRecord note;
+        note.level = LogLevel::Warning;
+        note.time = std::chrono::system_clock::now();
+        note.tag = "Log";
+        note.message = std::to_string(dropped) + " messages dropped, queue was full";
+        append_line(note, batch_);
+    }
+
+    if (!batch_.empty()) {
+        if (console_enabled_.load(std::memory_order_relaxed)) {
+            std::cout.write(batch_.data(), static_cast<std::streamsize>(batch_.size()));
+            std::cout.flush();
+        }
+        if (file_.is_open()) {
+            // One write and flush per batch rather than per line
+            file_.write(batch_.data(), static_cast<std::streamsize>(batch_.size()));
+            file_.flush();
+        }
+    }
+
+    written_.fetch_add(count, std::memory_order_release);
+    return count;
+}
+
+void Logger::append_line(const LogRecord& record, std::string& out) {
+    // Most lines in a batch share a second, so the calendar conversion is cached
+    std::time_t time = std::chrono::system_clock::to_time_t(record.time);
+    if (time != stamp_second_) {
+        std::tm tm_buf = local_time(time);
+        std::strftime(stamp_, sizeof(stamp_), "%H:%M:%S", &tm_buf);
+        stamp_second_ = time;
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        record.time.time_since_epoch()).count() % 1000;
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03d ", static_cast<int>(ms));
+
+    out += stamp_;
+    out += millis;
+
+    // Raw std::cerr lines already carry their own "[Tag]" prefix
+    if (!record.tag.empty()) {
+        out += '[';
+        out += log_level_string(record.level);
+        out += "] [";
+        out += record.tag;
+        out += "] ";
+    }
+
+    out += record.message;
+    if (out.back() != '\n') out += '\n';
+}
+
+void Logger::deliver(const LogRecord& record, std::string_view line) {
+    if (!callback_) return;
+
+    if (callback_count_ >= CALLBACK_BURST) {
+        callback_suppressed_++;
+        return;
+    }
+
+    callback_count_++;
+    callback_(record.level, std::string(line));
+}
+
+void Logger::roll_callback_window() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - callback_window_ < CALLBACK_INTERVAL) return;
+
+    if (callback_suppressed_ > 0 && callback_) {
+        callback_(LogLevel::Warning, std::to_string(callback_suppressed_) + " log lines not shown");
+    }
+
+    callback_window_ = now;
+    callback_count_ = 0;
+    callback_suppressed_ = 0;
+}
+
+} // namespace enfusion
@@ -0,0 +1,231 @@
+/**
+ * Enfusion Unpacker - Memory Accounting Implementation
+ */
+
+#include "enfusion/memory.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace enfusion {
+namespace memory {
+
+namespace {
+
+// Eviction frees memory on the UI thread; a few times a second is enough
+constexpr int64_t ENFORCE_INTERVAL_MS = 250;
+
+size_t index_of(Subsystem subsystem) {
+    return static_cast<size_t>(subsystem);
+}
+
+} // namespace
+
+const char* subsystem_name(Subsystem subsystem) {
+    switch (subsystem) {
+        case Subsystem::PakData:   return "PAK data";
+        case Subsystem::FileLists: return "File lists";
+        case Subsystem::Textures:  return "Textures (CPU)";
+        case Subsystem::Meshes:    return "Meshes (CPU)";
+        case Subsystem::Index:     return "SQLite index";
+        default:                   return "Unknown";
+    }
+}
+
+const char* subsystem_key(Subsystem subsystem) {
+    switch (subsystem) {
+        case Subsystem::PakData:   return "pak_data";
+        case Subsystem::FileLists: return "file_lists";
+        case Subsystem::Textures:  return "textures";
+        case Subsystem::Meshes:    return "meshes";
+        case Subsystem::Index:     return "index";
+        default:                   return "unknown";
+    }
+}
+
+// ============================================================================
+// Account
+// ============================================================================
+
+Account::Account(Subsystem subsystem, std::string label)
+    : subsystem_(subsystem), label_(std::move(label)) {
+    Registry::instance().attach(this);
+}
+
+Account::~Account() {
+    set(0);
+    Registry::instance().detach(this);
+}
+
+void Account::set(size_t bytes) {
+    size_t old_bytes = bytes_.exchange(bytes, std::memory_order_relaxed);
+    if (old_bytes != bytes) {
+        Registry::instance().charge(subsystem_, old_bytes, bytes);
+    }
+}
+
+void Account::add(size_t bytes) {
+    if (bytes == 0) return;
+    size_t old_bytes = bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    Registry::instance().charge(subsystem_, old_bytes, old_bytes + bytes);
+}
+
+void Account::sub(size_t bytes) {
+    if (bytes == 0) return;
+    size_t old_bytes = bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    Registry::instance().charge(subsystem_, old_bytes, old_bytes - bytes);
+}
+
+std::string Account::label() const {
+    std::lock_guard<std::mutex> lock(label_mutex_);
+    return label_;
+}
+
+void Account::set_label(std::string label) {
+    std::lock_guard<std::mutex> lock(label_mutex_);
+    label_ = std::move(label);
+}
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+Registry& Registry::instance() {
+    static Registry instance;
+    return instance;
+}
+
+void Registry::attach(Account* account) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    accounts_.push_back(account);
+}
+
+void Registry::detach(Account* account) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::erase(accounts_, account);
+}
+
+void Registry::charge(Subsystem subsystem, size_t old_bytes, size_t new_bytes) {
+    auto& usage = usage_[index_of(subsystem)];
+    size_t now;
+    if (new_bytes > old_bytes) {
+        now = usage.fetch_add(new_bytes - old_bytes, std::memory_order_relaxed) + (new_bytes - old_bytes);
+    } else {
+        now = usage.fetch_sub(old_bytes - new_bytes, std::memory_order_relaxed) - (old_bytes - new_bytes);
+    }
+
+    auto& peak = peak_[index_of(subsystem)];
+    size_t current = peak.load(std::memory_order_relaxed);
+    while (now > current && !peak.compare_exchange_weak(current, now, std::memory_order_relaxed)) {}
+}
+
+size_t Registry::probe_bytes(Subsystem subsystem) const {
+    Probe probe;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        probe = probes_[index_of(subsystem)];
+    }
+    return probe ? probe() : 0;
+}
+
+size_t Registry::usage(Subsystem subsystem) const {
+    return usage_[index_of(subsystem)].load(std::memory_order_relaxed) + probe_bytes(subsystem);
+}
+
+size_t Registry::total() const {
+    size_t sum = 0;
+    for (size_t i = 0; i < SUBSYSTEM_COUNT; i++) {
+        sum += usage(static_cast<Subsystem>(i));
+    }
+    return sum;
+}
+
+size_t Registry::budget(Subsystem subsystem) const {
+    return budget_[index_of(subsystem)].load(std::memory_order_relaxed);
+}
+
+void Registry::set_budget(Subsystem subsystem, size_t bytes) {
+    budget_[index_of(subsystem)].store(bytes, std::memory_order_relaxed);
+
+    // Apply a lowered budget on the next enforce() rather than waiting out the interval
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_enforce_ms_ = 0;
+}
+
+bool Registry::over_budget(Subsystem subsystem) const {
+    size_t limit = budget(subsystem);
+    return limit != 0 && usage(subsystem) > limit;
+}
+
+void Registry::set_probe(Subsystem subsystem, Probe probe) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    probes_[index_of(subsystem)] = std::move(probe);
+}
+
+uint64_t Registry::add_enforcer(Subsystem subsystem, Enforcer enforcer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t id = next_enforcer_id_++;
+    enforcers_.push_back({id, subsystem, std::move(enforcer)});
+    return id;
+}
+
+void Registry::remove_enforcer(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::erase_if(enforcers_, [id](const EnforcerEntry& e) { return e.id == id; });
+}
+
+void Registry::enforce() {
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    std::vector<EnforcerEntry> enforcers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (now_ms - last_enforce_ms_ < ENFORCE_INTERVAL_MS) return;
+        last_enforce_ms_ = now_ms;
+        enforcers = enforcers_;
+    }
+
+    // Enforcers free memory by destroying objects, which detaches their
+    // accounts, so none of them run under the registry lock
+    for (const auto& entry : enforcers) {
+        size_t limit = budget(entry.subsystem);
+        if (limit == 0) continue;
+
+        size_t used = usage(entry.subsystem);
+        if (used > limit) {
+            entry.enforcer(used, limit);
+        }
+    }
+}
+
+std::vector<SubsystemUsage> Registry::snapshot(size_t max_objects) const {
+    std::vector<SubsystemUsage> result(SUBSYSTEM_COUNT);
+    for (size_t i = 0; i < SUBSYSTEM_COUNT; i++) {
+        auto subsystem = static_cast<Subsystem>(i);
+        result[i].subsystem = subsystem;
+        result[i].bytes = usage(subsystem);
+        result[i].peak = std::max(peak_[i].load(std::memory_order_relaxed), result[i].bytes);
+        result[i].budget = budget(subsystem);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Account* account : accounts_) {
+            size_t bytes = account->bytes();
+            if (bytes == 0) continue;
+            result[index_of(account->subsystem())].objects.push_back({account->label(), bytes});
+        }
+    }
+
+    for (auto& entry : result) {
+        auto& objects = entry.objects;
+        std::sort(objects.begin(), objects.end(), [](const ObjectUsage& a, const ObjectUsage& b) {
+            return a.bytes > b.bytes;
+        });
+        if (objects.size() > max_objects) objects.resize(max_objects);
+    }
+    return result;
+}
+
+} // namespace memory
+} // namespace enfusion
@@ -0,0 +1,203 @@
+/**
+ * Enfusion Unpacker - Mesh Rasterizer Implementation
+ */
+
+#include "enfusion/mesh_rasterizer.hpp"
+#include "enfusion/trace.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+namespace enfusion {
+
+namespace {
+
+struct ScreenVertex {
+    float x;
+    float y;
+    float z;  // Distance along the view direction; smaller is nearer
+};
+
+float edge(const ScreenVertex& a, const ScreenVertex& b, float x, float y) {
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+uint8_t to_byte(float value) {
+    return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+} // namespace
+
+TextureData rasterize_mesh(std::span<const XobVertex> vertices, std::span<const uint32_t> indices,
+                           const RasterOptions& options) {
+    TRACE_SPAN(span, "thumbnail.rasterize");
+    TRACE_ARG(span, "triangles", indices.size() / 3);
+
+    const uint32_t size = std::max(options.size, 1u);
+    const uint32_t ss = std::clamp(options.supersample, 1u, 4u);
+    const uint32_t width = size * ss;
+
+    // Frame the referenced vertices only; the buffer may hold other LODs too
+    glm::vec3 bounds_min(FLT_MAX);
+    glm::vec3 bounds_max(-FLT_MAX);
+    size_t triangles = 0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        if (indices[i] >= vertices.size() || indices[i + 1] >= vertices.size() ||
+            indices[i + 2] >= vertices.size()) {
+            continue;
+        }
+        for (size_t k = 0; k < 3; k++) {
+            bounds_min = glm::min(bounds_min, vertices[indices[i + k]].position);
+            bounds_max = glm::max(bounds_max, vertices[indices[i + k]].position);
+        }
+        triangles++;
+    }
+
+    // Camera basis for the same yaw/pitch orbit the model viewer uses
+    float yaw = glm::radians(options.yaw);
+    float pitch = glm::radians(options.pitch);
+    glm::vec3 eye(std::cos(pitch) * std::sin(yaw), std::sin(pitch), std::cos(pitch) * std::cos(yaw));
+    glm::vec3 forward = -eye;
+    glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+    glm::vec3 up = glm::cross(right, forward);
+    glm::vec3 light = glm::normalize(eye + up * 0.6f - right * 0.4f);
+
+    // Sample buffers: nearest depth and shaded intensity, -1 = background
+    std::vector<float> depth(static_cast<size_t>(width) * width, FLT_MAX);
+    std::vector<float> shade(static_cast<size_t>(width) * width, -1.0f);
+
+    if (triangles > 0) {
+        glm::vec3 center = (bounds_min + bounds_max) * 0.5f;
+
+        // Orthographic projection of every axis, so the bounding box itself decides the fit
+        float extent_x = 0.0f;
+        float extent_y = 0.0f;
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec3 p((corner & 1) ? bounds_max.x : bounds_min.x,
+                        (corner & 2) ? bounds_max.y : bounds_min.y,
+                        (corner & 4) ? bounds_max.z : bounds_min.z);
+            extent_x = std::max(extent_x, std::abs(glm::dot(p - center, right)));
+            extent_y = std::max(extent_y, std::abs(glm::dot(p - center, up)));
+        }
+        float extent = std::max(std::max(extent_x, extent_y), 1e-4f);
+        float scale = static_cast<float>(width) * 0.5f / (extent * 1.05f);
+        float half = static_cast<float>(width) * 0.5f;
+
+        auto project = [&](const glm::vec3& position) {
+            glm::vec3 d = position - center;
+            return ScreenVertex{half + glm::dot(d, right) * scale, half - glm::dot(d, up) * scale,
+                                glm::dot(d, forward)};
+        };
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            uint32_t ia = indices[i];
+            uint32_t ib = indices[i + 1];
+            uint32_t ic = indices[i + 2];
+            if (ia >= vertices.size() || ib >= vertices.size() || ic >= vertices.size()) continue;
+
+            const glm::vec3& pa = vertices[ia].position;
+            const glm::vec3& pb = vertices[ib].position;
+            const glm::vec3& pc = vertices[ic].position;
+
+            // One normal per face; lit from both sides since winding varies between meshes
+            glm::vec3 normal = glm::cross(pb - pa, pc - pa);
+            float length = glm::length(normal);
+            if (length < 1e-12f) continue;
+            float intensity = 0.3f + 0.7f * std::abs(glm::dot(normal / length, light));
+
+            ScreenVertex a = project(pa);
+            ScreenVertex b = project(pb);
+            ScreenVertex c = project(pc);
+            float area = edge(a, b, c.x, c.y);
+            if (std::abs(area) < 1e-8f) continue;
+            if (area < 0.0f) {
+                std::swap(b, c);
+                area = -area;
+            }
+
+            int x0 = std::max(0, static_cast<int>(std::floor(std::min({a.x, b.x, c.x}))));
+            int y0 = std::max(0, static_cast<int>(std::floor(std::min({a.y, b.y, c.y}))));
+            int x1 = std::min(static_cast<int>(width) - 1, static_cast<int>(std::ceil(std::max({a.x, b.x, c.x}))));
+            int y1 = std::min(static_cast<int>(width) - 1, static_cast<int>(std::ceil(std::max({a.y, b.y, c.y}))));
+            if (x0 > x1 || y0 > y1) continue;
+
+            // Edge functions step linearly, so only the row start is evaluated in full
+            float inv_area = 1.0f / area;
+            float step_x0 = -(c.y - b.y), step_y0 = c.x - b.x;
+            float step_x1 = -(a.y - c.y), step_y1 = a.x - c.x;
+            float step_x2 = -(b.y - a.y), step_y2 = b.x - a.x;
+            float px = static_cast<float>(x0) + 0.5f;
+            float py = static_cast<float>(y0) + 0.5f;
+            float row0 = edge(b, c, px, py);
+            float row1 = edge(c, a, px, py);
+            float row2 = edge(a, b, px, py);
+
+            for (int y = y0; y <= y1; y++) {
+                float w0 = row0;
+                float w1 = row1;
+                float w2 = row2;
+                size_t row = static_cast<size_t>(y) * width;
+                for (int x = x0; x <= x1; x++) {
+                    if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f) {
+                        float z = (w0 * a.z + w1 * b.z + w2 * c.z) * inv_area;
+                        size_t sample = row + static_cast<size_t>(x);
+                        if (z < depth[sample]) {
+                            depth[sample] = z;
+                            shade[sample] = intensity;
+                        }
+                    }
+                    w0 += step_x0;
+                    w1 += step_x1;
+                    w2 += step_x2;
+                }
+                row0 += step_y0;
+                row1 += step_y1;
+                row2 += step_y2;
+            }
+        }
+    }
+
+    // Box-filter the samples down, blending partial coverage over the background
+    TextureData image;
+    image.width = size;
+    image.height = size;
+    image.channels = 4;
+    image.format = "RGBA8";
+    image.pixels.resize(static_cast<size_t>(size) * size * 4);
+
+    const float samples = static_cast<float>(ss * ss);
+    const glm::vec4& bg = options.background;
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            float covered = 0.0f;
+            float lit = 0.0f;
+            for (uint32_t sy = 0; sy < ss; sy++) {
+                const float* line = shade.data() + static_cast<size_t>(y * ss + sy) * width + x * ss;
+                for (uint32_t sx = 0; sx < ss; sx++) {
+                    if (line[sx] < 0.0f) continue;
+                    covered += 1.0f;
+                    lit += line[sx];
+                }
+            }
+
+            float alpha = covered / samples;
+            glm::vec3 surface = covered > 0.0f ? options.color * (lit / covered) : glm::vec3(0.0f);
+            float out_alpha = alpha + bg.w * (1.0f - alpha);
+            glm::vec3 out(0.0f);
+            if (out_alpha > 0.0f) {
+                out = (surface * alpha + glm::vec3(bg) * bg.w * (1.0f - alpha)) / out_alpha;
+            }
+
+            uint8_t* pixel = image.pixels.data() + (static_cast<size_t>(y) * size + x) * 4;
+            pixel[0] = to_byte(out.x);
+            pixel[1] = to_byte(out.y);
+            pixel[2] = to_byte(out.z);
+            pixel[3] = to_byte(out_alpha);
+        }
+    }
+
+    return image;
+}
+
+} // namespace enfusion
@@ -0,0 +1,187 @@
+/**
+ * Enfusion Unpacker - Metrics Registry Implementation
+ */
+
+#include "enfusion/metrics.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <bit>
+#include <fstream>
+
+namespace enfusion {
+namespace metrics {
+
+// ============================================================================
+// Histogram
+// ============================================================================
+
+size_t Histogram::bucket_for(uint64_t value) {
+    // Small values get one bucket each
+    if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+
+    // Otherwise the top SUB_BITS below the leading one pick a bucket within its power of two
+    int msb = 63 - std::countl_zero(value);
+    int shift = msb - SUB_BITS;
+    size_t sub = static_cast<size_t>(value >> shift) & (SUB_BUCKETS - 1);
+    return static_cast<size_t>(shift + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t Histogram::bucket_midpoint(size_t bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+
+    int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+    uint64_t sub = bucket % SUB_BUCKETS;
+    uint64_t lower = (SUB_BUCKETS + sub) << shift;
+    return lower + ((uint64_t(1) << shift) >> 1);
+}
+
+void Histogram::record(uint64_t value) {
+    buckets_[bucket_for(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current = max_.load(std::memory_order_relaxed);
+    while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+double Histogram::mean() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(sum()) / static_cast<double>(n) : 0.0;
+}
+
+uint64_t Histogram::percentile(double fraction) const {
+    // Buckets are read without a lock, so total them here rather than trusting count_
+    std::array<uint64_t, BUCKETS> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(total));
+    if (rank >= total) rank = total - 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen > rank) return std::min(bucket_midpoint(i), max());
+    }
+    return max();
+}
+
+void Histogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+Registry& Registry::instance() {
+    static Registry instance;
+    return instance;
+}
+
+Counter& Registry::counter(std::string_view name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = counters_.find(name);
+    if (it == counters_.end()) {
+        it = counters_.emplace(std::string(name), std::make_unique<Counter>()).first;
+    }
+    return *it->second;
+}
+
+Histogram& Registry::histogram(std::string_view name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = histograms_.find(name);
+    if (it == histograms_.end()) {
+        it = histograms_.emplace(std::string(name), std::make_unique<Histogram>()).first;
+    }
+    return *it->second;
+}
+
+Snapshot Registry::snapshot() const {
+    Snapshot snap;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    snap.counters.reserve(counters_.size());
+    for (const auto& [name, counter] : counters_) {
+        snap.counters.push_back({name, counter->value()});
+    }
+
+    snap.histograms.reserve(histograms_.size());
+    for (const auto& [name, histogram] : histograms_) {
+        HistogramSummary summary;
+        summary.name = name;
+        summary.count = histogram->count();
+        summary.mean = histogram->mean();
+        summary.p50 = histogram->percentile(0.50);
+        summary.p90 = histogram->percentile(0.90);
+        summary.p99 = histogram->percentile(0.99);
+        summary.max = histogram->max();
+        snap.histograms.push_back(std::move(summary));
+    }
+
+    // Pair up "<name>.hits" with "<name>.misses"
+    constexpr std::string_view HITS = ".hits";
+    for (const auto& [name, counter] : counters_) {
+        if (!std::string_view(name).ends_with(HITS)) continue;
+        std::string base = name.substr(0, name.size() - HITS.size());
+        auto misses = counters_.find(base + ".misses");
+        if (misses == counters_.end()) continue;
+        snap.hit_rates.push_back({base, counter->value(), misses->second->value()});
+    }
+
+    return snap;
+}
+
+std::string Registry::to_json() const {
+    Snapshot snap = snapshot();
+
+    nlohmann::json j;
+    j["counters"] = nlohmann::json::object();
+    for (const auto& c : snap.counters) {
+        j["counters"][c.name] = c.value;
+    }
+
+    j["histograms"] = nlohmann::json::object();
+    for (const auto& h : snap.histograms) {
+        j["histograms"][h.name] = {
+            {"count", h.count},
+            {"mean_ns", h.mean},
+            {"p50_ns", h.p50},
+            {"p90_ns", h.p90},
+            {"p99_ns", h.p99},
+            {"max_ns", h.max},
+        };
+    }
+
+    j["hit_rates"] = nlohmann::json::object();
+    for (const auto& r : snap.hit_rates) {
+        j["hit_rates"][r.name] = {{"hits", r.hits}, {"misses", r.misses}, {"rate", r.rate()}};
+    }
+
+    return j.dump(2);
+}
+
+bool Registry::write_json(const std::filesystem::path& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) return false;
+    file << to_json() << "\n";
+    return static_cast<bool>(file);
+}
+
+void Registry::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [name, counter] : counters_) counter->reset();
+    for (auto& [name, histogram] : histograms_) histogram->reset();
+}
+
+} // namespace metrics
+} // namespace enfusion
@@ -0,0 +1,542 @@
+/**
+ * Enfusion Unpacker - Task Scheduler Implementation
+ */
+
+#include "enfusion/task_scheduler.hpp"
+#include "enfusion/logging.hpp"
+#include "enfusion/metrics.hpp"
+#include "enfusion/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+namespace enfusion {
+
+namespace detail {
+
+struct TaskNode {
+    enum State : uint8_t {
+        Waiting,  // On dependencies
+        Queued,
+        Running,
+        Done,
+    };
+
+    std::function<void()> fn;
+    TaskPriority priority = TaskPriority::Interactive;
+    bool main_thread = false;
+    const char* name = nullptr;
+    CancellationToken token;
+    std::chrono::steady_clock::time_point queued_at;
+
+    std::atomic<uint8_t> state{Waiting};
+    std::atomic<size_t> pending{1};  // Unfinished dependencies, plus one until submit() is done
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::shared_ptr<TaskNode>> dependents;  // Guarded by mutex
+};
+
+} // namespace detail
+
+using detail::TaskNode;
+
+namespace {
+
+thread_local int t_worker = -1;
+
+bool claim(TaskNode& node, uint8_t from) {
+    return node.state.compare_exchange_strong(from, TaskNode::Running, std::memory_order_acq_rel);
+}
+
+} // namespace
+
+const char* task_priority_name(TaskPriority priority) {
+    switch (priority) {
+        case TaskPriority::Interactive: return "interactive";
+        case TaskPriority::Prefetch:    return "prefetch";
+        case TaskPriority::Bulk:        return "bulk";
+    }
+    return "unknown";
+}
+
+// ============================================================================
+// TaskHandle
+// ============================================================================
+
+bool TaskHandle::done() const {
+    return !node_ || node_->state.load(std::memory_order_acquire) == TaskNode::Done;
+}
+
+void TaskHandle::wait() const {
+    if (node_) TaskScheduler::instance().wait(node_);
+}
+
+void TaskHandle::cancel() const {
+    if (node_) TaskScheduler::instance().cancel(node_);
+}
+
+CancellationToken TaskHandle::token() const {
+    return node_ ? node_->token : CancellationToken();
+}
+
+// ============================================================================
+// TaskScheduler
+// ============================================================================
+
+TaskScheduler& TaskScheduler::instance() {
+    static TaskScheduler instance;
+    return instance;
+}
+
+TaskScheduler::TaskScheduler() {
+    configure(0, 0);
+}
+
+TaskScheduler::~TaskScheduler() {
+    shutdown();
+}
+
+unsigned TaskScheduler::default_worker_count() {
+    // Leave a core for the UI thread
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 1;
+}
+
+void TaskScheduler::configure(unsigned workers, unsigned background) {
+    std::lock_guard<std::mutex> lock(configure_mutex_);
+    if (stopping_) return;
+
+    if (workers == 0) workers = default_worker_count();
+    workers = std::clamp(workers, 1u, MAX_WORKERS);
+
+    // By default one worker is always left for interactive work
+    if (background == 0) background = workers > 1 ? workers - 1 : 1;
+    background = std::min(background, workers);
+
+    background_limit_.store(background, std::memory_order_relaxed);
+    active_.store(workers, std::memory_order_release);
+
+    for (unsigned i = spawned_.load(std::memory_order_relaxed); i < workers; i++) {
+        workers_[i] = std::make_unique<Worker>();
+        workers_[i]->thread = std::thread(&TaskScheduler::worker_loop, this, i);
+        spawned_.store(i + 1, std::memory_order_release);
+    }
+
+    {
+        std::lock_guard<std::mutex> wake_lock(wake_mutex_);
+    }
+    wake_cv_.notify_all();
+    park_cv_.notify_all();
+
+    LOG_DEBUG("Scheduler", workers << " workers, " << background << " for background work");
+}
+
+size_t TaskScheduler::queued(TaskPriority priority) const {
+    return queued_[static_cast<size_t>(priority)].load(std::memory_order_relaxed);
+}
+
+TaskHandle TaskScheduler::submit(std::function<void()> fn, TaskOptions options) {
+    auto node = std::make_shared<TaskNode>();
+    node->fn = std::move(fn);
+    node->priority = options.priority;
+    node->main_thread = options.main_thread;
+    node->name = options.name;
+    node->token = std::move(options.token);
+
+    for (const auto& dependency : options.after) {
+        if (!dependency.node_) continue;
+        TaskNode& before = *dependency.node_;
+        std::lock_guard<std::mutex> lock(before.mutex);
+        if (before.state.load(std::memory_order_acquire) == TaskNode::Done) continue;
+        node->pending.fetch_add(1, std::memory_order_relaxed);
+        before.dependents.push_back(node);
+    }
+
+    if (node->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        enqueue(node);
+    }
+    return TaskHandle(std::move(node));
+}
+
+TaskHandle TaskScheduler::run_on_main(std::function<void()> fn, std::vector<TaskHandle> after,
+                                      CancellationToken token) {
+    TaskOptions options;
+    options.main_thread = true;
+    options.after = std::move(after);
+    options.token = std::move(token);
+    options.name = "main_thread_task";
+    return submit(std::move(fn), std::move(options));
+}
+
+void TaskScheduler::parallel(size_t width, const std::function<void()>& worker,
+                             TaskPriority priority, CancellationToken token) {
+    if (width == 0) width = worker_count();
+
+    std::vector<TaskHandle> helpers;
+    helpers.reserve(width > 0 ? width - 1 : 0);
+
+    // The helpers reference `worker`, so they must be done before it goes away
+    struct Join {
+        std::vector<TaskHandle>& helpers;
+        ~Join() {
+            for (const auto& helper : helpers) helper.wait();
+        }
+    } join{helpers};
+
+    for (size_t i = 1; i < width; i++) {
+        TaskOptions options;
+        options.priority = priority;
+        options.token = token;
+        options.name = "parallel";
+        helpers.push_back(submit([&worker]() { worker(); }, std::move(options)));
+    }
+    worker();
+}
+
+void TaskScheduler::parallel_for(size_t count, const std::function<void(size_t)>& body,
+                                 TaskPriority priority, CancellationToken token, size_t width) {
+    if (count == 0) return;
+    if (width == 0) width = worker_count();
+
+    std::atomic<size_t> cursor{0};
+    parallel(std::min(width, count), [&]() {
+        for (size_t i = cursor++; i < count && !token.cancelled(); i = cursor++) {
+            body(i);
+        }
+    }, priority, token);
+}
+
+size_t TaskScheduler::run_main_thread_tasks() {
+    std::vector<NodePtr> tasks;
+    {
+        std::lock_guard<std::mutex> lock(main_mutex_);
+        tasks.swap(main_queue_);
+    }
+
+    // Continuations queued from these run next frame
+    size_t ran = 0;
+    for (const auto& node : tasks) {
+        if (!claim(*node, TaskNode::Queued)) continue;
+        execute(node);
+        ran++;
+    }
+    return ran;
+}
+
+void TaskScheduler::set_main_thread_wakeup(std::function<void()> wakeup) {
+    std::lock_guard<std::mutex> lock(main_mutex_);
+    main_thread_ = std::this_thread::get_id();
+    main_wakeup_ = std::move(wakeup);
+}
+
+void TaskScheduler::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(configure_mutex_);
+        if (stopping_.exchange(true)) return;
+    }
+
+    {
+        std::lock_guard<std::mutex> wake_lock(wake_mutex_);
+    }
+    wake_cv_.notify_all();
+    park_cv_.notify_all();
+
+    unsigned spawned = spawned_.load(std::memory_order_acquire);
+    for (unsigned i = 0; i < spawned; i++) {
+        if (workers_[i]->thread.joinable()) workers_[i]->thread.join();
+    }
+
+    // Nothing will run what is still queued; release anyone waiting on it
+    std::vector<NodePtr> dropped;
+    for (unsigned i = 0; i < spawned; i++) {
+        std::lock_guard<std::mutex> lock(workers_[i]->mutex);
+        for (auto& queue : workers_[i]->queues) {
+            dropped.insert(dropped.end(), queue.begin(), queue.end());
+            queue.clear();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(injected_mutex_);
+        for (auto& queue : injected_) {
+            dropped.insert(dropped.end(), queue.begin(), queue.end());
+            queue.clear();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(main_mutex_);
+        dropped.insert(dropped.end(), main_queue_.begin(), main_queue_.end());
+        main_queue_.clear();
+        main_wakeup_ = nullptr;
+    }
+    for (const auto& node : dropped) {
+        cancel(node);
+    }
+}
+
+void TaskScheduler::worker_loop(unsigned index) {
+    t_worker = static_cast<int>(index);
+    trace::set_thread_name("Worker " + std::to_string(index + 1));
+
+    while (!stopping_.load(std::memory_order_acquire)) {
+        if (index >= active_.load(std::memory_order_acquire)) {
+            park_queued(index);
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            park_cv_.wait(lock, [&]() {
+                return stopping_.load() || index < active_.load();
+            });
+            continue;
+        }
+
+        bool background = false;
+        NodePtr node = find_task(index, background);
+        if (!node) {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait(lock, [&]() { return stopping_.load() || has_work(index); });
+            continue;
+        }
+
+        // Someone waiting on it may have run or cancelled it already
+        if (claim(*node, TaskNode::Queued)) {
+            execute(node);
+        }
+
+        if (background) {
+            background_running_.fetch_sub(1, std::memory_order_acq_rel);
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+            }
+            wake_cv_.notify_one();
+        }
+    }
+}
+
+TaskScheduler::NodePtr TaskScheduler::find_task(unsigned index, bool& background) {
+    for (size_t priority = 0; priority < TASK_PRIORITY_COUNT; priority++) {
+        if (queued_[priority].load(std::memory_order_acquire) == 0) continue;
+
+        // Reserve a background slot before taking the task
+        background = priority != static_cast<size_t>(TaskPriority::Interactive);
+        if (background) {
+            unsigned running = background_running_.fetch_add(1, std::memory_order_acq_rel);
+            if (running >= background_limit_.load(std::memory_order_relaxed)) {
+                background_running_.fetch_sub(1, std::memory_order_acq_rel);
+                continue;
+            }
+        }
+
+        NodePtr node = pop_own(index, priority);
+        if (!node) node = pop_injected(priority);
+        if (!node) node = steal(index, priority);
+        if (node) return node;
+
+        if (background) background_running_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    background = false;
+    return nullptr;
+}
+
+TaskScheduler::NodePtr TaskScheduler::pop_own(unsigned index, size_t priority) {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    auto& queue = worker.queues[priority];
+    if (queue.empty()) return nullptr;
+
+    // Newest first: its data is most likely still in cache
+    NodePtr node = std::move(queue.back());
+    queue.pop_back();
+    queued_[priority].fetch_sub(1, std::memory_order_acq_rel);
+    return node;
+}
+
+TaskScheduler::NodePtr TaskScheduler::pop_injected(size_t priority) {
+    std::lock_guard<std::mutex> lock(injected_mutex_);
+    auto& queue = injected_[priority];
+    if (queue.empty()) return nullptr;
+
+    NodePtr node = std::move(queue.front());
+    queue.pop_front();
+    queued_[priority].fetch_sub(1, std::memory_order_acq_rel);
+    return node;
+}
+
+TaskScheduler::NodePtr TaskScheduler::steal(unsigned index, size_t priority) {
+    static auto& steals = metrics::counter("scheduler.steals");
+
+    unsigned spawned = spawned_.load(std::memory_order_acquire);
+    for (unsigned offset = 1; offset < spawned; offset++) {
+        Worker& victim = *workers_[(index + offset) % spawned];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        auto& queue = victim.queues[priority];
+        if (queue.empty()) continue;
+
+        // Oldest first: the owner is working from the other end
+        NodePtr node = std::move(queue.front());
+        queue.pop_front();
+        queued_[priority].fetch_sub(1, std::memory_order_acq_rel);
+        steals.add();
+        return node;
+    }
+    return nullptr;
+}
+
+bool TaskScheduler::has_work(unsigned index) const {
+    if (index >= active_.load(std::memory_order_acquire)) return true;
+    if (queued_[static_cast<size_t>(TaskPriority::Interactive)].load(std::memory_order_acquire) > 0) return true;
+
+    size_t background = queued_[static_cast<size_t>(TaskPriority::Prefetch)].load(std::memory_order_acquire) +
+                        queued_[static_cast<size_t>(TaskPriority::Bulk)].load(std::memory_order_acquire);
+    return background > 0 &&
+           background_running_.load(std::memory_order_acquire) < background_limit_.load(std::memory_order_relaxed);
+}
+
+void TaskScheduler::park_queued(unsigned index) {
+    // A parked worker's queue would only be reachable by stealing; hand it back
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    std::lock_guard<std::mutex> injected_lock(injected_mutex_);
+    for (size_t priority = 0; priority < TASK_PRIORITY_COUNT; priority++) {
+        auto& queue = worker.queues[priority];
+        injected_[priority].insert(injected_[priority].end(), queue.begin(), queue.end());
+        queue.clear();
+    }
+}
+
+void TaskScheduler::enqueue(const NodePtr& node) {
+    // A task cancelled while waiting on its dependencies has already finished
+    uint8_t expected = TaskNode::Waiting;
+    if (!node->state.compare_exchange_strong(expected, TaskNode::Queued, std::memory_order_acq_rel)) return;
+    node->queued_at = std::chrono::steady_clock::now();
+
+    // Waiters may be able to run it themselves now
+    {
+        std::lock_guard<std::mutex> lock(node->mutex);
+    }
+    node->changed.notify_all();
+
+    if (stopping_.load(std::memory_order_acquire)) {
+        cancel(node);
+        return;
+    }
+
+    if (node->main_thread) {
+        {
+            std::lock_guard<std::mutex> lock(main_mutex_);
+            main_queue_.push_back(node);
+        }
+        wake_main_thread();
+        return;
+    }
+
+    size_t priority = static_cast<size_t>(node->priority);
+    int index = t_worker;
+    if (index >= 0 && static_cast<unsigned>(index) < active_.load(std::memory_order_acquire)) {
+        Worker& worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        queued_[priority].fetch_add(1, std::memory_order_acq_rel);
+        worker.queues[priority].push_back(node);
+    } else {
+        std::lock_guard<std::mutex> lock(injected_mutex_);
+        queued_[priority].fetch_add(1, std::memory_order_acq_rel);
+        injected_[priority].push_back(node);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_cv_.notify_one();
+}
+
+void TaskScheduler::execute(const NodePtr& node) {
+    static auto& tasks = metrics::counter("scheduler.tasks");
+    static std::array<metrics::Histogram*, TASK_PRIORITY_COUNT> queue_wait = {
+        &metrics::histogram("scheduler.queue_wait.interactive"),
+        &metrics::histogram("scheduler.queue_wait.prefetch"),
+        &metrics::histogram("scheduler.queue_wait.bulk"),
+    };
+
+    running_.fetch_add(1, std::memory_order_relaxed);
+    if (!node->token.cancelled()) {
+        tasks.add();
+        if (!node->main_thread) {
+            auto waited = std::chrono::steady_clock::now() - node->queued_at;
+            queue_wait[static_cast<size_t>(node->priority)]->record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count()));
+        }
+
+        TRACE_SPAN(span, node->name ? node->name : "task");
+        TRACE_ARG(span, "priority", task_priority_name(node->priority));
+        try {
+            node->fn();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Scheduler", "Task " << (node->name ? node->name : "task") << " failed: " << e.what());
+        } catch (...) {
+            LOG_ERROR("Scheduler", "Task " << (node->name ? node->name : "task") << " failed");
+        }
+    }
+    // Captures are released here rather than whenever the last handle goes
+    node->fn = nullptr;
+    running_.fetch_sub(1, std::memory_order_relaxed);
+
+    finish(node);
+}
+
+void TaskScheduler::finish(const NodePtr& node) {
+    std::vector<NodePtr> dependents;
+    {
+        std::lock_guard<std::mutex> lock(node->mutex);
+        node->state.store(TaskNode::Done, std::memory_order_release);
+        dependents.swap(node->dependents);
+    }
+    node->changed.notify_all();
+
+    for (const auto& dependent : dependents) {
+        if (dependent->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            enqueue(dependent);
+        }
+    }
+}
+
+void TaskScheduler::wait(const NodePtr& node) {
+    // UI-thread tasks only ever run on the UI thread
+    bool run_here = !node->main_thread || std::this_thread::get_id() == main_thread_;
+
+    for (;;) {
+        uint8_t state = node->state.load(std::memory_order_acquire);
+        if (state == TaskNode::Done) return;
+
+        // Not picked up yet: run it here rather than wait for a worker
+        if (state == TaskNode::Queued && run_here && claim(*node, TaskNode::Queued)) {
+            execute(node);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(node->mutex);
+        node->changed.wait(lock, [&]() {
+            uint8_t current = node->state.load(std::memory_order_acquire);
+            return current == TaskNode::Done || (run_here && current == TaskNode::Queued);
+        });
+    }
+}
+
+void TaskScheduler::cancel(const NodePtr& node) {
+    node->token.cancel();
+
+    // Not started: finish it without running, releasing its dependents
+    if (claim(*node, TaskNode::Queued) || claim(*node, TaskNode::Waiting)) {
+        node->fn = nullptr;
+        finish(node);
+    }
+}
+
+void TaskScheduler::wake_main_thread() {
+    std::function<void()> wakeup;
+    {
+        std::lock_guard<std::mutex> lock(main_mutex_);
+        wakeup = main_wakeup_;
+    }
+    if (wakeup) wakeup();
+}
+
+} // namespace enfusion
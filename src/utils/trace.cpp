@@ -0,0 +1,312 @@
+/**
+ * Enfusion Unpacker - Span Tracing Implementation
+ */
+
+#include "enfusion/trace.hpp"
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace enfusion {
+namespace trace {
+
+namespace detail {
+std::atomic<bool> g_enabled{false};
+std::atomic<uint32_t> g_session{0};
+} // namespace detail
+
+namespace {
+
+// A runaway loop shouldn't eat all memory; beyond this spans are counted
+constexpr size_t MAX_EVENTS_PER_THREAD = size_t(1) << 18;
+
+struct Event {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    std::string args;
+};
+
+struct ThreadBuffer {
+    std::mutex mutex;  // Only contended while a trace is being written
+    std::vector<Event> events;
+    uint32_t tid = 0;
+    std::string name;
+};
+
+struct State {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    uint32_t next_tid = 1;
+    uint64_t origin_ns = 0;
+    std::atomic<uint64_t> dropped{0};
+
+    bool capture_armed = false;
+    bool capture_active = false;
+    std::filesystem::path capture_path;
+};
+
+State& state() {
+    static State instance;
+    return instance;
+}
+
+std::shared_ptr<ThreadBuffer> register_thread() {
+    auto buffer = std::make_shared<ThreadBuffer>();
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    buffer->tid = s.next_tid++;
+    buffer->name = "Thread " + std::to_string(buffer->tid);
+    s.buffers.push_back(buffer);
+    return buffer;
+}
+
+ThreadBuffer& local_buffer() {
+    // The registry keeps a reference too, so spans from threads that have
+    // since exited survive until the trace is written
+    thread_local std::shared_ptr<ThreadBuffer> buffer = register_thread();
+    return *buffer;
+}
+
+void append_escaped(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                    out += buffer;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+void append_micros(std::string& out, uint64_t ns) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", static_cast<double>(ns) / 1000.0);
+    out += buffer;
+}
+
+// Callers hold state().mutex
+void start_locked(State& s) {
+    detail::g_enabled.store(false, std::memory_order_relaxed);
+    detail::g_session.fetch_add(1, std::memory_order_relaxed);
+
+    // Buffers only referenced by the registry belong to threads that have exited
+    std::erase_if(s.buffers, [](const auto& buffer) { return buffer.use_count() == 1; });
+    for (auto& buffer : s.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        buffer->events.clear();
+    }
+
+    s.dropped.store(0, std::memory_order_relaxed);
+    s.origin_ns = detail::now_ns();
+    detail::g_enabled.store(true, std::memory_order_release);
+}
+
+bool write_json_locked(State& s, const std::filesystem::path& path) {
+    std::string out;
+    out.reserve(1 << 16);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    auto separator = [&]() {
+        if (!first) out += ",\n";
+        first = false;
+    };
+
+    for (auto& buffer : s.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+
+        separator();
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+        out += std::to_string(buffer->tid);
+        out += ",\"args\":{\"name\":";
+        append_escaped(out, buffer->name);
+        out += "}}";
+
+        for (const auto& event : buffer->events) {
+            separator();
+            out += "{\"name\":";
+            append_escaped(out, event.name);
+            out += ",\"cat\":\"enfusion\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+            out += std::to_string(buffer->tid);
+            out += ",\"ts\":";
+            append_micros(out, event.start_ns >= s.origin_ns ? event.start_ns - s.origin_ns : 0);
+            out += ",\"dur\":";
+            append_micros(out, event.duration_ns);
+            if (!event.args.empty()) {
+                out += ",\"args\":{";
+                out += event.args;
+                out += '}';
+            }
+            out += '}';
+        }
+    }
+
+    out += "\n]}\n";
+
+    if (path.has_parent_path()) {
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    return static_cast<bool>(file);
+}
+
+} // namespace
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+namespace detail {
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void record(const char* name, uint32_t session, uint64_t start_ns, uint64_t end_ns, std::string&& args) {
+    // Spans still open when a new session started belong to the old one
+    if (!g_enabled.load(std::memory_order_relaxed) || session != g_session.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    ThreadBuffer& buffer = local_buffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= MAX_EVENTS_PER_THREAD) {
+        state().dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events.push_back({name, start_ns, end_ns - start_ns, std::move(args)});
+}
+
+void append_arg(std::string& args, std::string_view key, std::string_view value) {
+    if (!args.empty()) args += ',';
+    append_escaped(args, key);
+    args += ':';
+    append_escaped(args, value);
+}
+
+void append_arg(std::string& args, std::string_view key, uint64_t value) {
+    if (!args.empty()) args += ',';
+    append_escaped(args, key);
+    args += ':';
+    args += std::to_string(value);
+}
+
+void append_arg(std::string& args, std::string_view key, double value) {
+    if (!args.empty()) args += ',';
+    append_escaped(args, key);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), ":%g", value);
+    args += buffer;
+}
+
+} // namespace detail
+
+// ============================================================================
+// Sessions
+// ============================================================================
+
+void start() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    start_locked(s);
+}
+
+void stop() {
+    detail::g_enabled.store(false, std::memory_order_release);
+}
+
+bool write_json(const std::filesystem::path& path) {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return write_json_locked(s, path);
+}
+
+size_t event_count() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    size_t total = 0;
+    for (auto& buffer : s.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        total += buffer->events.size();
+    }
+    return total;
+}
+
+uint64_t dropped() {
+    return state().dropped.load(std::memory_order_relaxed);
+}
+
+void set_thread_name(std::string name) {
+    ThreadBuffer& buffer = local_buffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = std::move(name);
+}
+
+// ============================================================================
+// Single-operation capture
+// ============================================================================
+
+void arm_capture(const std::filesystem::path& path) {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.capture_armed = true;
+    s.capture_path = path;
+}
+
+bool capture_armed() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.capture_armed;
+}
+
+bool begin_capture() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    // A trace started by hand keeps running; the capture waits for the next operation
+    if (!s.capture_armed || s.capture_active || enabled()) return false;
+
+    s.capture_armed = false;
+    s.capture_active = true;
+    start_locked(s);
+    return true;
+}
+
+bool end_capture() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.capture_active) return false;
+
+    s.capture_active = false;
+    detail::g_enabled.store(false, std::memory_order_release);
+    return write_json_locked(s, s.capture_path);
+}
+
+std::filesystem::path capture_path() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.capture_path;
+}
+
+} // namespace trace
+} // namespace enfusion